@@ -5,14 +5,21 @@ Niema Moshiri 2022
 '''
 
 # imports
+from array import array
 from datetime import datetime
 from json import dump as jdump
 from os import chdir, getcwd, makedirs
 from os.path import abspath, expanduser, isdir, isfile
 import argparse
+import gzip
+import io
 import random
 import subprocess
 import sys
+try:
+    import gemf # in-process engine, built with setup.py
+except ImportError:
+    gemf = None
 
 # useful variables
 VERSION = '1.0.4'
@@ -23,6 +30,7 @@ DEFAULT_FN_GEMF_LOG = 'log.txt'
 DEFAULT_FN_GEMF_NETWORK = 'network.txt'
 DEFAULT_FN_GEMF_NODE2NUM = 'node2num.txt'
 DEFAULT_FN_GEMF_OUT = 'output.txt'
+GEMF_OUT_EXT = {'none': '', 'gzip': '.gz', 'zstd': '.zst'}
 DEFAULT_FN_GEMF_PARA = 'para.txt'
 DEFAULT_FN_GEMF_STATE2NUM = 'state2num.txt'
 DEFAULT_FN_GEMF_STATUS = 'status.txt'
@@ -72,9 +80,11 @@ def parse_args():
     parser.add_argument('-o', '--output', required=True, type=str, help="Output Directory")
     parser.add_argument('--max_events', required=False, type=int, default=C_UINT_MAX, help="Max Number of Events")
     parser.add_argument('--output_all_transitions', action="store_true", help="Output All Transition Events (slower)")
+    parser.add_argument('--compress_gemf_output', required=False, type=str, default='none', choices=sorted(GEMF_OUT_EXT.keys()), help="Compression of GEMF Output File")
     parser.add_argument('--quiet', action="store_true", help="Suppress log messages")
     parser.add_argument('--rng_seed', required=False, type=int, default=None, help="Random Number Generation Seed")
     parser.add_argument('--gemf_path', required=False, type=str, default=DEFAULT_GEMF_PATH, help="Path to GEMF Executable")
+    parser.add_argument('--gemf_executable', action="store_true", help="Run the GEMF Executable even if the gemf Python Module is available")
     args = parser.parse_args()
 
     # convert local paths to absolute
@@ -173,8 +183,13 @@ def create_gemf_network(contact_network_fn, network_f, node2num_f):
         `dict`: A mapping from node label to node number
 
         `list`: A mapping from node number to node label
+
+        `array`: Source node of each GEMF edge, numbered from 0
+
+        `array`: Target node of each GEMF edge, numbered from 0
     '''
     node2num = dict(); num2node = [None] # None is dummy (GEMF starts node numbers at 1)
+    src = array('I'); dst = array('I')
     for l in open(contact_network_fn):
         # skip empty and header lines
         if len(l) == 0 or l[0] == '#' or l[0] == '\n':
@@ -200,9 +215,9 @@ def create_gemf_network(contact_network_fn, network_f, node2num_f):
                 v_num = node2num[v]
             except KeyError:
                 raise ValueError("Node found in EDGE section but not in NODE section: %s" % v)
-            network_f.write('%d\t%d\n' % (u_num, v_num))
+            network_f.write('%d\t%d\n' % (u_num, v_num)); src.append(u_num-1); dst.append(v_num-1)
             if d_or_u == 'u':
-                network_f.write('%d\t%d\n' % (v_num, u_num))
+                network_f.write('%d\t%d\n' % (v_num, u_num)); src.append(v_num-1); dst.append(u_num-1)
 
         # non-comment and non-empty lines must start with NODE or EDGE
         else:
@@ -210,7 +225,7 @@ def create_gemf_network(contact_network_fn, network_f, node2num_f):
 
     # finish up and return
     jdump(node2num, node2num_f); node2num_f.close(); network_f.close()
-    return node2num, num2node
+    return node2num, num2node, src, dst
 
 def create_gemf_status(initial_states_fn, status_f, node2num):
     '''
@@ -227,8 +242,10 @@ def create_gemf_status(initial_states_fn, status_f, node2num):
         `dict`: A mapping from state label to state number
 
         `list`: A mapping from state number to state label
+
+        `array`: Initial state number of each line of the GEMF status file
     '''
-    state2num = dict(); num2state = list()
+    state2num = dict(); num2state = list(); states = array('I')
     for l in open(initial_states_fn):
         # skip empty and header lines
         if len(l) == 0 or l[0] == '#' or l[0] == '\n':
@@ -242,11 +259,11 @@ def create_gemf_status(initial_states_fn, status_f, node2num):
             s_num = state2num[s]
         except KeyError:
             s_num = len(num2state); state2num[s] = s_num; num2state.append(s)
-        status_f.write('%d\n' % s_num)
+        status_f.write('%d\n' % s_num); states.append(s_num)
 
     # finish up and return
     status_f.close()
-    return state2num, num2state
+    return state2num, num2state, states
 
 def create_gemf_para(rates_fn, end_time, max_events, network_fn, status_fn, out_fn, para_f, state2num_f, state2num, num2state, rng_seed=None):
     '''
@@ -342,8 +359,8 @@ def create_gemf_para(rates_fn, end_time, max_events, network_fn, status_fn, out_
     para_f.write("[MAX_TIME]\n%s\n\n" % end_time)
     para_f.write("[MAX_EVENTS]\n%d\n\n" % max_events)
     para_f.write("[DIRECTED]\n1\n\n")
-    para_f.write("[SHOW_INDUCER]\n1\n\n")
-    para_f.write("[DATA_FILE]\n%s\n\n" % '\n'.join([network_fn.split('/')[-1]]*len(INDUCERS)))
+    para_f.write("[SHOW_INFECTOR]\n1\n\n")
+    para_f.write("[DATA_FILE]\n%s\n\n" % network_fn.split('/')[-1]) # one network shared by the layers of all inducers
     para_f.write("[STATUS_FILE]\n%s\n\n" % status_fn.split('/')[-1])
     if rng_seed is not None:
         para_f.write("[RANDOM_SEED]\n%d\n\n" % rng_seed)
@@ -364,26 +381,114 @@ def run_gemf(outdir, log_fn, gemf_path=DEFAULT_GEMF_PATH):
     chdir(orig_dir)
     return log_f
 
-def convert_transmissions_to_favites(infected_states_fn, status_fn, out_fn, transition_f, transmission_f, num2node, node2num, num2state, state2num, RATE, INDUCERS):
+def simulate_gemf(infected_states_fn, end_time, max_events, src, dst, states, transition_f, transmission_f, num2node, num2state, state2num, RATE, INDUCERS, rng_seed=None):
     '''
-    Convert GEMF transmission network to FAVITES format
+    Run GEMF in process with the gemf Python module and write the FAVITES output directly
 
     Args:
         `infected_states_fn` (`str`): Path to infected states file
 
-        `status_fn` (`str`): Path to GEMF status file
+        `end_time` (`float`): Simulation end time
 
-        `out_fn` (`str`): Path to GEMF output file
+        `max_events` (`int`): Max number of transition events
+
+        `src` (`array`): Source node of each GEMF edge, numbered from 0
+
+        `dst` (`array`): Target node of each GEMF edge, numbered from 0
+
+        `states` (`array`): Initial state number of each node, numbered from 0
 
         `transition_f` (`file`): Write-mode file object to "all simulation state transitions" file
 
         `transmission_f` (`file`): Write-mode file object to output FAVITES-format transmission network
 
-        `state2num` (`dict`): A mapping from state label to state number
-
         `RATE` (`dict`): Transition rates, where `RATE[x][y][z]` denotes the rate of the transition from `y` to `z` caused by `x` (state numbers, not labels)
 
         `INDUCERS` (`list`): Sorted list of inducer state numbers
+
+        `rng_seed` (`int`): Seed for random number generation
+    '''
+    # load and check infected states
+    infected_states = {l.strip() for l in open(infected_states_fn)}
+    for s in infected_states:
+        if s not in state2num:
+            raise ValueError("Encountered state in infectious states file that didn't appear in rates or initial states files: %s" % s)
+    infected_states = {state2num[s] for s in infected_states}
+
+    # flat rate matrices: nodal[i*M+j], edge[(layer*M+i)*M+j], one layer per inducer state
+    M = len(num2state); nodal = array('d', [0.]*(M*M)); edge = array('d', [0.]*(len(INDUCERS)*M*M))
+    for s_from, row in RATE.get(None, dict()).items():
+        for s_to, r in row.items():
+            nodal[s_from*M + s_to] = r
+    for layer, s_by in enumerate(INDUCERS):
+        for s_from, row in RATE[s_by].items():
+            for s_to, r in row.items():
+                edge[(layer*M + s_from)*M + s_to] = r
+
+    # write seeds to output FAVITES file
+    for u_num, s_num in enumerate(states):
+        u = num2node[u_num+1]
+        if s_num in infected_states:
+            transmission_f.write("None\t%s\t0\n" % u)
+        if transition_f is not None:
+            transition_f.write("%s\tNone\t%s\t0\n" % (u, num2state[s_num]))
+
+    # simulate, the infector of each event is sampled by the engine
+    if rng_seed is None:
+        rng_seed = random.getrandbits(64)
+    T, NODE, FROM, TO, INFECTOR = gemf.simulate(M, nodal, edge, INDUCERS, src, dst, states, max_time=end_time, max_events=max_events, seed=rng_seed)
+    for t, v_num, from_s_num, to_s_num, u_num in zip(T, NODE, FROM, TO, INFECTOR):
+        v = num2node[v_num+1]
+        if transition_f is not None:
+            transition_f.write('%s\t%s\t%s\t%s\n' % (v, num2state[from_s_num], num2state[to_s_num], t))
+        if from_s_num in infected_states or to_s_num not in infected_states:
+            continue # only write inducer to transmission file if v went to infected state
+        if u_num < 0:
+            transmission_f.write("None\t%s\t%s\n" % (v, t))
+        else:
+            transmission_f.write("%s\t%s\t%s\n" % (num2node[u_num+1], v, t))
+
+    # finish up
+    transmission_f.close()
+    if transition_f is not None:
+        transition_f.close()
+
+def open_gemf_output(out_fn):
+    '''
+    Open GEMF output file for reading, decompressing it on the fly if it ends with `.gz` or `.zst`
+
+    Args:
+        `out_fn` (`str`): Path to GEMF output file
+
+    Returns:
+        `file`: Text-mode file object
+    '''
+    if out_fn.endswith('.gz'):
+        return gzip.open(out_fn, 'rt')
+    if out_fn.endswith('.zst'):
+        try:
+            import zstandard
+            return io.TextIOWrapper(zstandard.ZstdDecompressor().stream_reader(open(out_fn, 'rb')))
+        except ImportError:
+            return subprocess.Popen(['zstd', '-dc', out_fn], stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return open(out_fn)
+
+def convert_transmissions_to_favites(infected_states_fn, status_fn, out_fn, transition_f, transmission_f, num2node, node2num, num2state, state2num):
+    '''
+    Convert GEMF transmission network to FAVITES format
+
+    Args:
+        `infected_states_fn` (`str`): Path to infected states file
+
+        `status_fn` (`str`): Path to GEMF status file
+
+        `out_fn` (`str`): Path to GEMF output file, optionally `.gz` or `.zst` compressed
+
+        `transition_f` (`file`): Write-mode file object to "all simulation state transitions" file
+
+        `transmission_f` (`file`): Write-mode file object to output FAVITES-format transmission network
+
+        `state2num` (`dict`): A mapping from state label to state number
     '''
     # load and check infected states
     infected_states = {l.strip() for l in open(infected_states_fn)}
@@ -401,8 +506,7 @@ def convert_transmissions_to_favites(infected_states_fn, status_fn, out_fn, tran
             transition_f.write("%s\tNone\t%s\t0\n" % (u, num2state[s_num]))
 
     # convert GEMF output to FAVITES format
-    INDUCER_STATES = [None] + INDUCERS
-    for l in open(out_fn):
+    for l in open_gemf_output(out_fn):
         # parse easy components
         parts = l.split(' ')
         t = float(parts[0])        # time of current transition event
@@ -418,40 +522,18 @@ def convert_transmissions_to_favites(infected_states_fn, status_fn, out_fn, tran
         if from_s_num in infected_states or to_s_num not in infected_states:
             continue # only write inducer to transmission file if v went to infected state
 
-        # parse inducer lists: inducers[0] = nodal transition, inducers[1] = first inducer state, inducers[2] = second inducer state, etc.
-        inducers = [[int(tmp) for tmp in inds.split(',') if len(tmp) != 0] for inds in parts[-1].rstrip().lstrip('[').rstrip(']').split('],[')]
-        inducer_state_rates = [(RATE[INDUCER_STATES[i]][from_s_num][to_s_num] * len(u_nums), i) for i, u_nums in enumerate(inducers) if len(u_nums) != 0]
-        by_s_inducer_ind = roll_die(inducer_state_rates)[1]
-        by_s_num = INDUCER_STATES[by_s_inducer_ind]
-        if INDUCER_STATES[by_s_inducer_ind] is None:
-            transmission_f.write("None\t%s\t%s\n" % (num2node[v_num], t))
+        # infector sampled by GEMF ([SHOW_INFECTOR]), -1 for a nodal transition
+        u_num = int(parts[-1])
+        if u_num < 0:
+            transmission_f.write("None\t%s\t%s\n" % (v, t))
         else:
-            u = num2node[random.choice(inducers[by_s_inducer_ind])]
-            transmission_f.write("%s\t%s\t%s\n" % (u, v, t))
+            transmission_f.write("%s\t%s\t%s\n" % (num2node[u_num], v, t))
 
     # finish up
     transmission_f.close()
     if transition_f is not None:
         transition_f.close()
 
-def roll_die(faces):
-    '''
-    Roll a multi-faced die
-
-    Args:
-        `faces` (`list`): Die faces as `(prob, label)` `tuple`s
-
-    Returns:
-        `tuple`: The `(prob, label)` die face that succeeded
-    '''
-    face_tot = sum(p for p, s in faces)
-    faces = [(p/face_tot,s) for p, s in faces]
-    x = random.random(); tot = 0.
-    for face in faces:
-        if x <= face[0]:
-            return face
-    return faces[-1]
-
 def main():
     '''
     Main function
@@ -465,19 +547,24 @@ def main():
     para_f, network_f, node2num_f, status_f, state2num_f, transition_f, transmission_f = prepare_outdir(args.output, output_transitions=args.output_all_transitions)
     if not args.quiet:
         print_log("Creating GEMF network file...")
-    node2num, num2node = create_gemf_network(args.contact_network, network_f, node2num_f) # closes network_f and node2num_f
+    node2num, num2node, src, dst = create_gemf_network(args.contact_network, network_f, node2num_f) # closes network_f and node2num_f
     if not args.quiet:
         print_log("Creating GEMF status file...")
-    state2num, num2state = create_gemf_status(args.initial_states, status_f, node2num) # closes status_f
+    state2num, num2state, states = create_gemf_status(args.initial_states, status_f, node2num) # closes status_f
     if not args.quiet:
         print_log("Creating GEMF parameter file...")
-    RATE, INDUCERS = create_gemf_para(args.rates, args.end_time, args.max_events, network_f.name, status_f.name, DEFAULT_FN_GEMF_OUT, para_f, state2num_f, state2num, num2state, args.rng_seed) # closes para_f and state2num_f
+    RATE, INDUCERS = create_gemf_para(args.rates, args.end_time, args.max_events, network_f.name, status_f.name, DEFAULT_FN_GEMF_OUT + GEMF_OUT_EXT[args.compress_gemf_output], para_f, state2num_f, state2num, num2state, args.rng_seed) # closes para_f and state2num_f
+    if gemf is not None and not args.gemf_executable and len(INDUCERS) != 0:
+        if not args.quiet:
+            print_log("Running GEMF in process...")
+        simulate_gemf(args.infected_states, args.end_time, args.max_events, src, dst, states, transition_f, transmission_f, num2node, num2state, state2num, RATE, INDUCERS, args.rng_seed) # closes transition_f and transmission_f
+        return
     if not args.quiet:
         print_log("Running GEMF...")
     log_f = run_gemf(args.output, DEFAULT_FN_GEMF_LOG, args.gemf_path) # closes log_f
     if not args.quiet:
         print_log("Converting GEMF output to FAVITES format...")
-    convert_transmissions_to_favites(args.infected_states, status_f.name, '%s/%s' % (args.output, DEFAULT_FN_GEMF_OUT), transition_f, transmission_f, num2node, node2num, num2state, state2num, RATE, INDUCERS) # closes transition_f and transmission_f
+    convert_transmissions_to_favites(args.infected_states, status_f.name, '%s/%s%s' % (args.output, DEFAULT_FN_GEMF_OUT, GEMF_OUT_EXT[args.compress_gemf_output]), transition_f, transmission_f, num2node, node2num, num2state, state2num) # closes transition_f and transmission_f
 
 # execute main function
 if __name__ == "__main__":
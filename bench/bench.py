@@ -0,0 +1,128 @@
+#! /usr/bin/env python3
+'''
+GEMF benchmark suite on synthetic networks (see gen_net.c): Erdos-Renyi, Barabasi-Albert,
+2D lattice and configuration model networks, each with SIR, SEIR and SIS models.
+Runs GEMF with a [REPORT_FILE] and appends one CSV row per run, with the seconds spent
+loading the network, preprocessing, in the event loop and flushing the output, so
+events/sec and startup time can be tracked across commits. Run through "make bench".
+'''
+
+# imports
+from os import makedirs
+from os.path import abspath, dirname, isfile
+from subprocess import check_call, check_output, DEVNULL
+from tempfile import mkdtemp
+from datetime import datetime
+import argparse
+import json
+
+# useful variables
+ROOT = abspath('%s/..' % dirname(abspath(__file__)))
+GEN_NET = '%s/bench/gen_net' % ROOT
+NETWORKS = ['er', 'ba', 'lattice', 'config']
+# generator parameter: mean degree, edges per new node, unused, degree exponent
+PARAMS = {'er':'6', 'ba':'3', 'lattice':'0', 'config':'2.5'}
+
+# models: compartments, nodal rates {(from,to):rate}, edge based rates, inducer, initially infected state
+MODELS = {
+    'sir':  (3, {(1,2):1.0}, {(0,1):0.5}, 1, 1),
+    'seir': (4, {(1,2):1.0, (2,3):1.0}, {(0,1):0.5}, 2, 2),
+    'sis':  (2, {(1,0):1.0}, {(0,1):0.5}, 1, 1),
+}
+
+FIELDS = ['commit', 'date', 'network', 'nodes', 'edges', 'model', 'events', 'events_per_second',
+          'load', 'preprocess', 'loop', 'output', 'startup', 'peak_rss_kb', 'bytes_written']
+
+def matrix(M, rates):
+    '''
+    Rate matrix of the para file, M by M
+    '''
+    return '\n'.join('\t'.join(str(rates.get((i,j), 0)) for j in range(M)) for i in range(M))
+
+def write_para(fn, model, network_fn, nodes, edges, status_fn, out_fn, report_fn, max_events, seed):
+    '''
+    Write a GEMF para file, [NETWORK_INFO] given so the network is read only once
+    '''
+    M, nodal, edged, inducer, _ = MODELS[model]
+    with open(fn, 'w') as f:
+        f.write('[NODAL_TRAN_MATRIX]\n%s\n\n' % matrix(M, nodal))
+        f.write('[EDGED_TRAN_MATRIX]\n%s\n\n' % matrix(M, edged))
+        f.write('[STATUS_BEGIN]\n0\n\n[INDUCER_LIST]\n%d\n\n' % inducer)
+        f.write('[SIM_ROUNDS]\n1\n\n[INTERVAL_NUM]\n1\n\n[MAX_TIME]\n1e9\n\n[MAX_EVENTS]\n%d\n\n' % max_events)
+        f.write('[DIRECTED]\n0\n\n[SHOW_INDUCER]\n0\n\n')
+        f.write('[DATA_FILE]\n%s\n\n[NETWORK_INFO]\n0\n1 %d\n%d\n\n' % (network_fn, nodes, edges))
+        f.write('[STATUS_FILE]\n%s\n\n[RANDOM_SEED]\n%d\n\n' % (status_fn, seed))
+        f.write('[OUT_FILE]\n%s\n\n[REPORT_FILE]\n%s\n' % (out_fn, report_fn))
+
+def git_commit():
+    '''
+    Short hash of HEAD, with "+" if the working tree has changes
+    '''
+    try:
+        commit = check_output(['git', '-C', ROOT, 'rev-parse', '--short', 'HEAD']).decode().strip()
+        if check_output(['git', '-C', ROOT, 'status', '--porcelain', '-uno']).strip():
+            commit += '+'
+        return commit
+    except Exception:
+        return 'unknown'
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('-n', '--networks', required=False, nargs='+', choices=NETWORKS, default=NETWORKS, help="Networks")
+    parser.add_argument('-m', '--models', required=False, nargs='+', choices=sorted(MODELS), default=['sir', 'seir', 'sis'], help="Models")
+    parser.add_argument('-s', '--scales', required=False, nargs='+', type=float, default=[1e4, 1e5], help="Numbers of Nodes (up to 1e8)")
+    parser.add_argument('-e', '--events_per_node', required=False, type=float, default=3, help="Event Limit per Node")
+    parser.add_argument('-f', '--infected', required=False, type=float, default=0.001, help="Initially Infected Fraction")
+    parser.add_argument('-r', '--repeat', required=False, type=int, default=1, help="Runs per Case, Fastest Kept")
+    parser.add_argument('-o', '--output', required=False, type=str, default='bench_results.csv', help="Results CSV (Appended)")
+    parser.add_argument('-w', '--work', required=False, type=str, default=None, help="Directory of Generated Networks (Kept for Reuse)")
+    parser.add_argument('--gemf_path', required=False, type=str, default='%s/GEMF' % ROOT, help="Path to GEMF Executable")
+    parser.add_argument('--seed', required=False, type=int, default=1, help="Random Number Generation Seed")
+    args = parser.parse_args()
+    work = args.work or mkdtemp()
+    makedirs(work, exist_ok=True)
+    commit = git_commit(); date = datetime.now().isoformat(timespec='seconds')
+    new_file = not isfile(args.output)
+    out = open(args.output, 'a')
+    if new_file:
+        out.write(','.join(FIELDS) + '\n')
+    print('\t'.join(['network', 'nodes', 'model', 'events', 'events/sec', 'load', 'preprocess', 'loop', 'output']))
+    for network in args.networks:
+        for scale in args.scales:
+            # generate the network once, its size is kept next to it
+            network_fn = '%s/%s_%d_%d.txt' % (work, network, int(scale), args.seed)
+            info_fn = network_fn + '.info'
+            if not isfile(info_fn):
+                info = check_output([GEN_NET, network, str(int(scale)), network_fn, PARAMS[network], str(args.seed)]).decode()
+                open(info_fn, 'w').write(info)
+            parts = open(info_fn).read().split()
+            nodes, edges = int(parts[1]), int(parts[3])
+            for model in args.models:
+                status_fn = '%s/%s_%d_%d_%s_status.txt' % (work, network, int(scale), args.seed, model)
+                if not isfile(status_fn):
+                    check_call([GEN_NET, 'status', str(nodes), str(args.infected), str(MODELS[model][4]), status_fn, str(args.seed)])
+                best = None
+                for i in range(args.repeat):
+                    para_fn = '%s/para.txt' % work; report_fn = '%s/report.json' % work
+                    write_para(para_fn, model, network_fn, nodes, edges, status_fn, '%s/output.txt' % work, report_fn,
+                               int(args.events_per_node * nodes), args.seed)
+                    check_call([args.gemf_path, para_fn], stdout=DEVNULL)
+                    rep = json.load(open(report_fn))
+                    if best is None or rep['phases']['loop'] < best['phases']['loop']:
+                        best = rep
+                ph = best['phases']
+                row = {
+                    'commit': commit, 'date': date, 'network': network, 'nodes': nodes, 'edges': edges, 'model': model,
+                    'events': best['events'], 'events_per_second': '%.0f' % best['events_per_second'],
+                    'load': '%.6f' % ph['parse'], 'preprocess': '%.6f' % (ph['build'] + ph['init_inducer'] + ph['get_rat_lst']),
+                    'loop': '%.6f' % ph['loop'], 'output': '%.6f' % ph['output'],
+                    'startup': '%.6f' % (ph['parse'] + ph['build'] + ph['init_inducer'] + ph['get_rat_lst']),
+                    'peak_rss_kb': best['peak_rss_kb'], 'bytes_written': best['bytes_written'],
+                }
+                out.write(','.join(str(row[k]) for k in FIELDS) + '\n'); out.flush()
+                print('\t'.join(str(row[k]) for k in ['network', 'nodes', 'model', 'events', 'events_per_second', 'load', 'preprocess', 'loop', 'output']))
+    out.close()
+
+# execute main function
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,101 @@
+#! /usr/bin/env python3
+'''
+Events/sec of GEMF before and after a change, on the example/big_* SEIR data set.
+Builds GEMF at a baseline git revision and at the working tree, runs both through
+GEMF_FAVITES.py with the same seed, and reports the simulation loop throughput.
+example/big_contact_network_ba.tsv is not shipped: unless it is put there, a
+Barabasi-Albert network (3 edges per new node, seed 0) with one node per line of
+example/big_initial_states_seir.tsv is generated instead, and the run says so, so
+the numbers are then not those of the original data set.
+'''
+
+# imports
+from os.path import abspath, dirname, isfile
+from subprocess import check_call, check_output, DEVNULL
+from tempfile import mkdtemp
+import argparse
+import random
+import re
+
+# useful variables
+ROOT = abspath('%s/..' % dirname(abspath(__file__)))
+EXAMPLE = '%s/example' % ROOT
+FN_NETWORK = '%s/big_contact_network_ba.tsv' % EXAMPLE
+FN_STATES = '%s/big_initial_states_seir.tsv' % EXAMPLE
+FN_INFECTED = '%s/infected_states_seir.txt' % EXAMPLE
+FN_RATES = '%s/rates_seir.tsv' % EXAMPLE
+
+def gen_ba_network(fn, n, m=3, seed=0):
+    '''
+    Write a Barabasi-Albert contact network (FAVITES format) with nodes labeled 0 to n-1
+    '''
+    rng = random.Random(seed); rep = list(range(m))
+    with open(fn, 'w') as f:
+        for u in range(n):
+            f.write('NODE\t%d\t.\n' % u)
+        for v in range(m, n):
+            us = set()
+            while len(us) < m:
+                us.add(rng.choice(rep))
+            for u in us:
+                f.write('EDGE\t%d\t%d\t.\tu\n' % (u, v)); rep += [u, v]
+
+def sim_seconds(log_fn):
+    '''
+    Parse "simulation time cost[ ... ]" (time_print format) from a GEMF log
+    '''
+    s = re.search(r'simulation time cost\[ (.*?)\]', open(log_fn).read()).group(1)
+    sec = 0.
+    for val, unit in re.findall(r'([\d.]+) (d|h|m|s)', s):
+        sec += float(val) * {'d':86400, 'h':3600, 'm':60, 's':1}[unit]
+    return sec
+
+def run(gemf_path, network_fn, end_time, seed, tmp):
+    '''
+    Run GEMF through GEMF_FAVITES.py, return (events, seconds)
+    '''
+    outdir = mkdtemp(dir=tmp) + '/out'
+    # the executable of each build, not the in-process module
+    check_call(['python3', '%s/GEMF_FAVITES.py' % ROOT, '-c', network_fn, '-s', FN_STATES, '-i', FN_INFECTED, '-r', FN_RATES,
+                '-t', str(end_time), '-o', outdir, '--rng_seed', str(seed), '--gemf_path', gemf_path, '--gemf_executable', '--quiet'])
+    events = sum(1 for l in open('%s/output.txt' % outdir))
+    return events, sim_seconds('%s/log.txt' % outdir)
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('-b', '--base', required=False, type=str, default='HEAD~1', help="Baseline Git Revision")
+    parser.add_argument('-t', '--end_time', required=False, type=float, default=20, help="End Time")
+    parser.add_argument('-r', '--repeat', required=False, type=int, default=3, help="Runs per Build")
+    parser.add_argument('--seed', required=False, type=int, default=0, help="Random Number Generation Seed")
+    args = parser.parse_args()
+    tmp = mkdtemp()
+
+    # build baseline and current GEMF
+    check_call('git -C "%s" archive %s | tar -x -C "%s"' % (ROOT, args.base, tmp), shell=True)
+    check_call(['make', '-C', tmp], stdout=DEVNULL)
+    check_call(['make', '-C', ROOT], stdout=DEVNULL)
+    builds = [(args.base, '%s/GEMF' % tmp), ('current', '%s/GEMF' % ROOT)]
+
+    # the big network is not shipped, generate one matching the big initial states
+    network_fn = FN_NETWORK
+    if not isfile(network_fn):
+        network_fn = '%s/big_contact_network_ba.tsv' % tmp
+        nodes = sum(1 for l in open(FN_STATES))
+        gen_ba_network(network_fn, nodes)
+        print("network: %s not found, using a generated Barabasi-Albert network of %d nodes (m=3, seed 0): %s" % (FN_NETWORK, nodes, network_fn))
+    else:
+        print("network: %s" % network_fn)
+
+    # run and report best of repeats
+    print("build\tevents\tseconds\tevents/sec")
+    for name, gemf_path in builds:
+        best = None
+        for i in range(args.repeat):
+            events, sec = run(gemf_path, network_fn, args.end_time, args.seed, tmp)
+            if best is None or sec < best[1]:
+                best = (events, sec)
+        print("%s\t%d\t%.2f\t%.0f" % (name, best[0], best[1], best[0] / max(best[1], 1e-9)))
+
+# execute main function
+if __name__ == "__main__":
+    main()
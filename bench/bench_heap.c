@@ -0,0 +1,195 @@
+#include "heap.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+/*
+ * microbenchmark of the reaction heap backends
+ *
+ * replays the update pattern of the next reaction method: pop the earliest
+ * node, give it a new firing time, then move the firing time of one node
+ * per neighbour, the number of neighbours following a degree distribution.
+ * the degree of each node is read from an edge list, or drawn from a
+ * power law with exponent 3 and minimum 3 (Barabasi-Albert like).
+ * the recursive binary heap GEMF used before is run as reference, the
+ * calendar queue of calendar.h is run as well.
+ *
+ * usage: bench_heap [nodes] [events] [edge list file]
+ */
+
+//recursive binary heap of Reaction structs, the previous implementation
+typedef struct{
+    Reaction* reaction;
+    NINT* idx;
+    NINT V;
+} Ref_heap;
+static void ref_swap( Ref_heap* heap, NINT a, NINT b){
+    Reaction tr= heap->reaction[a];
+    heap->reaction[a]= heap->reaction[b];
+    heap->reaction[b]= tr;
+    heap->idx[heap->reaction[a].n]= a;
+    heap->idx[heap->reaction[b].n]= b;
+}
+static void ref_update_aux( Ref_heap* heap, NINT n){
+    NINT parent= (n- 1)/2;
+    NINT lchild= 2*n+ 1;
+    NINT rchild= 2*n+ 2;
+    if( n> 0&& heap->reaction[parent].t > heap->reaction[n].t){
+        ref_swap(heap, n, parent);
+        ref_update_aux(heap, parent);
+    }
+    else if( lchild< heap->V){
+        if( rchild< heap->V&& heap->reaction[rchild].t< heap->reaction[lchild].t && heap->reaction[rchild].t< heap->reaction[n].t){
+            ref_swap(heap, rchild, n);
+            ref_update_aux(heap, rchild);
+        }
+        else if( heap->reaction[lchild].t< heap->reaction[n].t){
+            ref_swap(heap, lchild, n);
+            ref_update_aux(heap, lchild);
+        }
+    }
+}
+static void ref_update( Ref_heap* heap, Reaction* reaction){
+    NINT n= heap->idx[reaction->n];
+    heap->reaction[n].t= reaction->t;
+    ref_update_aux(heap, n);
+}
+static int ref_cmp( const void* a, const void* b){
+    double d = ((Reaction*)a)->t - ((Reaction*)b)->t;
+    return d> 0? 1: d< 0? -1: 0;
+}
+
+//degree of every node, from an edge list or a power law
+static NINT* load_degree( const char* fil_nam, NINT* V){
+    NINT* deg;
+    FILE* fil;
+    long long i, j, max= 0;
+    char line[256];
+    Rng rng;
+    NINT n;
+
+    if( fil_nam== NULL){
+        deg= (NINT*)malloc( sizeof(NINT)* (*V));
+        rng_seed( &rng, RNG_XOSHIRO, 1);
+        for( n= 0; n< *V; n++){
+            //P(k) ~ k^-3 for k>= 3
+            deg[n]= (NINT)(3.0/ sqrt( rng_uniform_pos( &rng)));
+            if( deg[n]> *V- 1) deg[n]= *V- 1;
+        }
+        return deg;
+    }
+    fil= fopen( fil_nam, "r");
+    if( fil== NULL){
+        printf("read file[%s] error\n", fil_nam);
+        exit( -1);
+    }
+    while( fgets( line, sizeof(line), fil)){
+        if( sscanf( line, "%lld %lld", &i, &j)== 2){
+            if( i> max) max= i;
+            if( j> max) max= j;
+        }
+    }
+    *V= (NINT)max+ 1;
+    deg= (NINT*)calloc( *V, sizeof(NINT));
+    rewind( fil);
+    while( fgets( line, sizeof(line), fil)){
+        if( sscanf( line, "%lld %lld", &i, &j)== 2){
+            deg[i]++;
+            deg[j]++;
+        }
+    }
+    fclose( fil);
+    return deg;
+}
+
+//one run, d= -1 for the reference heap, 0 for the calendar queue, returns checksum of fired nodes
+static unsigned long long run( int d, NINT V, NINT* deg, size_t events, double* sec){
+    Graph graph;
+    Heap heap;
+    Ref_heap ref;
+    Reaction reaction;
+    Rng rng;
+    NINT n, k;
+    double now, t0;
+    unsigned long long sum= 0;
+    size_t e;
+
+    memset( &graph, 0, sizeof(Graph));
+    graph._s= 0;
+    graph._e= V;
+    rng_seed( &rng, RNG_XOSHIRO, 7);
+    if( d>= 0){
+        heap_init( &heap, &graph, d== 0? SCHED_CALENDAR: SCHED_HEAP, d== 0? HEAP_ARITY_DEFAULT: d);
+        for( n= 0; n< V; n++){
+            heap_fill( &heap, n, n, rng_exp( &rng));
+        }
+        heap_sort( &heap);
+    }
+    else{
+        ref.V= V;
+        ref.reaction= (Reaction*)malloc( sizeof(Reaction)* V);
+        ref.idx= (NINT*)malloc( sizeof(NINT)* V);
+        for( n= 0; n< V; n++){
+            ref.reaction[n].n= n;
+            ref.reaction[n].t= rng_exp( &rng);
+        }
+        qsort( ref.reaction, V, sizeof(Reaction), ref_cmp);
+        for( n= 0; n< V; n++){
+            ref.idx[ref.reaction[n].n]= n;
+        }
+    }
+    t0= gettimenow();
+    for( e= 0; e< events; e++){
+        if( d>= 0){
+            now= heap_top_t( &heap);
+            reaction.n= heap_top_n( &heap);
+        }
+        else{
+            now= ref.reaction[0].t;
+            reaction.n= ref.reaction[0].n;
+        }
+        sum+= reaction.n;
+        n= reaction.n;
+        reaction.t= now+ rng_exp( &rng);
+        if( d>= 0) heap_update( &heap, &reaction);
+        else ref_update( &ref, &reaction);
+        //rescaled firing times of the neighbours
+        for( k= 0; k< deg[n]; k++){
+            reaction.n= (NINT)rng_below( &rng, V);
+            if( d>= 0) reaction.t= now+ (get_tau( &heap, reaction.n)- now)* (0.5+ rng_uniform( &rng));
+            else reaction.t= now+ (ref.reaction[ref.idx[reaction.n]].t- now)* (0.5+ rng_uniform( &rng));
+            if( d>= 0) heap_update( &heap, &reaction);
+            else ref_update( &ref, &reaction);
+        }
+    }
+    *sec= gettimenow()- t0;
+    if( d>= 0) heap_free( &heap);
+    else{
+        free( ref.reaction);
+        free( ref.idx);
+    }
+    return sum;
+}
+int main( int argc, char* argv[]){
+    NINT V= argc> 1? (NINT)atol( argv[1]): 1000000;
+    size_t events= argc> 2? (size_t)atol( argv[2]): 2000000;
+    NINT* deg= load_degree( argc> 3? argv[3]: NULL, &V);
+    int arity[]= { -1, 2, 4, 8, 0};
+    unsigned long long sum, sum0= 0;
+    double sec;
+    size_t i;
+
+    printf("nodes[%u] events[%zu]\n", V, events);
+    printf("heap\t\tseconds\tevents/s\n");
+    for( i= 0; i< sizeof(arity)/ sizeof(int); i++){
+        sum= run( arity[i], V, deg, events, &sec);
+        if( i== 0) sum0= sum;
+        if( arity[i]== 0) printf("calendar\t%.3f\t%.0f%s\n", sec, events/ sec, sum== sum0? "": "\tMISMATCH");
+        else if( arity[i]> 0) printf("%d-ary\t\t%.3f\t%.0f%s\n", arity[i], sec, events/ sec, sum== sum0? "": "\tMISMATCH");
+        else printf("reference\t%.3f\t%.0f\n", sec, events/ sec);
+    }
+    free( deg);
+    return 0;
+}
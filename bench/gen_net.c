@@ -0,0 +1,244 @@
+#include "common.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+/*
+ * synthetic contact networks and initial states for benchmarks
+ *
+ * networks are undirected edge lists in the GEMF text format, nodes
+ * numbered from 1, each edge written once:
+ *   er       Erdos-Renyi G(n,p), parameter mean degree (6), by geometric
+ *            skipping over node pairs (Batagelj and Brandes, 2005)
+ *   ba       Barabasi-Albert, parameter edges per new node (3), by the
+ *            linear time list of edge ends (Batagelj and Brandes, 2005);
+ *            self loops are dropped, repeated edges kept
+ *   lattice  2D square lattice with periodic boundary, floor(sqrt(n))^2 nodes
+ *   config   configuration model, power law degrees with parameter
+ *            exponent (2.5), minimum 2 and maximum sqrt(n), stubs paired at
+ *            random; self loops are dropped, repeated edges kept
+ * the number of nodes and edges written goes to stdout as
+ * "nodes <n> edges <E>", for the [NETWORK_INFO] section.
+ *
+ * the initial states give each node state 0, or with probability fraction
+ * the given state, at least one node has it.
+ *
+ * usage: gen_net <er|ba|lattice|config> <nodes> <network file> [parameter] [seed]
+ *        gen_net status <nodes> <fraction> <state> <status file> [seed]
+ */
+
+//output buffer of edge lines
+#define GEN_BUF_SIZE (1<< 20)
+typedef struct{
+    FILE* fil;
+    char buf[GEN_BUF_SIZE];
+    size_t len;
+    size_t edges;
+} Gen_out;
+
+static char* put_uint( char* p, NINT v){
+    char tmp[16];
+    int k= 0;
+    do{
+        tmp[k++]= (char)('0'+ v% 10);
+        v/= 10;
+    }while( v> 0);
+    while( k> 0) *p++= tmp[--k];
+    return p;
+}
+//write edge i-j, nodes numbered from 0 here and from 1 in the file
+static void put_edge( Gen_out* out, NINT i, NINT j){
+    char* p;
+    if( out->len+ 32> GEN_BUF_SIZE){
+        fwrite( out->buf, 1, out->len, out->fil);
+        out->len= 0;
+    }
+    p= out->buf+ out->len;
+    p= put_uint( p, i+ 1);
+    *p++= '\t';
+    p= put_uint( p, j+ 1);
+    *p++= '\n';
+    out->len= (size_t)(p- out->buf);
+    out->edges++;
+}
+
+static void* gen_malloc( size_t n, size_t s){
+    void* p= malloc( n* s);
+    if( p== NULL){
+        printf("Memory allocation failure, size[%zu]\n", n* s);
+        exit( -1);
+    }
+    return p;
+}
+
+static void gen_er( Gen_out* out, Rng* rng, NINT n, double k){
+    double p= k/ (double)(n- 1), lq;
+    int64_t v= 1, w= -1;
+    if( p<= 0|| p>= 1){
+        printf("mean degree[%g] out of range\n", k);
+        exit( -1);
+    }
+    lq= log( 1.0- p);
+    while( v< (int64_t)n){
+        w+= 1+ (int64_t)floor( log( rng_uniform_pos( rng))/ lq);
+        while( w>= v&& v< (int64_t)n){
+            w-= v;
+            v++;
+        }
+        if( v< (int64_t)n) put_edge( out, (NINT)v, (NINT)w);
+    }
+}
+
+static void gen_ba( Gen_out* out, Rng* rng, NINT n, size_t m){
+    NINT* ends= (NINT*)gen_malloc( 2* (size_t)n* m, sizeof(NINT));
+    size_t v, i, e;
+    for( v= 0; v< n; v++){
+        for( i= 0; i< m; i++){
+            e= 2* (v* m+ i);
+            ends[e]= (NINT)v;
+            ends[e+ 1]= ends[rng_below( rng, e+ 1)];
+            if( ends[e+ 1]!= v) put_edge( out, (NINT)v, ends[e+ 1]);
+        }
+    }
+    free( ends);
+}
+
+static NINT gen_lattice( Gen_out* out, NINT n){
+    NINT side= (NINT)floor( sqrt( (double)n)), x, y;
+    if( side< 3){
+        printf("lattice needs at least 9 nodes\n");
+        exit( -1);
+    }
+    for( y= 0; y< side; y++){
+        for( x= 0; x< side; x++){
+            put_edge( out, y* side+ x, y* side+ (x+ 1)% side);
+            put_edge( out, y* side+ x, ((y+ 1)% side)* side+ x);
+        }
+    }
+    return side* side;
+}
+
+static void gen_config( Gen_out* out, Rng* rng, NINT n, double gamma){
+    double kmax= sqrt( (double)n);
+    size_t* deg= (size_t*)gen_malloc( n, sizeof(size_t));
+    size_t stubs= 0, i, j;
+    NINT* stub;
+    NINT t;
+    if( gamma<= 1){
+        printf("exponent[%g] must be above 1\n", gamma);
+        exit( -1);
+    }
+    for( i= 0; i< n; i++){
+        deg[i]= (size_t)floor( 2.0* pow( rng_uniform_pos( rng), -1.0/ (gamma- 1.0)));
+        if( deg[i]> kmax) deg[i]= (size_t)kmax;
+        stubs+= deg[i];
+    }
+    //even number of stubs
+    if( stubs% 2){
+        deg[rng_below( rng, n)]++;
+        stubs++;
+    }
+    stub= (NINT*)gen_malloc( stubs, sizeof(NINT));
+    for( i= 0, j= 0; i< n; i++){
+        while( deg[i]-- > 0) stub[j++]= (NINT)i;
+    }
+    free( deg);
+    for( i= stubs- 1; i> 0; i--){
+        j= rng_below( rng, i+ 1);
+        t= stub[i];
+        stub[i]= stub[j];
+        stub[j]= t;
+    }
+    for( i= 0; i< stubs; i+= 2){
+        if( stub[i]!= stub[i+ 1]) put_edge( out, stub[i], stub[i+ 1]);
+    }
+    free( stub);
+}
+
+static int gen_status( int argc, char* argv[]){
+    NINT n, i, hit= 0;
+    double frac;
+    int state;
+    FILE* fil;
+    Rng rng;
+    if( argc< 6){
+        printf("usage: %s status <nodes> <fraction> <state> <status file> [seed]\n", argv[0]);
+        return -1;
+    }
+    n= (NINT)strtoull( argv[2], NULL, 10);
+    frac= atof( argv[3]);
+    state= atoi( argv[4]);
+    rng_seed( &rng, RNG_XOSHIRO, argc> 6? strtoull( argv[6], NULL, 10): 1);
+    fil= fopen( argv[5], "w");
+    if( fil== NULL){
+        printf("open file[%s] failed\n", argv[5]);
+        return -1;
+    }
+    for( i= 0; i< n; i++){
+        //the last node gets the state if no other did
+        if( rng_uniform( &rng)< frac|| (i== n- 1&& !hit)){
+            fprintf( fil, "%d\n", state);
+            hit++;
+        }
+        else{
+            fprintf( fil, "0\n");
+        }
+    }
+    return fclose( fil)== 0? 0: -1;
+}
+
+int main( int argc, char* argv[]){
+    Gen_out* out;
+    Rng rng;
+    NINT n;
+    char* kind;
+    if( argc> 1&& !strcmp( argv[1], "status")){
+        return gen_status( argc, argv);
+    }
+    if( argc< 4){
+        printf("usage: %s <er|ba|lattice|config> <nodes> <network file> [parameter] [seed]\n", argv[0]);
+        printf("       %s status <nodes> <fraction> <state> <status file> [seed]\n", argv[0]);
+        return -1;
+    }
+    kind= argv[1];
+    n= (NINT)strtoull( argv[2], NULL, 10);
+    if( n< 2|| strtoull( argv[2], NULL, 10)>= UINT_MAX){
+        printf("nodes[%s] out of range\n", argv[2]);
+        return -1;
+    }
+    rng_seed( &rng, RNG_XOSHIRO, argc> 5? strtoull( argv[5], NULL, 10): 1);
+    out= (Gen_out*)gen_malloc( 1, sizeof(Gen_out));
+    out->len= 0;
+    out->edges= 0;
+    out->fil= fopen( argv[3], "w");
+    if( out->fil== NULL){
+        printf("open file[%s] failed\n", argv[3]);
+        return -1;
+    }
+    if( !strcmp( kind, "er")){
+        gen_er( out, &rng, n, argc> 4? atof( argv[4]): 6.0);
+    }
+    else if( !strcmp( kind, "ba")){
+        gen_ba( out, &rng, n, argc> 4? (size_t)atoi( argv[4]): 3);
+    }
+    else if( !strcmp( kind, "lattice")){
+        n= gen_lattice( out, n);
+    }
+    else if( !strcmp( kind, "config")){
+        gen_config( out, &rng, n, argc> 4? atof( argv[4]): 2.5);
+    }
+    else{
+        printf("unknown network[%s], expecting er, ba, lattice or config\n", kind);
+        return -1;
+    }
+    fwrite( out->buf, 1, out->len, out->fil);
+    if( fclose( out->fil)!= 0){
+        printf("write file[%s] failed\n", argv[3]);
+        return -1;
+    }
+    printf("nodes "fmt_n" edges %zu\n", n, out->edges);
+    free( out);
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "calendar.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+/*
+ * calendar.c of GEMF in C language
+ * calendar queue, see calendar.h
+ */
+
+#define CAL_MIN_BUCKETS 16
+//day width in mean gaps between events
+#define CAL_WIDTH_GAPS 3.0
+
+//day of time t
+static inline uint64_t cal_day( Calendar* cal, double t){
+    double k= t* cal->inv_w;
+    return k< 9.0e18? (uint64_t)k: (uint64_t)9.0e18;
+}
+static inline void cal_link( Calendar* cal, NINT n){
+    size_t b= (size_t)(cal_day( cal, cal->t[n])& (cal->nb- 1));
+    cal->prev[n]= CAL_NIL;
+    cal->next[n]= cal->bucket[b];
+    if( cal->bucket[b]!= CAL_NIL) cal->prev[cal->bucket[b]]= n;
+    cal->bucket[b]= n;
+}
+static inline void cal_unlink( Calendar* cal, NINT n){
+    size_t b;
+    if( cal->prev[n]!= CAL_NIL){
+        cal->next[cal->prev[n]]= cal->next[n];
+    }
+    else{
+        b= (size_t)(cal_day( cal, cal->t[n])& (cal->nb- 1));
+        cal->bucket[b]= cal->next[n];
+    }
+    if( cal->next[n]!= CAL_NIL) cal->prev[cal->next[n]]= cal->prev[n];
+}
+void calendar_init( Calendar* cal, NINT _s, NINT _e){
+    memset( cal, 0, sizeof(Calendar));
+    cal->_s= _s;
+    cal->_e= _e;
+    cal->t= (double*)malloc( sizeof(double)* ((size_t)_e+ 1));
+    cal->next= (NINT*)malloc( sizeof(NINT)* ((size_t)_e+ 1));
+    cal->prev= (NINT*)malloc( sizeof(NINT)* ((size_t)_e+ 1));
+    if( cal->t== NULL|| cal->next== NULL|| cal->prev== NULL){
+        printf("malloc calendar queue failed.\n");
+        error_exit( -1);
+    }
+    cal->top= CAL_NIL;
+}
+void calendar_free( Calendar* cal){
+    free( cal->t);
+    free( cal->next);
+    free( cal->prev);
+    free( cal->bucket);
+    memset( cal, 0, sizeof(Calendar));
+}
+//relink all scheduled nodes into nb buckets of width w
+static void cal_resize( Calendar* cal, size_t nb, double w){
+    NINT head= CAL_NIL, n, nx;
+    double t_min= DBL_MAX;
+    size_t b;
+
+    //chain all scheduled nodes through next
+    for( b= 0; b< cal->nb; b++){
+        for( n= cal->bucket[b]; n!= CAL_NIL; n= nx){
+            nx= cal->next[n];
+            cal->next[n]= head;
+            head= n;
+            if( cal->t[n]< t_min) t_min= cal->t[n];
+        }
+    }
+    if( nb!= cal->nb|| cal->bucket== NULL){
+        free( cal->bucket);
+        cal->bucket= (NINT*)malloc( sizeof(NINT)* nb);
+        if( cal->bucket== NULL){
+            printf("malloc calendar buckets failed, size[%zu].\n", sizeof(NINT)* nb);
+            error_exit( -1);
+        }
+        cal->nb= nb;
+    }
+    for( b= 0; b< nb; b++){
+        cal->bucket[b]= CAL_NIL;
+    }
+    if( w> 0&& w< DBL_MAX){
+        cal->w= w;
+        cal->inv_w= 1.0/ w;
+    }
+    for( n= head; n!= CAL_NIL; n= nx){
+        nx= cal->next[n];
+        cal_link( cal, n);
+    }
+    cal->cur= t_min< DBL_MAX? cal_day( cal, t_min): 0;
+}
+static int dbl_cmp( const void* a, const void* b){
+    double d= *(double*)a- *(double*)b;
+    return d> 0? 1: d< 0? -1: 0;
+}
+void calendar_build( Calendar* cal){
+    double sample[1024], t_min= DBL_MAX;
+    size_t s= 0, q, nb, stride;
+    NINT n;
+
+    cal->count= 0;
+    for( n= cal->_s; n< cal->_e; n++){
+        if( cal->t[n]< DBL_MAX) cal->count++;
+        if( cal->t[n]< t_min) t_min= cal->t[n];
+    }
+    //day width from the density of the earliest times in a sample
+    cal->w= 1.0;
+    stride= cal->count/ 1024+ 1;
+    for( n= cal->_s, q= 0; n< cal->_e&& s< 1024; n++){
+        if( cal->t[n]< DBL_MAX&& q++% stride== 0) sample[s++]= cal->t[n];
+    }
+    if( s> 1){
+        qsort( sample, s, sizeof(double), dbl_cmp);
+        q= s/ 16> 0? s/ 16: 1;
+        if( sample[q]> sample[0]){
+            cal->w= CAL_WIDTH_GAPS* (sample[q]- sample[0])* (double)s/ ((double)q* (double)cal->count);
+        }
+    }
+    cal->inv_w= 1.0/ cal->w;
+    for( nb= CAL_MIN_BUCKETS; nb< cal->count; nb<<= 1);
+    free( cal->bucket);
+    cal->bucket= NULL;
+    cal->nb= 0;
+    cal_resize( cal, nb, cal->w);
+    for( n= cal->_s; n< cal->_e; n++){
+        if( cal->t[n]< DBL_MAX) cal_link( cal, n);
+    }
+    cal->cur= t_min< DBL_MAX? cal_day( cal, t_min): 0;
+    cal->top= CAL_NIL;
+    cal->gap= 0;
+    cal->last_t= 0;
+}
+NINT calendar_find_top( Calendar* cal){
+    uint64_t day, last;
+    size_t mask= cal->nb- 1, scans= 0;
+    NINT n, best= CAL_NIL;
+    double t_best= DBL_MAX;
+
+    if( cal->count== 0) return CAL_NIL;
+    //day by day through one year
+    for( day= cal->cur, last= cal->cur+ cal->nb; day< last&& best== CAL_NIL; day++){
+        for( n= cal->bucket[day& mask]; n!= CAL_NIL; n= cal->next[n]){
+            scans++;
+            if( cal->t[n]< t_best&& cal_day( cal, cal->t[n])== day){
+                t_best= cal->t[n];
+                best= n;
+            }
+        }
+    }
+    //nothing in this year, search all buckets
+    if( best== CAL_NIL){
+        for( day= 0; day< cal->nb; day++){
+            for( n= cal->bucket[day]; n!= CAL_NIL; n= cal->next[n]){
+                if( cal->t[n]< t_best){
+                    t_best= cal->t[n];
+                    best= n;
+                }
+            }
+        }
+        scans+= cal->count+ cal->nb;
+    }
+    cal->cur= cal_day( cal, t_best);
+    cal->top= best;
+    //re-tune day width when a find costs too much
+    if( scans> 64&& cal->gap> 0&& (cal->w> 4* CAL_WIDTH_GAPS* cal->gap|| cal->w< CAL_WIDTH_GAPS* cal->gap/ 4)){
+        cal_resize( cal, cal->nb, CAL_WIDTH_GAPS* cal->gap);
+    }
+    return best;
+}
+void calendar_update( Calendar* cal, NINT n, double t){
+    double old= cal->t[n];
+    uint64_t day;
+    size_t nb= cal->nb;
+
+    if( old< DBL_MAX){
+        cal_unlink( cal, n);
+        cal->count--;
+    }
+    //the earliest node fires, keep track of the gaps between events
+    if( n== cal->top){
+        if( old>= cal->last_t&& old< DBL_MAX){
+            cal->gap= cal->gap> 0? 0.95* cal->gap+ 0.05* (old- cal->last_t): old- cal->last_t;
+            cal->last_t= old;
+        }
+        cal->top= CAL_NIL;
+    }
+    cal->t[n]= t;
+    if( t< DBL_MAX){
+        cal_link( cal, n);
+        cal->count++;
+        day= cal_day( cal, t);
+        if( day< cal->cur) cal->cur= day;
+        if( cal->top!= CAL_NIL&& t< cal->t[cal->top]) cal->top= n;
+    }
+    //number of buckets follows number of scheduled nodes
+    if( cal->count> 2* nb) nb*= 2;
+    else if( nb> CAL_MIN_BUCKETS&& cal->count< nb/ 4) nb/= 2;
+    if( nb!= cal->nb){
+        cal_resize( cal, nb, CAL_WIDTH_GAPS* cal->gap);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef CALENDARH
+#define CALENDARH
+
+#include "common.h"
+#include <stdint.h>
+/*
+ * calendar.h of GEMF in C language
+ * calendar queue of next reaction times (R. Brown, CACM 1988)
+ *
+ * time is cut into days of width w, day k goes to bucket k mod nb, so a
+ * bucket holds the nodes of days k, k+nb, k+2nb... in an unsorted
+ * intrusive list. extract-min scans the buckets of the current year day
+ * by day, which is O(1) on average when w is about three times the mean
+ * gap between events and the number of buckets follows the number of
+ * scheduled nodes. nodes with firing time DBL_MAX (zero rate) are dormant
+ * and kept out of the buckets.
+ */
+
+#define CAL_NIL ((NINT)-1)
+
+typedef struct{
+    //firing time of each node, DBL_MAX if dormant, 1 by _e
+    double* t;
+    //bucket list links of each node, 1 by _e
+    NINT* next;
+    NINT* prev;
+    //first node of each bucket, nb buckets, nb is a power of 2
+    NINT* bucket;
+    size_t nb;
+    //day width and its inverse
+    double w;
+    double inv_w;
+    //current day, all scheduled times are in day cur or later
+    uint64_t cur;
+    //number of scheduled nodes
+    size_t count;
+    //cached earliest node, CAL_NIL if unknown
+    NINT top;
+    //last extracted time and moving average of gaps between extracted times
+    double last_t;
+    double gap;
+    //nodes start from _s, end at _e-1
+    NINT _s;
+    NINT _e;
+} Calendar;
+
+//allocate calendar for nodes [_s, _e)
+void calendar_init( Calendar* cal, NINT _s, NINT _e);
+//free calendar
+void calendar_free( Calendar* cal);
+//schedule all nodes from t[_s...e-1], any previous content is dropped
+void calendar_build( Calendar* cal);
+//set firing time of node n, DBL_MAX makes it dormant
+void calendar_update( Calendar* cal, NINT n, double t);
+//find earliest node, CAL_NIL if nothing is scheduled
+NINT calendar_find_top( Calendar* cal);
+
+//earliest node, CAL_NIL if nothing is scheduled
+static inline NINT calendar_top( Calendar* cal){
+    return cal->top!= CAL_NIL|| cal->count== 0? cal->top: calendar_find_top( cal);
+}
+
+#endif
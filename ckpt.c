@@ -0,0 +1,268 @@
+#include "ckpt.h"
+#include "hub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+/*
+ * ckpt.c of GEMF in C language
+ * checkpoint and restart of a single round, see ckpt.h
+ */
+
+volatile sig_atomic_t ckpt_signal= 0;
+
+static void ckpt_on_signal( int sig){
+    ckpt_signal= sig== SIGTERM? 2: 1;
+}
+
+//firing time, or sum tree leaf, of node n
+static double ckpt_sched_get( Heap* heap, NINT n){
+    if( heap->sched== SCHED_DIRECT|| heap->sched== SCHED_REJECTION) return sum_tree_get( &heap->sum, n);
+    return get_tau( heap, n);
+}
+
+static size_t ckpt_hub_arcs( Run* run, Graph* graph){
+    return run->hubs!= NULL? run->hubs->off[graph->_e]: 0;
+}
+
+Ckpt* ckpt_open( const char* fil_nam, double interval){
+    Ckpt* ck= (Ckpt*)calloc( 1, sizeof(Ckpt));
+    struct sigaction sa;
+    if( ck== NULL) return NULL;
+    ck->fil_nam= strdup( fil_nam);
+    ck->tmp_nam= (char*)malloc( strlen( fil_nam)+ 5);
+    if( ck->fil_nam== NULL|| ck->tmp_nam== NULL){
+        ckpt_close( ck);
+        return NULL;
+    }
+    sprintf( ck->tmp_nam, "%s.tmp", fil_nam);
+    ck->interval= interval;
+    ck->last= gettimenow();
+    memset( &sa, 0, sizeof(sa));
+    sa.sa_handler= ckpt_on_signal;
+    sa.sa_flags= SA_RESTART;
+    sigemptyset( &sa.sa_mask);
+    sigaction( SIGUSR1, &sa, NULL);
+    sigaction( SIGTERM, &sa, NULL);
+    return ck;
+}
+
+static void* ckpt_writer( void* arg){
+    Ckpt* ck= (Ckpt*)arg;
+    const char* p= ck->buf;
+    size_t n= ck->len;
+    ssize_t k;
+    int fd;
+    //the output it refers to goes first
+    if( ck->out!= NULL&& out_sync( ck->out, ck->out_offset)< 0){
+        ck->err= -1;
+        return NULL;
+    }
+    fd= open( ck->tmp_nam, O_WRONLY| O_CREAT| O_TRUNC, 0644);
+    if( fd< 0){
+        ck->err= -1;
+        return NULL;
+    }
+    while( n> 0){
+        k= write( fd, p, n);
+        if( k< 0){
+            if( errno== EINTR) continue;
+            break;
+        }
+        p+= k;
+        n-= (size_t)k;
+    }
+    if( n> 0|| fdatasync( fd)) ck->err= -1;
+    if( close( fd)) ck->err= -1;
+    if( ck->err== 0&& rename( ck->tmp_nam, ck->fil_nam)) ck->err= -1;
+    return NULL;
+}
+
+static char* ckpt_put( char* p, const void* data, size_t n){
+    memcpy( p, data, n);
+    return p+ n;
+}
+
+void ckpt_save( Ckpt* ck, Graph* graph, Status* sts, Run* run, Sim_state* st, Out_stream* out){
+    Ckpt_header hdr;
+    size_t layer, arcs= ckpt_hub_arcs( run, graph), e= graph->_e;
+    double t;
+    char* p;
+    NINT n;
+    if( ckpt_wait( ck)< 0){
+        printf("write checkpoint[%s] failed\n", ck->fil_nam);
+    }
+    ck->len= sizeof(Ckpt_header)+ 2* sizeof(Rng)+ sizeof(Perf_counters)+ e* sizeof(size_t)+ (sts->_s+ sts->M)* sizeof(NINT)
+        + (2+ graph->L)* e* sizeof(double)+ (arcs> 0? arcs* sizeof(size_t)+ e* sizeof(double): 0);
+    if( ck->len> ck->cap){
+        free( ck->buf);
+        ck->buf= (char*)malloc( ck->len);
+        if( ck->buf== NULL){
+            printf("Memory allocation failure for checkpoint, size[%zu]\n", ck->len);
+            error_exit( -1);
+        }
+        ck->cap= ck->len;
+    }
+    ck->out= out;
+    ck->out_offset= 0;
+    if( out!= NULL){
+        out_flush_buf( out);
+        ck->out_offset= out_tell( out);
+    }
+    memset( &hdr, 0, sizeof(hdr));
+    memcpy( hdr.magic, CKPT_MAGIC, sizeof(CKPT_MAGIC));
+    hdr.version= CKPT_VERSION;
+    hdr.heap_arity= run->heap_arity;
+    hdr.scheduler= run->scheduler;
+    hdr._s= graph->_s;
+    hdr._e= graph->_e;
+    hdr.L= graph->L;
+    hdr.M= sts->M;
+    hdr.cs= sts->_s;
+    hdr.seed= sts->random_seed;
+    hdr.rng_kind= sts->rng_kind;
+    hdr.out_format= run->out_format;
+    hdr.show_inducer= run->show_inducer;
+    hdr.show_infector= run->show_infector;
+    hdr.hub_arcs= arcs;
+    hdr.count= st->count;
+    hdr.total= st->total;
+    hdr.elapse_tim= st->elapse_tim;
+    hdr.R= st->R;
+    hdr.out_offset= ck->out_offset;
+    hdr.out_grid= run->out_grid;
+    hdr.grid_step= run->grid_step;
+    hdr.grid_events= run->grid_events;
+    p= ckpt_put( ck->buf, &hdr, sizeof(hdr));
+    p= ckpt_put( p, &st->rng, sizeof(Rng));
+    p= ckpt_put( p, &st->inf_rng, sizeof(Rng));
+    p= ckpt_put( p, &st->perf, sizeof(Perf_counters));
+    p= ckpt_put( p, st->init_lst, e* sizeof(size_t));
+    p= ckpt_put( p, st->init_cnt, (sts->_s+ sts->M)* sizeof(NINT));
+    p= ckpt_put( p, st->p_raw_rat_lst, e* sizeof(double));
+    for( layer= 0; layer< graph->L; layer++){
+        p= ckpt_put( p, st->p_inducer_cal_lst[layer], e* sizeof(double));
+    }
+    for( n= 0; n< graph->_e; n++){
+        t= n< graph->_s? 0: ckpt_sched_get( &st->heap, n);
+        p= ckpt_put( p, &t, sizeof(double));
+    }
+    if( arcs> 0){
+        p= ckpt_put( p, st->hub_seen, arcs* sizeof(size_t));
+        ckpt_put( p, st->hub_head, e* sizeof(double));
+    }
+    ck->last= gettimenow();
+    if( ckpt_signal== 1) ckpt_signal= 0;
+    ck->err= 0;
+    if( pthread_create( &ck->tid, NULL, ckpt_writer, ck)){
+        printf("create checkpoint writer thread failed\n");
+        error_exit( -1);
+    }
+    ck->busy= 1;
+    LOG(1, __FILE__, __LINE__, "checkpoint at event [%zu], time [%.6g]\n", st->count, st->elapse_tim);
+}
+
+int ckpt_wait( Ckpt* ck){
+    if( !ck->busy) return 0;
+    pthread_join( ck->tid, NULL);
+    ck->busy= 0;
+    return ck->err;
+}
+
+void ckpt_close( Ckpt* ck){
+    if( ck== NULL) return;
+    if( ckpt_wait( ck)< 0){
+        printf("write checkpoint[%s] failed\n", ck->fil_nam);
+    }
+    free( ck->fil_nam);
+    free( ck->tmp_nam);
+    free( ck->buf);
+    free( ck);
+}
+
+int ckpt_header( const char* fil_nam, Graph* graph, Status* sts, Run* run, Ckpt_header* hdr){
+    FILE* fil= fopen( fil_nam, "rb");
+    if( fil== NULL){
+        printf("open checkpoint[%s] failed\n", fil_nam);
+        return -1;
+    }
+    if( fread( hdr, sizeof(Ckpt_header), 1, fil)!= 1|| memcmp( hdr->magic, CKPT_MAGIC, sizeof(CKPT_MAGIC))|| hdr->version!= CKPT_VERSION){
+        printf("file[%s] is not a GEMF checkpoint of version[%d]\n", fil_nam, CKPT_VERSION);
+        fclose( fil);
+        return -1;
+    }
+    fclose( fil);
+    if( hdr->_s!= graph->_s|| hdr->_e!= graph->_e|| hdr->L!= graph->L|| hdr->M!= sts->M|| hdr->cs!= sts->_s){
+        printf("checkpoint[%s] is of another network or model\n", fil_nam);
+        return -1;
+    }
+    if( hdr->scheduler!= run->scheduler|| hdr->heap_arity!= run->heap_arity|| hdr->seed!= sts->random_seed|| hdr->rng_kind!= sts->rng_kind||
+        hdr->out_format!= run->out_format|| hdr->show_inducer!= run->show_inducer|| hdr->show_infector!= run->show_infector||
+        hdr->hub_arcs!= ckpt_hub_arcs( run, graph)|| hdr->out_grid!= run->out_grid|| hdr->grid_step!= run->grid_step|| hdr->grid_events!= run->grid_events){
+        printf("checkpoint[%s] was taken with other [SCHEDULER], [HEAP], [RANDOM_SEED], [RNG], [OUT_FORMAT], [OUT_GRID], [SHOW_INDUCER], [SHOW_INFECTOR] or [HUB_THRESHOLD]\n", fil_nam);
+        return -1;
+    }
+    return 0;
+}
+
+int ckpt_load( const char* fil_nam, Graph* graph, Status* sts, Run* run, Sim_state* st){
+    Ckpt_header hdr;
+    FILE* fil;
+    Heap* heap= &st->heap;
+    size_t layer, arcs, e= graph->_e;
+    double* t;
+    int ok;
+    NINT n;
+    if( ckpt_header( fil_nam, graph, sts, run, &hdr)< 0) return -1;
+    arcs= hdr.hub_arcs;
+    fil= fopen( fil_nam, "rb");
+    if( fil== NULL) return -1;
+    t= (double*)malloc( e* sizeof(double));
+    if( t== NULL){
+        printf("Memory allocation failure for checkpoint, size[%zu]\n", e* sizeof(double));
+        error_exit( -1);
+    }
+    ok= fseek( fil, sizeof(Ckpt_header), SEEK_SET)== 0&&
+        fread( &st->rng, sizeof(Rng), 1, fil)== 1&&
+        fread( &st->inf_rng, sizeof(Rng), 1, fil)== 1&&
+        fread( &st->perf, sizeof(Perf_counters), 1, fil)== 1&&
+        fread( st->init_lst, sizeof(size_t), e, fil)== e&&
+        fread( st->init_cnt, sizeof(NINT), sts->_s+ sts->M, fil)== sts->_s+ sts->M&&
+        fread( st->p_raw_rat_lst, sizeof(double), e, fil)== e;
+    for( layer= 0; ok&& layer< graph->L; layer++){
+        ok= fread( st->p_inducer_cal_lst[layer], sizeof(double), e, fil)== e;
+    }
+    ok= ok&& fread( t, sizeof(double), e, fil)== e;
+    if( ok&& arcs> 0){
+        ok= fread( st->hub_seen, sizeof(size_t), arcs, fil)== arcs&&
+            fread( st->hub_head, sizeof(double), e, fil)== e;
+    }
+    fclose( fil);
+    if( !ok){
+        printf("checkpoint[%s] is truncated\n", fil_nam);
+        free( t);
+        return -1;
+    }
+    //firing times or sum tree leaves, as they were
+    if( heap->sched== SCHED_DIRECT|| heap->sched== SCHED_REJECTION){
+        for( n= graph->_s; n< graph->_e; n++){
+            heap->sum.w[heap->sum.P+ n- graph->_s]= t[n];
+        }
+        sum_tree_sum( &heap->sum);
+    }
+    else{
+        for( n= graph->_s; n< graph->_e; n++){
+            heap_fill( heap, n- graph->_s, n, t[n]);
+        }
+        heap_sort( heap);
+    }
+    free( t);
+    st->count= hdr.count;
+    st->total= hdr.total;
+    st->elapse_tim= hdr.elapse_tim;
+    st->R= hdr.R;
+    st->resumed= SIM_RESUMED;
+    return 0;
+}
@@ -0,0 +1,107 @@
+#ifndef CKPTH
+#define CKPTH
+
+#include "nrm.h"
+#include <signal.h>
+#include <pthread.h>
+/*
+ * ckpt.h of GEMF in C language
+ * checkpoint and restart of a single round
+ *
+ * a checkpoint holds everything sim_round keeps between two events: the
+ * compartments and counts, rates, inducer counts, the firing time or the
+ * sum tree leaf of every node, hub arcs, event counts, the time, R and
+ * both random streams, with the length of the output written so far. it
+ * is taken after an event, copied to memory, and written by a thread of
+ * its own once the output up to it is on disk, to a temporary file that
+ * is renamed over the checkpoint, so the file always holds a complete
+ * checkpoint. a resumed run cuts the output file to that length and
+ * continues, its output is the same as the one of an uninterrupted run.
+ *
+ * checkpoints are taken every interval seconds, on SIGUSR1, and on
+ * SIGTERM, after which the round stops. they need an uncompressed output
+ * file and a single round of the exact method.
+ *
+ * file layout, native byte order: Ckpt_header, Rng of events and of
+ * infectors, Perf_counters, then init_lst by _e (size_t), init_cnt by
+ * _s+M (NINT), rates by _e, inducer counts by L*_e, times or leaves by _e
+ * (double), hub arc compartments by hub_arcs (size_t) and headrooms by _e
+ * (double) with a hub index.
+ */
+
+#define CKPT_MAGIC "GEMFCKP"
+#define CKPT_VERSION 4
+//events between two looks at the clock
+#define CKPT_CHECK_MASK 4095
+
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    int32_t heap_arity;
+    //nodes, layers and compartments of the run it was taken from
+    uint64_t _s, _e, L, M, cs;
+    int64_t seed;
+    int32_t rng_kind;
+    int32_t out_format;
+    int32_t show_inducer;
+    int32_t show_infector;
+    uint64_t hub_arcs;
+    //event counts, time and total rate when taken
+    uint64_t count, total;
+    double elapse_tim;
+    double R;
+    //bytes of output written before it
+    uint64_t out_offset;
+    //[OUT_GRID] of the output
+    int32_t out_grid;
+    int32_t scheduler;
+    double grid_step;
+    uint64_t grid_events;
+} Ckpt_header;
+
+typedef struct Ckpt Ckpt;
+struct Ckpt{
+    char* fil_nam;
+    char* tmp_nam;
+    //seconds between checkpoints, and time of the last one
+    double interval;
+    double last;
+    //checkpoint in memory, written by the writer thread
+    char* buf;
+    size_t len, cap;
+    Out_stream* out;
+    uint64_t out_offset;
+    pthread_t tid;
+    int busy;
+    int err;
+};
+
+//set by SIGUSR1 (1) and SIGTERM (2)
+extern volatile sig_atomic_t ckpt_signal;
+
+//checkpoints to fil_nam every interval seconds, and on signals
+Ckpt* ckpt_open( const char* fil_nam, double interval);
+//take a checkpoint of st after its last event
+void ckpt_save( Ckpt* ck, Graph* graph, Status* sts, Run* run, Sim_state* st, Out_stream* out);
+//wait for the last checkpoint to be written, <0 if it failed
+int ckpt_wait( Ckpt* ck);
+void ckpt_close( Ckpt* ck);
+//read and check the header of a checkpoint against the run, <0 on failure
+int ckpt_header( const char* fil_nam, Graph* graph, Status* sts, Run* run, Ckpt_header* hdr);
+/*
+ *restore a single round from a checkpoint
+ *
+ *input:  char*      fil_nam  [ checkpoint file]
+ *output: Sim_state* st       [ allocated by the caller, heap included; resumed is set]
+ *return: int   [0 or -1]
+ */
+int ckpt_load( const char* fil_nam, Graph* graph, Status* sts, Run* run, Sim_state* st);
+
+//whether a checkpoint is due after event count
+static inline int ckpt_due( Ckpt* ck, size_t count){
+    if( ckpt_signal) return 1;
+    if( count& CKPT_CHECK_MASK) return 0;
+    return gettimenow()- ck->last>= ck->interval;
+}
+
+#endif
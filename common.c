@@ -4,6 +4,10 @@
 #include <stdarg.h>
 #include <limits.h>
 
+int _LOGLVL_;
+//error boundary of each thread, see error_exit
+static __thread jmp_buf* _ERR_JMP_;
+
 #ifdef WIN_X64
 double gettimenow(){
     LARGE_INTEGER m_nFreq;  
@@ -29,35 +33,30 @@ int LOG(int loglvl, const char* file, int line, char* format, ...){
     va_end(args);
     return 0;
 }
+void error_exit( int code){
+    if( _ERR_JMP_!= NULL) longjmp( *_ERR_JMP_, code? code: -1);
+    exit( code);
+}
+jmp_buf* error_boundary( jmp_buf* jb){
+    jmp_buf* ret= _ERR_JMP_;
+    _ERR_JMP_= jb;
+    return ret;
+}
 //dump graph
 void dump_graph(Graph* graph){
     size_t li, layer;
+    NINT i;
     printf("print edge list\n");
-    if( graph->weighted){
-        for( layer= 0; layer< graph->L; layer++){
-            printf("layer[%zu]\n", layer);
-            for( li= 0; li< graph->E[layer]; li++){
-                printf("L[%zu]E[%zu]i[" fmt_n "]j[" fmt_n "]w[%lf]\n", layer, li, graph->edge_w[layer][li].i, 
-                graph->edge_w[layer][li].j, graph->edge_w[layer][li].w);
-            }
-            if( graph->index!= NULL){
-                printf("index:\n");
-                for( NINT i = 0; i< graph->_e; i++){
-                    printf("%d\n", graph->index[layer][i]);
+    if( graph->offsets== NULL) return;
+    for( layer= 0; layer< graph->L; layer++){
+        printf("layer[%zu]\n", layer);
+        for( i= graph->_s; i< graph->_e; i++){
+            for( li= graph->offsets[layer][i]; li< graph->offsets[layer][i+ 1]; li++){
+                if( graph->weighted){
+                    printf("L[%zu]E[%zu]i[" fmt_n "]j[" fmt_n "]w[%lf]\n", layer, li, i, graph->targets[layer][li], graph->weights[layer][li]);
                 }
-            }
-        }
-    }
-    else{
-        for( layer= 0; layer< graph->L; layer++){
-            printf("layer[%zu]\n", layer);
-            for( li= 0; li< graph->E[layer]; li++){
-                printf("L[%zu]E[%zu]i[" fmt_n "]j[" fmt_n "]\n", layer, li, graph->edge[layer][li].i,graph->edge[layer][li].j);
-            }
-            if( graph->index != NULL){
-                printf("index:\n");
-                for( NINT i = 0; i< graph->_e; i++){
-                    printf("%d\n", graph->index[layer][i]);
+                else{
+                    printf("L[%zu]E[%zu]i[" fmt_n "]j[" fmt_n "]\n", layer, li, i, graph->targets[layer][li]);
                 }
             }
         }
@@ -79,7 +78,7 @@ int check_int_range( LONG li){
     if( li> UINT_MAX){
         kilobit_print("[ ", li, " ] exceed max ");
         kilobit_print("[ ", UINT_MAX, " ], exit.\n");
-        exit( - 1);
+        error_exit( -1);
     }
     return 0;
 }
@@ -13,6 +13,7 @@
 #include <sys/time.h>
 #endif
 #include <stddef.h>
+#include <setjmp.h>
 
 typedef char LINE[MAX_LINE_LEN];
 typedef long long LONG;
@@ -36,6 +37,7 @@ typedef struct
 } Edge_w;
 typedef struct
 {
+    //edge lists of text network files while loading, freed once the adjacency is built
     Edge **edge;
     Edge_w **edge_w;
     //number of nodes
@@ -51,8 +53,22 @@ typedef struct
     int directed;
     //number of layers
     size_t L;
-    //if network is sorted, index[i] is the position of the last edge oriented from node i;
-    NINT** index;
+    //CSR adjacency of each layer, arcs from node n are targets[layer][offsets[layer][n]...offsets[layer][n+1]-1]
+    //offsets by _e+1, targets and weights by E[layer], weights is NULL for unweighted network
+    size_t** offsets;
+    NINT** targets;
+    double** weights;
+    //layer whose adjacency each layer uses, adj[layer]<= layer, a layer with adj[layer]!= layer shares
+    //the arrays of that layer and owns none; NULL if every layer has its own
+    size_t* adj;
+    //reverse CSR adjacency, arcs into node n are sources[layer][r_offsets[layer][n]...r_offsets[layer][n+1]-1]
+    //NULL until graph_reverse_build, shares the forward arrays of undirected graphs
+    size_t** r_offsets;
+    NINT** r_sources;
+    double** r_weights;
+    //mapped binary graph file, adjacency points into it, NULL for text edge lists
+    void* map;
+    size_t map_size;
 } Graph;
 typedef struct
 {
@@ -72,6 +88,9 @@ typedef struct
     double ***edge_trn;
     //1 by L array, inducer for each layer
     size_t *inducer_lst;
+    //(_s+M) by (L+1)*M array, built by init_trn_table()
+    //row i: cumulative nodal rates from compartment i, then cumulative edge based rates of each layer
+    double **trn_table;
 } Transition;
 typedef struct
 {
@@ -91,6 +110,8 @@ typedef struct
     NINT *init_cnt;
     //random number seed
     int random_seed;
+    //random number generator, see rng.h
+    int rng_kind;
 } Status;
 typedef struct
 {
@@ -104,7 +125,83 @@ typedef struct
     size_t interval_num;
     char *out_file;
     int show_inducer;
+    //sample the infector of each event and write it, see sample_infector
+    int show_infector;
+    //number of worker threads for independent rounds
+    size_t threads;
+    //event scheduler, SCHED_HEAP ... SCHED_REJECTION, see heap.h
+    int scheduler;
+    //arity of the reaction heap, 2, 4 or 8
+    int heap_arity;
+    //single round output, OUT_TEXT, OUT_BINARY or OUT_BINARY_COUNTS
+    int out_format;
+    //compression codec and level of the output file, see output.h
+    int out_codec;
+    int out_level;
+    //no console messages, set by the library
+    int quiet;
+    //performance report of [REPORT_FILE], NULL if not asked for, see perf.h
+    struct Perf* perf;
+    //approximate tau-leaping instead of the exact method, TAU_OFF, TAU_FIXED or TAU_ADAPTIVE,
+    //with its step or error tolerance, see tau.h
+    int tau_leap;
+    double tau;
+    //nodes of at least this many arcs update their neighbours lazily, 0 for none, and their
+    //index, see hub.h
+    NINT hub_threshold;
+    struct Hub_index* hubs;
+    //checkpoints of [CHECKPOINT], NULL if not asked for, and the checkpoint to resume from,
+    //NULL for a fresh run, see ckpt.h
+    struct Ckpt* ckpt;
+    char* resume;
+    //continuations of [BRANCH] run from the state at branch_time, 0 for none
+    size_t branch_num;
+    double branch_time;
+    //single round output of counts only, GRID_OFF, GRID_TIME every grid_step or GRID_EVENTS
+    //every grid_events events
+    int out_grid;
+    double grid_step;
+    size_t grid_events;
+    //[STOP_WHEN] conditions, any of them ends a round
+    struct Stop_cond* stop;
+    size_t stop_num;
+    //mean, sd and quantiles of an ensemble are written to [STATS_FILE], NULL for none, see stats.h
+    char* stats_file;
 } Run;
+#define TAU_OFF 0
+#define TAU_FIXED 1
+#define TAU_ADAPTIVE 2
+#define OUT_TEXT 0
+#define OUT_BINARY 1
+#define OUT_BINARY_COUNTS 2
+#define GRID_OFF 0
+#define GRID_TIME 1
+#define GRID_EVENTS 2
+//conditions of [STOP_WHEN]: an event empties compartment c, an event brings compartment c
+//above v, the total rate falls below v, or the round has run for v seconds
+#define STOP_ZERO 0
+#define STOP_ABOVE 1
+#define STOP_RATE 2
+#define STOP_WALL 3
+//events between two looks at the clock for STOP_WALL
+#define STOP_WALL_MASK 4095
+//how a round ended: [MAX_TIME], [MAX_EVENTS], no more events, event callback, SIGTERM,
+//or END_COND plus the kind of a [STOP_WHEN] condition
+#define END_TIME 0
+#define END_EVENTS 1
+#define END_EMPTY 2
+#define END_HOOK 3
+#define END_SIGNAL 4
+#define END_COND 5
+#define END_KINDS 9
+typedef struct Stop_cond Stop_cond;
+struct Stop_cond{
+    int kind;
+    //compartment of STOP_ZERO and STOP_ABOVE, numbered from [STATUS_BEGIN]
+    size_t c;
+    //count of STOP_ABOVE, rate of STOP_RATE or seconds of STOP_WALL
+    double v;
+};
 typedef struct{
     //node of the event
     NINT ns;
@@ -119,22 +216,15 @@ typedef struct{
     //node
     NINT n;
 } Reaction;
-typedef struct{
-    //reactoin list
-    Reaction* reaction;
-    //index fo locate the position of each node
-    NINT* idx;
-    //nodes start from _s, end at _e-1
-    NINT _s;
-    NINT _e;
-    //nodes number V
-    NINT V;
-} Heap;
 
 double gettimenow();
 
 extern int _LOGLVL_;
 int LOG(int loglvl, const char* file, int line, char* format, ...);
+//exit on a fatal error, or jump back to the error boundary of the calling thread if one is set
+void error_exit( int code);
+//set error boundary of the calling thread, NULL to clear, returns the previous one
+jmp_buf* error_boundary( jmp_buf* jb);
 //dump graph
 void dump_graph(Graph* graph);
 //print graph size info
@@ -0,0 +1,539 @@
+#include "gemf.h"
+#include "nrm.h"
+#include "graph_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <stdint.h>
+/*
+ * gemf.c of GEMF in C language
+ * libgemf, see gemf.h
+ *
+ * engine errors call error_exit, which jumps back to the error boundary
+ * set by each entry point below instead of exiting.
+ */
+
+struct gemf_graph{
+    Graph graph;
+};
+struct gemf_model{
+    size_t M;
+    size_t L;
+    //M by M nodal rates, L by M by M edge based rates
+    double* nodal;
+    double* edge;
+    //1 by L, M if not set
+    size_t* inducer;
+};
+struct gemf_run{
+    gemf_graph* graph;
+    //copy of the model
+    Transition tran;
+    Status sts;
+    Run run;
+    //initial state of every round and the state of the current round
+    Sim_state master;
+    Sim_state st;
+    //random streams of the next round, of events and of infector sampling
+    Rng next_rng;
+    Rng next_inf_rng;
+    int infector;
+    size_t round;
+    //user callback of the current round
+    gemf_event_fn fn;
+    void* user;
+    //st is allocated
+    int st_ready;
+    //a round failed, engine state is undefined
+    int broken;
+};
+
+const char* gemf_strerror( int code){
+    switch( code){
+        case GEMF_OK: return "success";
+        case GEMF_ERR_ARG: return "invalid argument";
+        case GEMF_ERR_MEM: return "memory allocation failure";
+        case GEMF_ERR_IO: return "file read failure";
+        case GEMF_ERR_SIM: return "simulation failure";
+    }
+    return "unknown error";
+}
+
+int gemf_graph_create( gemf_graph** graph, unsigned int nodes, size_t layers, int directed, int weighted){
+    gemf_graph* g;
+    Graph* gr;
+    size_t li;
+    if( graph== NULL|| nodes== 0|| layers== 0) return GEMF_ERR_ARG;
+    *graph= NULL;
+    g= (gemf_graph*)calloc( 1, sizeof(gemf_graph));
+    if( g== NULL) return GEMF_ERR_MEM;
+    gr= &g->graph;
+    gr->L= layers;
+    gr->_s= 0;
+    gr->_e= nodes;
+    gr->V= nodes;
+    gr->directed= directed;
+    gr->weighted= weighted;
+    gr->E= (size_t*)calloc( layers, sizeof(size_t));
+    gr->adj= (size_t*)malloc( sizeof(size_t)* layers);
+    gr->offsets= (size_t**)calloc( layers, sizeof(size_t*));
+    gr->targets= (NINT**)calloc( layers, sizeof(NINT*));
+    gr->weights= (double**)calloc( layers, sizeof(double*));
+    if( weighted) gr->edge_w= (Edge_w**)calloc( layers, sizeof(Edge_w*));
+    else gr->edge= (Edge**)calloc( layers, sizeof(Edge*));
+    if( gr->E== NULL|| gr->adj== NULL|| gr->offsets== NULL|| gr->targets== NULL|| gr->weights== NULL|| (gr->edge== NULL&& gr->edge_w== NULL)){
+        gemf_graph_free( g);
+        return GEMF_ERR_MEM;
+    }
+    for( li= 0; li< layers; li++){
+        gr->adj[li]= li;
+    }
+    *graph= g;
+    return GEMF_OK;
+}
+//another layer uses the adjacency of layer
+static int layer_shared( Graph* gr, size_t layer){
+    size_t l;
+    for( l= layer+ 1; l< gr->L; l++){
+        if( gr->adj[l]== layer) return 1;
+    }
+    return 0;
+}
+int gemf_graph_set_layer( gemf_graph* graph, size_t layer, size_t E, const unsigned int* src, const unsigned int* dst, const double* w){
+    Graph* gr;
+    size_t li, copies;
+    if( graph== NULL|| layer>= graph->graph.L|| (E> 0&& (src== NULL|| dst== NULL))) return GEMF_ERR_ARG;
+    gr= &graph->graph;
+    if( gr->map!= NULL|| (gr->weighted&& w== NULL)) return GEMF_ERR_ARG;
+    for( li= 0; li< E; li++){
+        if( src[li]>= gr->_e|| dst[li]>= gr->_e) return GEMF_ERR_ARG;
+    }
+    if( layer_shared( gr, layer)) return GEMF_ERR_ARG;
+    //replace a layer set or shared before
+    graph_reverse_free( gr, layer);
+    if( gr->adj[layer]== layer){
+        free( gr->offsets[layer]);
+        free( gr->targets[layer]);
+        free( gr->weights[layer]);
+    }
+    gr->adj[layer]= layer;
+    gr->offsets[layer]= NULL;
+    gr->targets[layer]= NULL;
+    gr->weights[layer]= NULL;
+    //undirected edges are added in both directions, reversed arcs after the edges
+    copies= gr->directed? 1: 2;
+    gr->E[layer]= copies* E;
+    if( gr->weighted){
+        gr->edge_w[layer]= (Edge_w*)malloc( sizeof(Edge_w)* (copies* E+ 1));
+        if( gr->edge_w[layer]== NULL) return GEMF_ERR_MEM;
+        for( li= 0; li< E; li++){
+            gr->edge_w[layer][li].i= src[li];
+            gr->edge_w[layer][li].j= dst[li];
+            gr->edge_w[layer][li].w= w[li];
+            if( copies> 1){
+                gr->edge_w[layer][E+ li].i= dst[li];
+                gr->edge_w[layer][E+ li].j= src[li];
+                gr->edge_w[layer][E+ li].w= w[li];
+            }
+        }
+    }
+    else{
+        gr->edge[layer]= (Edge*)malloc( sizeof(Edge)* (copies* E+ 1));
+        if( gr->edge[layer]== NULL) return GEMF_ERR_MEM;
+        for( li= 0; li< E; li++){
+            gr->edge[layer][li].i= src[li];
+            gr->edge[layer][li].j= dst[li];
+            if( copies> 1){
+                gr->edge[layer][E+ li].i= dst[li];
+                gr->edge[layer][E+ li].j= src[li];
+            }
+        }
+    }
+    //in-neighbours for infector sampling
+    if( graph_csr_build( gr, layer)< 0|| graph_reverse_build( gr, layer)< 0) return GEMF_ERR_MEM;
+    return GEMF_OK;
+}
+int gemf_graph_share_layer( gemf_graph* graph, size_t layer, size_t from){
+    Graph* gr;
+    if( graph== NULL|| layer>= graph->graph.L|| from>= layer) return GEMF_ERR_ARG;
+    gr= &graph->graph;
+    if( gr->adj[from]!= from|| gr->offsets[from]== NULL|| layer_shared( gr, layer)) return GEMF_ERR_ARG;
+    graph_reverse_free( gr, layer);
+    if( gr->adj[layer]== layer){
+        free( gr->offsets[layer]);
+        free( gr->targets[layer]);
+        free( gr->weights[layer]);
+    }
+    gr->adj[layer]= from;
+    graph_share_layer( gr, layer, from);
+    return graph_reverse_build( gr, layer)< 0? GEMF_ERR_MEM: GEMF_OK;
+}
+int gemf_graph_open( gemf_graph** graph, const char* fil_nam){
+    gemf_graph* g;
+    Graph* gr;
+    jmp_buf jb;
+    jmp_buf* prev;
+    size_t layer;
+    LONG L;
+    if( graph== NULL|| fil_nam== NULL) return GEMF_ERR_ARG;
+    *graph= NULL;
+    L= bin_graph_layers( fil_nam);
+    if( L<= 0) return GEMF_ERR_IO;
+    g= (gemf_graph*)calloc( 1, sizeof(gemf_graph));
+    if( g== NULL) return GEMF_ERR_MEM;
+    gr= &g->graph;
+    gr->L= (size_t)L;
+    gr->offsets= (size_t**)calloc( gr->L, sizeof(size_t*));
+    gr->targets= (NINT**)calloc( gr->L, sizeof(NINT*));
+    gr->weights= (double**)calloc( gr->L, sizeof(double*));
+    if( gr->offsets== NULL|| gr->targets== NULL|| gr->weights== NULL){
+        gemf_graph_free( g);
+        return GEMF_ERR_MEM;
+    }
+    prev= error_boundary( &jb);
+    if( setjmp( jb)){
+        error_boundary( prev);
+        gemf_graph_free( g);
+        return GEMF_ERR_IO;
+    }
+    if( bin_graph_map( fil_nam, gr)< 0|| bin_graph_load( gr)< 0){
+        error_boundary( prev);
+        gemf_graph_free( g);
+        return GEMF_ERR_IO;
+    }
+    for( layer= 0; layer< gr->L; layer++){
+        if( graph_reverse_build( gr, layer)< 0){
+            error_boundary( prev);
+            gemf_graph_free( g);
+            return GEMF_ERR_MEM;
+        }
+    }
+    error_boundary( prev);
+    *graph= g;
+    return GEMF_OK;
+}
+unsigned int gemf_graph_nodes( const gemf_graph* graph){
+    return graph== NULL? 0: graph->graph._e;
+}
+void gemf_graph_free( gemf_graph* graph){
+    Graph* gr;
+    size_t layer;
+    if( graph== NULL) return;
+    gr= &graph->graph;
+    for( layer= 0; layer< gr->L; layer++){
+        //may share the forward arrays, so first
+        if( gr->offsets!= NULL) graph_reverse_free( gr, layer);
+        if( gr->map== NULL&& graph_adj( gr, layer)== layer){
+            if( gr->offsets!= NULL) free( gr->offsets[layer]);
+            if( gr->targets!= NULL) free( gr->targets[layer]);
+            if( gr->weights!= NULL) free( gr->weights[layer]);
+        }
+        if( gr->edge!= NULL) free( gr->edge[layer]);
+        if( gr->edge_w!= NULL) free( gr->edge_w[layer]);
+    }
+    if( gr->map!= NULL) bin_graph_unmap( gr);
+    free( gr->offsets);
+    free( gr->targets);
+    free( gr->weights);
+    free( gr->r_offsets);
+    free( gr->r_sources);
+    free( gr->r_weights);
+    free( gr->adj);
+    free( gr->edge);
+    free( gr->edge_w);
+    free( gr->E);
+    free( graph);
+}
+
+int gemf_model_create( gemf_model** model, size_t M, size_t L){
+    gemf_model* m;
+    size_t layer;
+    if( model== NULL|| M< 1|| M> UINT16_MAX|| L< 1) return GEMF_ERR_ARG;
+    *model= NULL;
+    m= (gemf_model*)calloc( 1, sizeof(gemf_model));
+    if( m== NULL) return GEMF_ERR_MEM;
+    m->M= M;
+    m->L= L;
+    m->nodal= (double*)calloc( M* M, sizeof(double));
+    m->edge= (double*)calloc( L* M* M, sizeof(double));
+    m->inducer= (size_t*)malloc( sizeof(size_t)* L);
+    if( m->nodal== NULL|| m->edge== NULL|| m->inducer== NULL){
+        gemf_model_free( m);
+        return GEMF_ERR_MEM;
+    }
+    for( layer= 0; layer< L; layer++){
+        m->inducer[layer]= M;
+    }
+    *model= m;
+    return GEMF_OK;
+}
+int gemf_model_nodal( gemf_model* model, unsigned int from, unsigned int to, double rate){
+    if( model== NULL|| from>= model->M|| to>= model->M|| from== to|| !(rate>= 0)) return GEMF_ERR_ARG;
+    model->nodal[from* model->M+ to]= rate;
+    return GEMF_OK;
+}
+int gemf_model_edge( gemf_model* model, size_t layer, unsigned int from, unsigned int to, double rate){
+    if( model== NULL|| layer>= model->L|| from>= model->M|| to>= model->M|| from== to|| !(rate>= 0)) return GEMF_ERR_ARG;
+    model->edge[(layer* model->M+ from)* model->M+ to]= rate;
+    return GEMF_OK;
+}
+int gemf_model_inducer( gemf_model* model, size_t layer, unsigned int state){
+    if( model== NULL|| layer>= model->L|| state>= model->M) return GEMF_ERR_ARG;
+    model->inducer[layer]= state;
+    return GEMF_OK;
+}
+void gemf_model_free( gemf_model* model){
+    if( model== NULL) return;
+    free( model->nodal);
+    free( model->edge);
+    free( model->inducer);
+    free( model);
+}
+
+//rows of M rates followed by their sum, the layout of Transition
+static double** rate_matrix( double* rat, size_t M){
+    double** mtx= (double**)calloc( M, sizeof(double*));
+    size_t i, j;
+    if( mtx== NULL) return NULL;
+    for( i= 0; i< M; i++){
+        mtx[i]= (double*)malloc( sizeof(double)* (M+ 1));
+        if( mtx[i]== NULL) return mtx;
+        mtx[i][M]= 0.0;
+        for( j= 0; j< M; j++){
+            mtx[i][j]= rat[i* M+ j];
+            mtx[i][M]+= rat[i* M+ j];
+        }
+    }
+    return mtx;
+}
+static void free_matrix( double** mtx, size_t M){
+    size_t i;
+    if( mtx== NULL) return;
+    for( i= 0; i< M; i++){
+        free( mtx[i]);
+    }
+    free( mtx);
+}
+//Transition of a model, compartments start from 0
+static int tran_build( Transition* tran, gemf_model* model){
+    size_t layer, i;
+    memset( tran, 0, sizeof(Transition));
+    tran->M= model->M;
+    tran->L= model->L;
+    tran->_s= 0;
+    tran->nodal_trn= rate_matrix( model->nodal, model->M);
+    tran->edge_trn= (double***)calloc( model->L, sizeof(double**));
+    tran->inducer_lst= (size_t*)malloc( sizeof(size_t)* model->L);
+    if( tran->nodal_trn== NULL|| tran->edge_trn== NULL|| tran->inducer_lst== NULL) return GEMF_ERR_MEM;
+    for( i= 0; i< model->M; i++){
+        if( tran->nodal_trn[i]== NULL) return GEMF_ERR_MEM;
+    }
+    for( layer= 0; layer< model->L; layer++){
+        tran->edge_trn[layer]= rate_matrix( model->edge+ layer* model->M* model->M, model->M);
+        if( tran->edge_trn[layer]== NULL) return GEMF_ERR_MEM;
+        for( i= 0; i< model->M; i++){
+            if( tran->edge_trn[layer][i]== NULL) return GEMF_ERR_MEM;
+        }
+        tran->inducer_lst[layer]= model->inducer[layer];
+    }
+    init_trn_table( tran);
+    return GEMF_OK;
+}
+static void tran_free( Transition* tran){
+    size_t layer;
+    free_matrix( tran->nodal_trn, tran->M);
+    if( tran->edge_trn!= NULL){
+        for( layer= 0; layer< tran->L; layer++){
+            free_matrix( tran->edge_trn[layer], tran->M);
+        }
+        free( tran->edge_trn);
+    }
+    free_matrix( tran->trn_table, tran->M);
+    free( tran->inducer_lst);
+}
+
+int gemf_run_create( gemf_run** run, gemf_graph* graph, gemf_model* model, const unsigned int* states){
+    gemf_run* r;
+    Graph* gr;
+    jmp_buf jb;
+    jmp_buf* prev;
+    size_t layer;
+    NINT n;
+    int ret;
+
+    if( run== NULL|| graph== NULL|| model== NULL|| states== NULL) return GEMF_ERR_ARG;
+    *run= NULL;
+    gr= &graph->graph;
+    if( model->L!= gr->L) return GEMF_ERR_ARG;
+    //every layer set, a layer without inducer has no edge based transitions
+    for( layer= 0; layer< gr->L; layer++){
+        if( gr->offsets[layer]== NULL) return GEMF_ERR_ARG;
+    }
+    for( n= gr->_s; n< gr->_e; n++){
+        if( states[n]>= model->M) return GEMF_ERR_ARG;
+    }
+    r= (gemf_run*)calloc( 1, sizeof(gemf_run));
+    if( r== NULL) return GEMF_ERR_MEM;
+    r->graph= graph;
+    r->broken= 1;
+    //allocation failures in the engine jump back here
+    prev= error_boundary( &jb);
+    if( setjmp( jb)){
+        error_boundary( prev);
+        gemf_run_free( r);
+        return GEMF_ERR_MEM;
+    }
+    ret= tran_build( &r->tran, model);
+    if( ret!= GEMF_OK){
+        error_boundary( prev);
+        gemf_run_free( r);
+        return ret;
+    }
+    //status
+    r->sts.M= model->M;
+    r->sts._s= 0;
+    r->sts._node_s= gr->_s;
+    r->sts._node_e= gr->_e;
+    r->sts._node_V= gr->_e- gr->_s;
+    r->sts.init_lst= (size_t*)calloc( gr->_e, sizeof(size_t));
+    r->sts.init_cnt= (NINT*)calloc( model->M, sizeof(NINT));
+    if( r->sts.init_lst== NULL|| r->sts.init_cnt== NULL){
+        error_boundary( prev);
+        gemf_run_free( r);
+        return GEMF_ERR_MEM;
+    }
+    for( n= gr->_s; n< gr->_e; n++){
+        r->sts.init_lst[n]= states[n];
+        r->sts.init_cnt[states[n]]++;
+    }
+    //options, one silent round per call
+    r->run.max_time= DBL_MAX;
+    r->run.max_events= SIZE_MAX;
+    r->run.sim_rounds= 1;
+    r->run.scheduler= SCHED_HEAP;
+    r->run.heap_arity= HEAP_ARITY_DEFAULT;
+    r->run.quiet= 1;
+    gemf_run_seed( r, 0, NULL);
+
+    //initial rates and the state of a round
+    r->master.init_lst= r->sts.init_lst;
+    r->master.init_cnt= r->sts.init_cnt;
+    r->master.p_inducer_cal_lst= init_inducer( gr, &r->sts, &r->tran);
+    r->master.R= get_rat_lst( gr, &r->tran, &r->sts, &r->master.p_raw_rat_lst, r->master.p_inducer_cal_lst);
+    sim_state_init( &r->st, gr, &r->sts, &r->run);
+    r->st_ready= 1;
+    error_boundary( prev);
+    r->broken= 0;
+    *run= r;
+    return GEMF_OK;
+}
+int gemf_run_seed( gemf_run* run, uint64_t seed, const char* rng){
+    int kind= RNG_XOSHIRO;
+    if( run== NULL) return GEMF_ERR_ARG;
+    if( rng!= NULL){
+        kind= rng_kind( rng);
+        if( kind< 0) return GEMF_ERR_ARG;
+    }
+    rng_seed( &run->next_rng, kind, seed);
+    //infector streams split along with the event streams
+    rng_infector( &run->next_rng, &run->next_inf_rng);
+    run->round= 0;
+    return GEMF_OK;
+}
+int gemf_run_limits( gemf_run* run, double max_time, size_t max_events){
+    if( run== NULL|| !(max_time>= 0)) return GEMF_ERR_ARG;
+    run->run.max_time= max_time;
+    run->run.max_events= max_events;
+    return GEMF_OK;
+}
+int gemf_run_scheduler( gemf_run* run, const char* scheduler, int arity){
+    jmp_buf jb;
+    jmp_buf* prev;
+    int sched= SCHED_HEAP;
+    if( run== NULL|| run->broken) return GEMF_ERR_ARG;
+    if( scheduler!= NULL) sched= heap_scheduler( scheduler);
+    if( arity== 0) arity= HEAP_ARITY_DEFAULT;
+    if( sched< 0|| heap_arity( arity)< 0) return GEMF_ERR_ARG;
+    prev= error_boundary( &jb);
+    if( setjmp( jb)){
+        error_boundary( prev);
+        run->broken= 1;
+        return GEMF_ERR_MEM;
+    }
+    heap_free( &run->st.heap);
+    run->run.scheduler= sched;
+    run->run.heap_arity= arity;
+    heap_init( &run->st.heap, &run->graph->graph, sched, arity);
+    error_boundary( prev);
+    return GEMF_OK;
+}
+int gemf_run_infector( gemf_run* run, int on){
+    if( run== NULL) return GEMF_ERR_ARG;
+    run->infector= on;
+    return GEMF_OK;
+}
+//event hook of sim_round, calls the user callback
+static int run_event( Sim_state* st, double t, Event* evt, void* arg){
+    gemf_run* run= (gemf_run*)arg;
+    gemf_event e;
+    if( run->fn== NULL) return 0;
+    e.t= t;
+    e.R= st->R;
+    e.node= evt->ns;
+    e.from= (unsigned int)evt->ni;
+    e.to= (unsigned int)evt->nj;
+    e.infector= GEMF_NO_INFECTOR;
+    if( run->infector){
+        e.infector= sample_infector( &run->graph->graph, &run->tran, st, evt, &st->inf_rng);
+    }
+    e.counts= st->init_cnt;
+    e.count= st->count;
+    return run->fn( &e, run->user);
+}
+int gemf_run_simulate( gemf_run* run, gemf_event_fn fn, void* user){
+    jmp_buf jb;
+    jmp_buf* prev;
+    int ret;
+    if( run== NULL|| run->broken) return GEMF_ERR_ARG;
+    run->fn= fn;
+    run->user= user;
+    run->round++;
+    prev= error_boundary( &jb);
+    if( setjmp( jb)){
+        error_boundary( prev);
+        run->broken= 1;
+        return GEMF_ERR_SIM;
+    }
+    //restore initial states, then simulate with the stream of this round
+    sim_state_copy( &run->st, &run->master, &run->graph->graph, &run->sts);
+    rng_split( &run->next_rng, &run->st.rng);
+    rng_split( &run->next_inf_rng, &run->st.inf_rng);
+    run->st.hook= run_event;
+    run->st.hook_arg= run;
+    ret= sim_round( &run->graph->graph, &run->tran, &run->sts, &run->run, &run->st, run->round, NULL, NULL);
+    error_boundary( prev);
+    if( ret< 0){
+        run->broken= 1;
+        return GEMF_ERR_SIM;
+    }
+    return GEMF_OK;
+}
+void gemf_run_free( gemf_run* run){
+    size_t layer;
+    if( run== NULL) return;
+    if( run->st_ready){
+        sim_state_free( &run->st, &run->graph->graph, &run->sts);
+    }
+    if( run->master.p_inducer_cal_lst!= NULL){
+        for( layer= 0; layer< run->graph->graph.L; layer++){
+            free( run->master.p_inducer_cal_lst[layer]);
+        }
+        free( run->master.p_inducer_cal_lst);
+    }
+    free( run->master.p_raw_rat_lst);
+    free( run->sts.init_lst);
+    free( run->sts.init_cnt);
+    tran_free( &run->tran);
+    free( run);
+}
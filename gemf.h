@@ -0,0 +1,148 @@
+#ifndef GEMFH
+#define GEMFH
+
+#include <stddef.h>
+#include <stdint.h>
+/*
+ * gemf.h of GEMF in C language
+ * libgemf, the simulation engine as an embeddable library
+ *
+ * a graph holds the contact network of all layers, a model the transition
+ * rates, a run the initial states and options of a simulation. each call
+ * of gemf_run_simulate simulates one round from the initial states with the
+ * next random stream, round r using the stream after r-1 jumps from the
+ * seed as the GEMF program does, and passes every event to a callback.
+ *
+ * a run copies what it needs from its model, but reads its graph, so a
+ * graph must outlive its runs and is not changed while they exist; one
+ * graph can be shared by runs simulated in different threads.
+ * no function exits the process or writes events, errors are returned as
+ * GEMF_ERR_* codes; a run that failed in the engine can only be freed.
+ *
+ * nodes are numbered from 0 for graphs built in memory, compartments from 0.
+ * a directed graph also keeps its reverse adjacency, for infector sampling.
+ */
+
+#define GEMF_OK 0
+//infector of a nodal transition, or if not sampled
+#define GEMF_NO_INFECTOR 0xFFFFFFFFu
+
+//invalid argument
+#define GEMF_ERR_ARG -1
+//memory allocation failure
+#define GEMF_ERR_MEM -2
+//file read failure
+#define GEMF_ERR_IO -3
+//simulation failure
+#define GEMF_ERR_SIM -4
+
+typedef struct gemf_graph gemf_graph;
+typedef struct gemf_model gemf_model;
+typedef struct gemf_run gemf_run;
+
+typedef struct{
+    //time of the event
+    double t;
+    //total rate before the event, as in the text output
+    double R;
+    //node and its compartment change
+    unsigned int node;
+    unsigned int from;
+    unsigned int to;
+    //in-neighbour that caused an edge based transition, see gemf_run_infector
+    unsigned int infector;
+    //population of each compartment after the event, M items
+    const unsigned int* counts;
+    //events of this round so far, this one included
+    size_t count;
+} gemf_event;
+
+//event callback, a nonzero return stops the round
+typedef int (*gemf_event_fn)( const gemf_event* evt, void* user);
+
+/*
+ *create graph with empty layers, nodes 0 ... nodes-1
+ *
+ *input:  unsigned int nodes     [ number of nodes]
+ *        size_t       layers    [ number of layers]
+ *        int          directed  [ 0: every edge is added in both directions]
+ *        int          weighted  [ 0: unweighted, otherwise weighted]
+ *output: gemf_graph** graph
+ *return: int   [GEMF_OK or GEMF_ERR_*]
+ */
+int gemf_graph_create( gemf_graph** graph, unsigned int nodes, size_t layers, int directed, int weighted);
+/*
+ *set edges of a layer, src[k]->dst[k] with weight w[k], arrays are copied
+ *
+ *input:  size_t  layer   [ layer, 0 ... layers-1]
+ *        size_t  E       [ number of edges]
+ *        const unsigned int* src, dst   [ E nodes each]
+ *        const double* w  [ E weights, NULL for unweighted graphs]
+ *return: int   [GEMF_OK or GEMF_ERR_*]
+ */
+int gemf_graph_set_layer( gemf_graph* graph, size_t layer, size_t E, const unsigned int* src, const unsigned int* dst, const double* w);
+/*
+ *use the edges of an earlier layer for layer too, stored once and swept once
+ *per event for all layers sharing them; a layer shared by others can not
+ *be set or shared again
+ *
+ *input:  size_t  layer   [ layer]
+ *        size_t  from    [ layer with its own edges set, from< layer]
+ *return: int   [GEMF_OK or GEMF_ERR_*]
+ */
+int gemf_graph_share_layer( gemf_graph* graph, size_t layer, size_t from);
+//map a binary graph file written by GEMF convert, node numbers as in the file
+int gemf_graph_open( gemf_graph** graph, const char* fil_nam);
+//length of a state array for this graph, largest node+ 1
+unsigned int gemf_graph_nodes( const gemf_graph* graph);
+void gemf_graph_free( gemf_graph* graph);
+
+/*
+ *create model of M compartments on L layers, all rates 0
+ *
+ *input:  size_t  M   [ number of compartments]
+ *        size_t  L   [ number of layers]
+ *output: gemf_model** model
+ *return: int   [GEMF_OK or GEMF_ERR_*]
+ */
+int gemf_model_create( gemf_model** model, size_t M, size_t L);
+//rate of nodal transition from -> to
+int gemf_model_nodal( gemf_model* model, unsigned int from, unsigned int to, double rate);
+//rate of edge based transition from -> to of layer, per inducer neighbour
+int gemf_model_edge( gemf_model* model, size_t layer, unsigned int from, unsigned int to, double rate);
+//inducer compartment of layer, edge based rates of a layer without inducer have no effect
+int gemf_model_inducer( gemf_model* model, size_t layer, unsigned int state);
+void gemf_model_free( gemf_model* model);
+
+/*
+ *create run of model on graph
+ *
+ *input:  gemf_graph* graph
+ *        gemf_model* model    [ copied, may be changed or freed afterwards]
+ *        const unsigned int* states   [ initial compartment of each node, gemf_graph_nodes items]
+ *output: gemf_run** run
+ *return: int   [GEMF_OK or GEMF_ERR_*]
+ */
+int gemf_run_create( gemf_run** run, gemf_graph* graph, gemf_model* model, const unsigned int* states);
+//random seed and generator, "xoshiro256pp" (default) or "philox4x32", restarts from round 1
+int gemf_run_seed( gemf_run* run, uint64_t seed, const char* rng);
+//stop a round at time max_time or after max_events events, no limit by default
+int gemf_run_limits( gemf_run* run, double max_time, size_t max_events);
+//event scheduler, "heap" (default, or NULL), "calendar", "direct" or "rejection", and heap arity 2, 4 (default, or 0) or 8
+int gemf_run_scheduler( gemf_run* run, const char* scheduler, int arity);
+//sample the infector of each event (default 0), from random streams of their own, so events do not change
+int gemf_run_infector( gemf_run* run, int on);
+/*
+ *simulate the next round, from the initial states
+ *
+ *input:  gemf_event_fn fn    [ called on each event, may be NULL]
+ *        void*         user  [ passed to fn]
+ *return: int   [GEMF_OK or GEMF_ERR_*]
+ */
+int gemf_run_simulate( gemf_run* run, gemf_event_fn fn, void* user);
+void gemf_run_free( gemf_run* run);
+
+//message of an error code
+const char* gemf_strerror( int code);
+
+#endif
@@ -1,11 +1,16 @@
 #include "nrm.h"
 #include "common.h"
 #include "para.h"
+#include "rng.h"
+#include "graph_io.h"
+#include "ckpt.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <limits.h>
 /*
  * main function of GEMF in C language
  * Futing Fan
@@ -20,26 +25,38 @@
 /*
  * main
  */
-int _LOGLVL_;
 void init_graph(Graph* graph, int echo);
 void del_graph(Graph* graph);
 void del_transition(Transition* tran);
 void del_status(Status* sts);
 void del_run(Run* run);
-void load_graph(FILE* fil_para, Graph* graph);
-void pre_init_graph(FILE* fil_para, Graph* graph);
+void load_graph(FILE* fil_para, Graph* graph, size_t threads, Perf* perf);
+void pre_init_graph(FILE* fil_para, Graph* graph, size_t threads);
 void init_para(FILE* fil_para, Graph* graph, Transition* tran, Status* sts, Run* run, int echo);
 void initi_status(FILE* fil_para, Graph* graph, Status* sts, int echo);
+int convert(int argc, char* argv[]);
+int decode(int argc, char* argv[]);
 int main(int argc,char* argv[] ) {
     FILE* fil_para= NULL;
     int ret;
     int echo= 1;
+    int k;
+    char* resume= NULL;
     Graph graph;
     Transition tran;
     Status sts;
     Run run;
+    double t0= gettimenow();
 
     _LOGLVL_= 0;
+    if( argc> 1&& !strcmp(argv[1], "convert")){
+        return convert( argc, argv);
+    }
+    if( argc> 1&& !strcmp(argv[1], "decode")){
+        return decode( argc, argv);
+    }
+    memset( &graph, 0, sizeof(Graph));
+    memset( &run, 0, sizeof(Run));
     if( argc< 2){
         fil_para= fopen( "para.txt", "r");
         if( fil_para== NULL){
@@ -53,22 +70,26 @@ int main(int argc,char* argv[] ) {
             printf(" para file [%s] read error\n", argv[1]);
             return -1;
         }
-        if( argc>2){
-            if( !strcmp(argv[2], "DEBUG")){
+        for( k= 2; k< argc; k++){
+            if( !strcmp(argv[k], "DEBUG")){
                 _LOGLVL_= 2;
             }
-            else if( !strcmp(argv[2], "TRACE")){
+            else if( !strcmp(argv[k], "TRACE")){
                 _LOGLVL_= 1;
             }
+            else if( !strcmp(argv[k], "--resume")&& k+ 1< argc){
+                resume= argv[++k];
+            }
         }
     }
 
 
     //initialize running conditions
     init_para(fil_para, &graph, &tran, &sts, &run, echo);
+    run.resume= resume;
 
     //pre initialize graph, basically all kinds of sizes
-    pre_init_graph(fil_para, &graph);
+    pre_init_graph(fil_para, &graph, run.threads);
 
     //initialize graph, memory allocation
     init_graph(&graph, echo);
@@ -78,7 +99,11 @@ int main(int argc,char* argv[] ) {
     initi_status( fil_para, &graph, &sts, echo);
     //dump_status(&sts);
 
-    load_graph(fil_para, &graph);
+    load_graph(fil_para, &graph, run.threads, run.perf);
+    //parsing is all of reading in, but building adjacency
+    if( run.perf!= NULL){
+        perf_phase( run.perf, PERF_PARSE, gettimenow()- t0- run.perf->phase[PERF_BUILD]);
+    }
 
     //run simulation
     ret= nrm( &graph, &tran, &sts, &run);
@@ -98,49 +123,86 @@ int main(int argc,char* argv[] ) {
     del_run(&run);
     return 0;
 }
+/*
+ * decode a binary event log to the text output format
+ * usage: GEMF decode <event log> [text file]
+ */
+int decode(int argc, char* argv[]){
+    if( argc< 3){
+        printf("usage: %s decode <event log> [text file]\n", argv[0]);
+        return -1;
+    }
+    return evt_log_decode( argv[2], argc> 3? argv[3]: NULL)< 0? -1: 0;
+}
+/*
+ * convert text network files of a para file to one binary graph file
+ * usage: GEMF convert <para file> <binary graph file>
+ */
+int convert(int argc, char* argv[]){
+    FILE* fil_para= NULL;
+    Graph graph;
+    Transition tran;
+    Status sts;
+    Run run;
+    int ret= -1;
+
+    if( argc< 4){
+        printf("usage: %s convert <para file> <binary graph file>\n", argv[0]);
+        return -1;
+    }
+    fil_para= fopen( argv[2], "r");
+    if( fil_para== NULL){
+        printf(" para file [%s] read error\n", argv[2]);
+        return -1;
+    }
+    memset( &graph, 0, sizeof(Graph));
+    memset( &run, 0, sizeof(Run));
+    init_para(fil_para, &graph, &tran, &sts, &run, 0);
+    pre_init_graph(fil_para, &graph, run.threads);
+    if( graph.map!= NULL){
+        printf("[DATA_FILE] of [%s] is already a binary graph file\n", argv[2]);
+        goto done;
+    }
+    init_graph(&graph, 1);
+    load_graph(fil_para, &graph, run.threads, NULL);
+    prepare_graph(&graph);
+    if( bin_graph_write( argv[3], &graph)< 0){
+        goto done;
+    }
+    printf("binary graph file[%s] written, use it as the only [DATA_FILE] item\n", argv[3]);
+    ret= 0;
+done:
+    //every exit after the para file is read frees what it loaded
+    fclose(fil_para);
+    del_graph(&graph);
+    del_transition(&tran);
+    del_run(&run);
+    return ret;
+}
 void init_graph(Graph* graph, int echo){
-    size_t memo_size, layer;
     LOG(1, __FILE__, __LINE__, "Init graph begin\n");
-    graph->edge= NULL;
-    graph->edge_w= NULL;
-    graph->index= NULL;
-    if( graph->weighted){
-        graph->edge_w= (Edge_w**)malloc(sizeof(Edge_w*)*graph->L);
+    //adjacency of each layer, built by load_graph or pointing into a binary graph file
+    graph->offsets= (size_t**)calloc(graph->L, sizeof(size_t*));
+    graph->targets= (NINT**)calloc(graph->L, sizeof(NINT*));
+    graph->weights= (double**)calloc(graph->L, sizeof(double*));
+    if( graph->offsets== NULL|| graph->targets== NULL|| graph->weights== NULL){
+        printf("Memory allocation failure for network list, size[%zu]\n", sizeof(double*)*graph->L);
+        exit( - 1);
+    }
+    //edge lists of text layers are owned by the parser, allocated by pre_init_graph or load_graph
+    if( graph->map== NULL&& graph->weighted&& graph->edge_w== NULL){
+        graph->edge_w= (Edge_w**)calloc(graph->L, sizeof(Edge_w*));
         if( graph->edge_w== NULL){
             printf("Memory allocation failure for network list, size[%zu]\n", sizeof(Edge_w*)*graph->L);
             exit( - 1);
         }
-        for( layer= 0; layer< graph->L; layer++){
-            memo_size= ((size_t)(2 - graph->directed))*(graph->E[layer]);
-            if( memo_size< graph->E[layer]){
-                printf(" Arithematic overflow layer[%zu], size [%d]*[%zu]\n", layer, 2 - graph->directed, graph->E[layer]);
-                exit( - 1);
-            }
-            graph->edge_w[layer]= (Edge_w*)malloc(sizeof(Edge_w)*memo_size);
-            if( graph->edge_w[layer]== NULL){
-                printf("Memory allocation failure for layer[%zu], size[%zu]\n", layer, sizeof(Edge_w)*memo_size);
-                exit( - 1);
-            }
-        }
     }
-    else{
-        graph->edge= (Edge**)malloc(sizeof(Edge*)*graph->L);
+    if( graph->map== NULL&& !graph->weighted&& graph->edge== NULL){
+        graph->edge= (Edge**)calloc(graph->L, sizeof(Edge*));
         if( graph->edge== NULL){
             printf("Memory allocation failure for network list, size[%zu]\n", sizeof(Edge*)*graph->L);
             exit( - 1);
         }
-        for( layer= 0; layer< graph->L; layer++){
-            memo_size= ((size_t)(2 - graph->directed))*(graph->E[layer]);
-            if( memo_size< graph->E[layer]){
-                printf(" Arithematic overflow layer[%zu], size [%d]*[%zu]\n", layer, 2 - graph->directed, graph->E[layer]);
-                exit( - 1);
-            }
-            graph->edge[layer]= (Edge*)malloc(sizeof(Edge)*memo_size);
-            if( graph->edge[layer]== NULL){
-                printf("Memory allocation failure for layer[%zu], size[%zu]\n", layer, sizeof(Edge)*memo_size);
-                exit( - 1);
-            }
-        }
     }
     LOG(1, __FILE__, __LINE__, "Init graph end\n");
     if(echo){
@@ -148,13 +210,14 @@ void init_graph(Graph* graph, int echo){
     }
 }
 void del_graph(Graph* graph){
-    int layer;
+    size_t layer;
     if( graph->edge!= NULL){
         for( layer= 0; layer< graph->L; layer++){
             if( graph->edge[layer]!= NULL){
                 free(graph->edge[layer]);
             }
         }
+        free( graph->edge);
         graph->edge= NULL;
     }
     if( graph->edge_w!= NULL){
@@ -163,20 +226,43 @@ void del_graph(Graph* graph){
                 free(graph->edge_w[layer]);
             }
         }
+        free( graph->edge_w);
         graph->edge_w= NULL;
     }
     if( graph->E!= NULL){
         free( graph->E);
         graph->E= NULL;
     }
-    if( graph->index!= NULL){
+    //reverse adjacency may share the forward arrays, free it first
+    if( graph->r_offsets!= NULL){
         for( layer= 0; layer< graph->L; layer++){
-            if( graph->index[layer]!= NULL){
-                free(graph->index[layer]);
-            }
+            graph_reverse_free( graph, layer);
         }
-        free( graph->index);
+        free( graph->r_offsets);
+        free( graph->r_sources);
+        free( graph->r_weights);
+        graph->r_offsets= NULL;
+        graph->r_sources= NULL;
+        graph->r_weights= NULL;
     }
+    if( graph->offsets!= NULL){
+        //adjacency of a binary graph file is part of the map
+        for( layer= 0; graph->map== NULL&& layer< graph->L; layer++){
+            if( graph_adj( graph, layer)!= layer) continue;
+            free( graph->offsets[layer]);
+            free( graph->targets[layer]);
+            free( graph->weights[layer]);
+        }
+        free( graph->offsets);
+        free( graph->targets);
+        free( graph->weights);
+        graph->offsets= NULL;
+        graph->targets= NULL;
+        graph->weights= NULL;
+    }
+    free( graph->adj);
+    graph->adj= NULL;
+    bin_graph_unmap( graph);
 }
 void del_transition(Transition* tran){
     size_t i, layer;
@@ -204,6 +290,12 @@ void del_transition(Transition* tran){
     if( tran->inducer_lst!= NULL){
         free( tran->inducer_lst);
     }
+    if( tran->trn_table!= NULL){
+        for( i= tran->_s; i< tran->M+ tran->_s; i++){
+            free( tran->trn_table[i]);
+        }
+        free( tran->trn_table);
+    }
 }
 void del_status(Status* sts){
     if( sts->init_lst!= NULL){
@@ -215,87 +307,82 @@ void del_status(Status* sts){
 }
 void del_run(Run* run){
     if( run->out_file!= NULL) free (run->out_file);
+    if( run->stats_file!= NULL) free (run->stats_file);
+    free( run->stop);
+    perf_close( run->perf);
+    ckpt_close( run->ckpt);
 }
-void load_graph(FILE* fil_para, Graph* graph){
+void load_graph(FILE* fil_para, Graph* graph, size_t threads, Perf* perf){
     printf("Reading network...\n");
-    FILE* fil_dat= NULL;
     char* fil_nam= NULL;
-    NINT tr, i, j;
-    int ret;
-    size_t li, layer;
-    double t0= gettimenow();
+    Text_layer tl;
+    Edge* ed;
+    Edge_w* ed_w;
+    NINT i, j;
+    size_t li, layer, files;
+    double t0= gettimenow(), t1;
+    //mapped binary graph file, no parsing
+    if( graph->map!= NULL){
+        if( bin_graph_load( graph)< 0){
+            exit( -1);
+        }
+        time_print( "initial time cost[ ", gettimenow() - t0, " ]\n");
+        return;
+    }
     //read in network matrix [i j weight]
-    locate_section( fil_para, "[DATA_FILE]");
     fil_nam= (char*)malloc(sizeof(char)*MAX_LINE_LEN);
+    files= (size_t)item_count( fil_para, "[DATA_FILE]");
+    locate_section( fil_para, "[DATA_FILE]");
     for(layer=0; layer< graph->L; layer++){
         LOG(2, __FILE__, __LINE__, "Read layer[%d]\n", layer+ 1);
-        fget_next_item( fil_para, fil_nam, MAX_LINE_LEN);
-        fil_dat= fopen( fil_nam, "r");
-        if( fil_dat== NULL){
-            printf("Read file[%s] error\n", fil_nam);
-            exit( -1);
+        if( layer< files) fget_next_item( fil_para, fil_nam, MAX_LINE_LEN);
+        //same network as an earlier layer, nothing to read or store
+        if( graph_adj( graph, layer)!= layer){
+            graph_share_layer( graph, layer, graph_adj( graph, layer));
+            printf("layer[%zu] shares the network of layer[%zu]\n", layer+ 1, graph_adj( graph, layer)+ 1);
+            continue;
         }
-        //skip comment lines on top
-        skip_top_comment( fil_dat, '#');
-        //weighted
-        if( graph->weighted){
-            LOG(2, __FILE__, __LINE__, "Read weighted network\n");
-            for ( li= 0; li< graph->E[layer]; li++) {
-                if (!(li % 10000000)&& li) {
-                    time_print("[", gettimenow() - t0, " ]\t");
-                    printf("layer[%zu] ", layer+ 1);
-                    kilobit_print("[ ", (LONG)li, "/");
-                    kilobit_print("", (LONG)graph->E[layer], " ] edges get\n");
-                }
-                ret= fscanf( fil_dat, fmt_n fmt_n " %lf", &i, &j, &(graph->edge_w[layer][li].w));
-                if( ret != 3){
-                    printf("Error! Expecting 3 columns, getting %d\n", ret);
-                    exit(-1);
-                }
-                if( i< graph->_s || i> graph->_e){
-                    printf("node["fmt_n"of layer[%zu]edge[%zu] out of range["fmt_n"/"fmt_n"]\n", i, layer, li, graph->_s, graph->_e);
-                }
-                if( j< graph->_s || j> graph->_e){
-                    printf("node["fmt_n"of layer[%zu]edge[%zu] out of range["fmt_n"/"fmt_n"]\n", j, layer, li, graph->_s, graph->_e);
-                }
-                graph->edge_w[layer][li].i= i;
-                graph->edge_w[layer][li].j= j;
-                if( !graph->directed){
-                    graph->edge_w[layer][graph->E[layer]+ li]= graph->edge_w[layer][li];
-                    tr= graph->edge_w[layer][graph->E[layer]+ li].i;
-                    graph->edge_w[layer][graph->E[layer]+ li].i= graph->edge_w[layer][graph->E[layer]+ li].j;
-                    graph->edge_w[layer][graph->E[layer]+ li].j= tr;
-                }
+        //layer parsed by pre_init_graph already
+        if( graph->weighted? graph->edge_w[layer]== NULL: graph->edge[layer]== NULL){
+            if( text_graph_parse( fil_nam, (size_t)(2 - graph->directed), threads, &tl)< 0){
+                exit( -1);
+            }
+            if( tl.weighted!= graph->weighted){
+                printf("Error! Expecting %d columns, getting %d in file[%s]\n", 2+ graph->weighted, 2+ tl.weighted, fil_nam);
+                exit( -1);
             }
+            if( tl.E< graph->E[layer]){
+                printf("Error! Expecting [%zu] edges, getting [%zu] in file[%s]\n", graph->E[layer], tl.E, fil_nam);
+                exit( -1);
+            }
+            if( graph->weighted) graph->edge_w[layer]= (Edge_w*)tl.edge;
+            else graph->edge[layer]= (Edge*)tl.edge;
         }
-        //unweighted
-        else{
-            LOG(2, __FILE__, __LINE__, "Read unweighted network\n");
-            for ( li= 0; li< graph->E[layer]; li++) {
-                if (!(li % 10000000)&& li) {
-                    time_print("[", gettimenow() - t0, " ]\t");
-                    printf("layer[%zu] ", layer+ 1);
-                    kilobit_print("[ ", (LONG)li, "/");
-                    kilobit_print("", (LONG)graph->E[layer], " ] edges get\n");
-                }
-                ret= fscanf( fil_dat, fmt_n fmt_n , &i, &j);
-                if( ret != 2){
-                    printf("Error! Expecting 2 columns, getting %d\n", ret);
-                    exit(-1);
-                }
-                if( i< graph->_s || i> graph->_e){
-                    printf("node["fmt_n"of layer[%zu]edge[%zu] out of range["fmt_n"/"fmt_n"]\n", i, layer, li, graph->_s, graph->_e);
-                }
-                if( j< graph->_s || j> graph->_e){
-                    printf("node["fmt_n"of layer[%zu]edge[%zu] out of range["fmt_n"/"fmt_n"]\n", j, layer, li, graph->_s, graph->_e);
+        ed= graph->weighted? NULL: graph->edge[layer];
+        ed_w= graph->weighted? graph->edge_w[layer]: NULL;
+        for ( li= 0; li< graph->E[layer]; li++) {
+            i= graph->weighted? ed_w[li].i: ed[li].i;
+            j= graph->weighted? ed_w[li].j: ed[li].j;
+            if( i< graph->_s || i> graph->_e){
+                printf("node["fmt_n"of layer[%zu]edge[%zu] out of range["fmt_n"/"fmt_n"]\n", i, layer, li, graph->_s, graph->_e);
+            }
+            if( j< graph->_s || j> graph->_e){
+                printf("node["fmt_n"of layer[%zu]edge[%zu] out of range["fmt_n"/"fmt_n"]\n", j, layer, li, graph->_s, graph->_e);
+            }
+        }
+        //reversed arcs of undirected graph
+        if( !graph->directed){
+            if( graph->weighted){
+                for ( li= 0; li< graph->E[layer]; li++) {
+                    ed_w[graph->E[layer]+ li].i= ed_w[li].j;
+                    ed_w[graph->E[layer]+ li].j= ed_w[li].i;
+                    ed_w[graph->E[layer]+ li].w= ed_w[li].w;
                 }
-                graph->edge[layer][li].i= i;
-                graph->edge[layer][li].j= j;
-                if( !graph->directed){
-                    graph->edge[layer][graph->E[layer]+ li]= graph->edge[layer][li];
-                    tr= graph->edge[layer][graph->E[layer]+ li].i;
-                    graph->edge[layer][graph->E[layer]+ li].i= graph->edge[layer][graph->E[layer]+ li].j;
-                    graph->edge[layer][graph->E[layer]+ li].j= tr;
+            }
+            else{
+                for ( li= 0; li< graph->E[layer]; li++) {
+                    ed[graph->E[layer]+ li].i= ed[li].j;
+                    ed[graph->E[layer]+ li].j= ed[li].i;
                 }
             }
         }
@@ -306,23 +393,84 @@ void load_graph(FILE* fil_para, Graph* graph){
         if( !graph->directed){
             graph->E[layer]+=  graph->E[layer];
         }
-
-        fclose(fil_dat);
+        //CSR adjacency replaces the edge list
+        t1= gettimenow();
+        if( graph_csr_build( graph, layer)< 0){
+            exit( -1);
+        }
+        perf_phase( perf, PERF_BUILD, gettimenow()- t1);
     }
     time_print( "initial time cost[ ", gettimenow() - t0, " ]\n");
     free(fil_nam);
 }
-void pre_init_graph(FILE* fil_para, Graph* graph){
+void pre_init_graph(FILE* fil_para, Graph* graph, size_t threads){
     LINE str;
-    size_t layer;
+    size_t layer, files;
     LONG val;
-    //scan all network files, analysis metrics
-    if( item_count( fil_para, "[NETWORK_INFO]")< (int)(2+ graph->L )){
-        //missing NETWORK_INFO section or section incomplete, analysis from all network file
+    Text_layer tl;
+    NINT _begin_num, _end_num;
+    //binary graph file, all sizes from its header
+    locate_section( fil_para, "[DATA_FILE]");
+    fget_next_item( fil_para, str, MAX_LINE_LEN);
+    if( bin_graph_layers( str)> 0){
+        printf("Map binary graph file[%s]\n", str);
+        if( bin_graph_map( str, graph)< 0)
+            exit(-1);
+        return;
+    }
+    graph->E= (size_t*)malloc(sizeof(size_t)*graph->L);
+    if( graph->E== NULL){
+        printf("Memory allocation failure for edges number list, size[%zu]\n", sizeof(size_t)*graph->L);
+        exit( - 1);
+    }
+    //scan all network files, analysis metrics, one count per [DATA_FILE] item
+    files= (size_t)item_count( fil_para, "[DATA_FILE]");
+    if( item_count( fil_para, "[NETWORK_INFO]")< (int)(2+ files)){
+        //missing NETWORK_INFO section or section incomplete, parse all network files once and keep the edges
         printf("Analysis network info automaticly\n");
         locate_section( fil_para, "[DATA_FILE]");
-        if( analysis_network( fil_para, graph)< 0)
-            exit(-1);
+        graph->edge= (Edge**)calloc(graph->L, sizeof(Edge*));
+        graph->edge_w= (Edge_w**)calloc(graph->L, sizeof(Edge_w*));
+        if( graph->edge== NULL|| graph->edge_w== NULL){
+            printf("Memory allocation failure for network list, size[%zu]\n", sizeof(Edge_w*)*graph->L);
+            exit( - 1);
+        }
+        _begin_num= UINT_MAX;
+        _end_num= 0;
+        for( layer= 0; layer< graph->L; layer++){
+            if( layer< files) fget_next_item( fil_para, str, MAX_LINE_LEN);
+            //parsed once for all layers sharing it
+            if( graph_adj( graph, layer)!= layer){
+                graph->E[layer]= graph->E[graph_adj( graph, layer)];
+                continue;
+            }
+            if( text_graph_parse( str, (size_t)(2 - graph->directed), threads, &tl)< 0)
+                exit(-1);
+            if( layer&& tl.weighted!= graph->weighted){
+                printf("wrong column number[%d] in file[%s]\n", 2+ tl.weighted, str);
+                exit(-1);
+            }
+            graph->weighted= tl.weighted;
+            graph->E[layer]= tl.E;
+            if( tl.weighted) graph->edge_w[layer]= (Edge_w*)tl.edge;
+            else graph->edge[layer]= (Edge*)tl.edge;
+            if( tl.E&& _begin_num> tl.min) _begin_num= tl.min;
+            if( tl.E&& _end_num< tl.max) _end_num= tl.max;
+            printf("layer %zu edges", layer);
+            kilobit_print("\t\t[ ", (LONG)tl.E, " ]\n");
+        }
+        //only the pointer list of the parsed kind is kept
+        if( graph->weighted){
+            free( graph->edge);
+            graph->edge= NULL;
+        }
+        else{
+            free( graph->edge_w);
+            graph->edge_w= NULL;
+        }
+        graph->_s= _begin_num;
+        graph->_e= _end_num +1;
+        graph->V= _end_num - _begin_num+ 1;
     }
     else{
         locate_section( fil_para, "[NETWORK_INFO]");
@@ -334,12 +482,11 @@ void pre_init_graph(FILE* fil_para, Graph* graph){
         graph->V= (NINT)val - graph->_s+ 1;
         graph->_e= graph->_s+ graph->V;
 
-        graph->E= (size_t*)malloc(sizeof(size_t)*graph->L);
-        if( graph->E== NULL){
-            printf("Memory allocation failure for edges number list, size[%zu]\n", sizeof(size_t)*graph->L);
-            exit( - 1);
-        }
         for( layer= 0; layer< graph->L; layer++){
+            if( layer>= files){
+                graph->E[layer]= graph->E[graph_adj( graph, layer)];
+                continue;
+            }
             fget_next_item( fil_para, str, MAX_LINE_LEN);
             sscanf( str, "%zu", &graph->E[layer]);
             printf(" layer[%zu],", layer);
@@ -350,15 +497,61 @@ void pre_init_graph(FILE* fil_para, Graph* graph){
 void init_para(FILE* fil_para, Graph* graph, Transition* tran, Status* sts, Run* run, int echo){
     //scan input file, analysis key parameter
     int ret;
+    char* str;
+    char* tmp;
+    char* names;
+    size_t files, layer, k;
+    LONG lnum;
+    Stop_cond* sc;
     ret= item_count( fil_para, "[DATA_FILE]");
     if( ret<= 0){
         printf("wrong [DATA_FILE] config\n");
         exit( -1);
     }
     graph->L= (size_t)ret;
+    //a binary graph file holds all layers
+    locate_section( fil_para, "[DATA_FILE]");
+    str= (char*)malloc(sizeof(char)*MAX_LINE_LEN);
+    fget_next_item( fil_para, str, MAX_LINE_LEN);
+    if( bin_graph_layers( str)> 0){
+        if( ret!= 1){
+            printf("binary graph file[%s] must be the only [DATA_FILE] item\n", str);
+            exit( -1);
+        }
+        graph->L= (size_t)bin_graph_layers( str);
+        ret= 0;
+    }
+    free( str);
+    files= graph->L;
 
-    tran->L= graph->L;
     tran->M= (size_t)item_count( fil_para, "[NODAL_TRAN_MATRIX]");
+    //one network for several inducers, every layer shares the adjacency of the first
+    if( files== 1&& tran->M> 0&& (size_t)item_count( fil_para, "[EDGED_TRAN_MATRIX]")/ tran->M> 1){
+        graph->L= (size_t)item_count( fil_para, "[EDGED_TRAN_MATRIX]")/ tran->M;
+    }
+    //a network file listed again shares the adjacency of its first layer
+    graph->adj= (size_t*)malloc( sizeof(size_t)* graph->L);
+    names= (char*)malloc( sizeof(char)* MAX_LINE_LEN* files);
+    if( graph->adj== NULL|| names== NULL){
+        printf("Memory allocation failure for layer list, size[%zu]\n", sizeof(char)* MAX_LINE_LEN* files);
+        exit( -1);
+    }
+    locate_section( fil_para, "[DATA_FILE]");
+    for( layer= 0; layer< graph->L; layer++){
+        graph->adj[layer]= layer< files? layer: 0;
+        //text network files only, ret is 0 for a binary graph file
+        if( layer>= (size_t)ret) continue;
+        fget_next_item( fil_para, names+ layer* MAX_LINE_LEN, MAX_LINE_LEN);
+        for( k= 0; k< layer; k++){
+            if( !strcmp( names+ k* MAX_LINE_LEN, names+ layer* MAX_LINE_LEN)){
+                graph->adj[layer]= k;
+                break;
+            }
+        }
+    }
+    free( names);
+
+    tran->L= graph->L;
     sts->M= tran->M;
     printf("[compartment number]\t[%zu]\n", tran->M);
     printf("[layer number]\t\t[%zu]\n", tran->L);
@@ -387,17 +580,250 @@ void init_para(FILE* fil_para, Graph* graph, Transition* tran, Status* sts, Run*
     //read in run times
     run->sim_rounds = (size_t)getValInt( fil_para, "[SIM_ROUNDS]", echo);
 
+    //read in worker threads for multiple rounds, 0 for all cores
+    run->threads= (size_t)getValIntOpt( fil_para, "[THREADS]", 1, echo);
+    if( run->threads== 0){
+        run->threads= (size_t)sysconf( _SC_NPROCESSORS_ONLN);
+    }
+
+    //read in arity of the reaction heap, 2, 4 or 8
+    run->heap_arity= heap_arity( getValIntOpt( fil_para, "[HEAP]", HEAP_ARITY_DEFAULT, echo));
+    if( run->heap_arity< 2){
+        printf("wrong [HEAP] arity, expecting 2, 4 or 8\n");
+        exit( -1);
+    }
+
+    //read in event scheduler, heap, calendar, direct or rejection
+    run->scheduler= SCHED_HEAP;
+    if( section_exist( fil_para, "[SCHEDULER]")){
+        str= getValStr( fil_para, "[SCHEDULER]", MAX_LINE_LEN, echo);
+        run->scheduler= heap_scheduler( str);
+        if( run->scheduler< 0){
+            printf("unknown scheduler[%s], expecting heap, calendar, direct or rejection\n", str);
+            exit( -1);
+        }
+        free( str);
+    }
+
+    //read in approximate tau-leaping, "fixed <step>" or "adaptive <epsilon>"
+    run->tau_leap= TAU_OFF;
+    run->tau= 0;
+    if( section_exist( fil_para, "[TAU_LEAP]")){
+        str= getValStr( fil_para, "[TAU_LEAP]", MAX_LINE_LEN, echo);
+        tmp= strchr( str, ' ');
+        if( tmp!= NULL){
+            *tmp= '\0';
+            run->tau= atof( tmp+ 1);
+        }
+        if( !strcmp( str, "fixed")){
+            run->tau_leap= TAU_FIXED;
+        }
+        else if( !strcmp( str, "adaptive")){
+            run->tau_leap= TAU_ADAPTIVE;
+        }
+        else{
+            printf("unknown tau-leaping[%s], expecting fixed or adaptive\n", str);
+            exit( -1);
+        }
+        if( run->tau<= 0){
+            printf("tau-leaping needs a positive step or epsilon, e.g. [adaptive 0.03]\n");
+            exit( -1);
+        }
+        free( str);
+    }
+
+    //read in degree of hubs whose neighbours are updated lazily, rejection method only
+    lnum= getValIntOpt( fil_para, "[HUB_THRESHOLD]", 0, echo);
+    if( lnum< 0|| lnum> UINT32_MAX){
+        printf("wrong [HUB_THRESHOLD], expecting a degree\n");
+        exit( -1);
+    }
+    run->hub_threshold= (NINT)lnum;
+    if( run->hub_threshold> 0&& (run->scheduler!= SCHED_REJECTION|| run->tau_leap!= TAU_OFF)){
+        printf("[HUB_THRESHOLD] needs [SCHEDULER] rejection\n");
+        exit( -1);
+    }
+
+    //read in output format of single round, text, binary or binary_counts
+    run->out_format= OUT_TEXT;
+    if( section_exist( fil_para, "[OUT_FORMAT]")){
+        str= getValStr( fil_para, "[OUT_FORMAT]", MAX_LINE_LEN, echo);
+        if( !strcmp( str, "binary")){
+            run->out_format= OUT_BINARY;
+        }
+        else if( !strcmp( str, "binary_counts")){
+            run->out_format= OUT_BINARY_COUNTS;
+        }
+        else if( strcmp( str, "text")){
+            printf("unknown output format[%s], expecting text, binary or binary_counts\n", str);
+            exit( -1);
+        }
+        free( str);
+    }
+
+    //read in grid of count output, "time <step>" or "events <k>"
+    run->out_grid= GRID_OFF;
+    run->grid_step= 0;
+    run->grid_events= 0;
+    if( section_exist( fil_para, "[OUT_GRID]")){
+        str= getValStr( fil_para, "[OUT_GRID]", MAX_LINE_LEN, echo);
+        tmp= strchr( str, ' ');
+        if( tmp!= NULL){
+            *tmp= '\0';
+            run->grid_step= atof( tmp+ 1);
+        }
+        if( !strcmp( str, "time")){
+            run->out_grid= GRID_TIME;
+        }
+        else if( !strcmp( str, "events")){
+            run->out_grid= GRID_EVENTS;
+            run->grid_events= (size_t)run->grid_step;
+            run->grid_step= 0;
+        }
+        else{
+            printf("unknown [OUT_GRID][%s], expecting time or events\n", str);
+            exit( -1);
+        }
+        if( run->grid_step<= 0&& run->grid_events== 0){
+            printf("[OUT_GRID] needs a positive step or number of events, e.g. [time 0.1]\n");
+            exit( -1);
+        }
+        free( str);
+    }
+
+    //read in compression of output file, codec and optional level, default by file extension
+    run->out_codec= out_codec_of_file( run->out_file);
+    run->out_level= 0;
+    if( section_exist( fil_para, "[OUT_COMPRESS]")){
+        str= getValStr( fil_para, "[OUT_COMPRESS]", MAX_LINE_LEN, echo);
+        tmp= strchr( str, ' ');
+        if( tmp!= NULL){
+            *tmp= '\0';
+            run->out_level= atoi( tmp+ 1);
+        }
+        run->out_codec= out_codec( str);
+        if( run->out_codec< 0){
+            printf("unknown or not built in compression[%s], expecting none, gzip or zstd\n", str);
+            exit( -1);
+        }
+        free( str);
+    }
+
+    //read in performance report file, JSON or CSV by its extension
+    run->perf= NULL;
+    if( section_exist( fil_para, "[REPORT_FILE]")){
+        str= getValStr( fil_para, "[REPORT_FILE]", MAX_LINE_LEN, echo);
+        run->perf= perf_open( str);
+        if( run->perf== NULL){
+            printf("open report file[%s] failed\n", str);
+            exit( -1);
+        }
+        free( str);
+    }
+
+    //read in statistics file of an ensemble
+    run->stats_file= NULL;
+    if( section_exist( fil_para, "[STATS_FILE]")){
+        run->stats_file= getValStr( fil_para, "[STATS_FILE]", MAX_LINE_LEN, echo);
+    }
+
+    //read in checkpoint file and seconds between checkpoints, "<file> [seconds]"
+    if( section_exist( fil_para, "[CHECKPOINT]")){
+        str= getValStr( fil_para, "[CHECKPOINT]", MAX_LINE_LEN, echo);
+        tmp= strchr( str, ' ');
+        if( tmp!= NULL) *tmp= '\0';
+        run->ckpt= ckpt_open( str, tmp!= NULL? atof( tmp+ 1): 3600.0);
+        if( run->ckpt== NULL|| run->ckpt->interval<= 0){
+            printf("wrong [CHECKPOINT], expecting a file and a positive number of seconds\n");
+            exit( -1);
+        }
+        free( str);
+    }
+
+    //read in stop conditions, "zero <c>", "above <c> <n>", "rate <epsilon>" or "wall <seconds>", separated by commas
+    run->stop= NULL;
+    run->stop_num= 0;
+    if( section_exist( fil_para, "[STOP_WHEN]")){
+        str= getValStr( fil_para, "[STOP_WHEN]", MAX_LINE_LEN, echo);
+        for( tmp= str, k= 1; *tmp; tmp++){
+            if( *tmp== ',') k++;
+        }
+        run->stop= (Stop_cond*)calloc( k, sizeof(Stop_cond));
+        if( run->stop== NULL){
+            printf("Memory allocation failure for [STOP_WHEN]\n");
+            exit( -1);
+        }
+        for( tmp= strtok( str, ","); tmp!= NULL; tmp= strtok( NULL, ",")){
+            sc= &run->stop[run->stop_num++];
+            sc->c= 0;
+            sc->v= 0;
+            if( sscanf( tmp, " zero %zu", &sc->c)== 1){
+                sc->kind= STOP_ZERO;
+            }
+            else if( sscanf( tmp, " above %zu %lf", &sc->c, &sc->v)== 2){
+                sc->kind= STOP_ABOVE;
+            }
+            else if( sscanf( tmp, " rate %lf", &sc->v)== 1){
+                sc->kind= STOP_RATE;
+            }
+            else if( sscanf( tmp, " wall %lf", &sc->v)== 1&& sc->v> 0){
+                sc->kind= STOP_WALL;
+            }
+            else{
+                printf("wrong [STOP_WHEN] condition[%s], expecting zero <c>, above <c> <n>, rate <epsilon> or wall <seconds>\n", tmp);
+                exit( -1);
+            }
+        }
+        free( str);
+    }
+
+    //read in branch time and number of continuations, "<time> <branches>"
+    run->branch_num= 0;
+    run->branch_time= 0;
+    if( section_exist( fil_para, "[BRANCH]")){
+        str= getValStr( fil_para, "[BRANCH]", MAX_LINE_LEN, echo);
+        tmp= strchr( str, ' ');
+        if( tmp!= NULL){
+            *tmp= '\0';
+            lnum= atol( tmp+ 1);
+            run->branch_num= lnum> 0? (size_t)lnum: 0;
+        }
+        run->branch_time= atof( str);
+        if( run->branch_num== 0|| run->branch_time<= 0){
+            printf("wrong [BRANCH], expecting a positive time and number of branches, e.g. [30.0 100]\n");
+            exit( -1);
+        }
+        free( str);
+    }
+
     //read in sample size
     run->interval_num = (size_t)getValInt( fil_para, "[INTERVAL_NUM]", echo);
 
     //read in random number seed
     sts->random_seed = (size_t)getValInt( fil_para, "[RANDOM_SEED]", echo);
 
+    //read in random number generator, xoshiro256pp or philox4x32
+    sts->rng_kind= RNG_XOSHIRO;
+    if( section_exist( fil_para, "[RNG]")){
+        str= getValStr( fil_para, "[RNG]", MAX_LINE_LEN, echo);
+        if( rng_kind( str)< 0){
+            printf("unknown random number generator[%s]\n", str);
+            exit( -1);
+        }
+        sts->rng_kind= rng_kind( str);
+        free( str);
+    }
+
     //print inducer for signle simulation if presented and non zero
     run->show_inducer= 0;
     if( item_count( fil_para, "[SHOW_INDUCER]")> 0){
         run->show_inducer = strcmp(getValStr( fil_para, "[SHOW_INDUCER]", MAX_LINE_LEN, echo), "0");
     }
+    //print the sampled infector of each event for single simulation
+    run->show_infector= 0;
+    if( item_count( fil_para, "[SHOW_INFECTOR]")> 0){
+        run->show_infector = strcmp(getValStr( fil_para, "[SHOW_INFECTOR]", MAX_LINE_LEN, echo), "0");
+    }
 
     //read in inducer list
     tran->inducer_lst= getValSize_tLst( fil_para, "[INDUCER_LIST]", graph->L, echo);
@@ -407,6 +833,9 @@ void init_para(FILE* fil_para, Graph* graph, Transition* tran, Status* sts, Run*
 
     //read in edge based rate matrix
     tran->edge_trn= getValMatrixLst( fil_para, "[EDGED_TRAN_MATRIX]", tran->M, tran->L, tran->_s, MAX_LINE_LEN, echo);
+
+    //event selection table
+    init_trn_table( tran);
 }
 void initi_status(FILE* fil_para, Graph* graph, Status* sts, int echo){
     char *fil_nam= NULL;
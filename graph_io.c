@@ -0,0 +1,644 @@
+#include "graph_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+/*
+ * graph_io.c of GEMF in C language
+ * binary CSR graph file, see graph_io.h
+ */
+
+//round up to 8 bytes
+#define ALIGN8(x) (((x)+ 7)& ~(size_t)7)
+
+//size of one layer section
+static size_t bin_layer_size( Bin_graph_header* hdr, uint64_t E){
+    size_t ret= sizeof(uint64_t)*(size_t)(hdr->_e+ 1)+ ALIGN8( sizeof(uint32_t)*(size_t)E);
+    if( hdr->flags& 1){
+        ret+= sizeof(double)*(size_t)E;
+    }
+    return ret;
+}
+static int bin_header_check( Bin_graph_header* hdr, const char* fil_nam, int echo){
+    if( memcmp( hdr->magic, BIN_GRAPH_MAGIC, sizeof(BIN_GRAPH_MAGIC))){
+        return -1;
+    }
+    if( hdr->bom!= BIN_GRAPH_BOM){
+        if( echo) printf("binary graph file[%s] has different byte order\n", fil_nam);
+        return -1;
+    }
+    if( hdr->version!= BIN_GRAPH_VERSION){
+        if( echo) printf("binary graph file[%s] version[%u] not supported\n", fil_nam, hdr->version);
+        return -1;
+    }
+    return 0;
+}
+LONG bin_graph_layers( const char* fil_nam){
+    Bin_graph_header hdr;
+    FILE* fil= fopen( fil_nam, "rb");
+    if( fil== NULL) return -1;
+    if( fread( &hdr, sizeof(hdr), 1, fil)!= 1|| bin_header_check( &hdr, fil_nam, 1)){
+        fclose( fil);
+        return -1;
+    }
+    fclose( fil);
+    return (LONG)hdr.L;
+}
+int bin_graph_map( const char* fil_nam, Graph* graph){
+    Bin_graph_header* hdr;
+    uint64_t* E;
+    struct stat st;
+    size_t layer, size, owners;
+    int fd;
+
+    fd= open( fil_nam, O_RDONLY);
+    if( fd< 0|| fstat( fd, &st)){
+        printf("read binary graph file[%s] error\n", fil_nam);
+        return -1;
+    }
+    graph->map_size= (size_t)st.st_size;
+    graph->map= mmap( NULL, graph->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close( fd);
+    if( graph->map== MAP_FAILED){
+        graph->map= NULL;
+        printf("map binary graph file[%s] error\n", fil_nam);
+        return -1;
+    }
+    hdr= (Bin_graph_header*)graph->map;
+    if( graph->map_size< sizeof(Bin_graph_header)|| bin_header_check( hdr, fil_nam, 1)){
+        printf("[%s] is not a binary graph file\n", fil_nam);
+        return -1;
+    }
+    for( owners= 0, layer= 0; layer< graph->L; layer++){
+        owners+= graph_adj( graph, layer)== layer;
+    }
+    if( hdr->L!= owners){
+        printf("binary graph file[%s] has [%llu] layers, expecting [%zu]\n", fil_nam, (unsigned long long)hdr->L, owners);
+        return -1;
+    }
+    check_int_range( (LONG)hdr->_e);
+    graph->weighted= (int)(hdr->flags& 1);
+    graph->directed= (int)((hdr->flags>> 1)& 1);
+    graph->_s= (NINT)hdr->_s;
+    graph->_e= (NINT)hdr->_e;
+    graph->V= graph->_e- graph->_s;
+    graph->E= (size_t*)malloc(sizeof(size_t)*graph->L);
+    if( graph->E== NULL){
+        printf("Memory allocation failure for edges number list, size[%zu]\n", sizeof(size_t)*graph->L);
+        return -1;
+    }
+    //check file size before touching the arc counts, then before touching any layer
+    E= (uint64_t*)((char*)graph->map+ sizeof(Bin_graph_header));
+    size= sizeof(Bin_graph_header)+ sizeof(uint64_t)*hdr->L;
+    if( size> graph->map_size){
+        printf("binary graph file[%s] truncated, size[%zu], expecting[%zu]\n", fil_nam, graph->map_size, size);
+        return -1;
+    }
+    for( owners= 0, layer= 0; layer< graph->L; layer++){
+        if( graph_adj( graph, layer)!= layer){
+            graph->E[layer]= graph->E[graph_adj( graph, layer)];
+            continue;
+        }
+        //more arcs than the file could hold would wrap the size below
+        if( E[owners]> graph->map_size/ sizeof(uint32_t)){
+            printf("binary graph file[%s] truncated, size[%zu], layer[%zu] of [%llu] arcs\n", fil_nam, graph->map_size, layer, (unsigned long long)E[owners]);
+            return -1;
+        }
+        graph->E[layer]= (size_t)E[owners];
+        size+= bin_layer_size( hdr, E[owners++]);
+    }
+    if( size> graph->map_size){
+        printf("binary graph file[%s] truncated, size[%zu], expecting[%zu]\n", fil_nam, graph->map_size, size);
+        return -1;
+    }
+    return 0;
+}
+int bin_graph_load( Graph* graph){
+    Bin_graph_header* hdr= (Bin_graph_header*)graph->map;
+    char* p;
+    uint64_t* offsets;
+    NINT* targets;
+    size_t layer, j;
+    NINT n;
+    double t0= gettimenow();
+
+    //adjacency points into the map, sections must match size_t and NINT
+    if( sizeof(size_t)!= sizeof(uint64_t)|| sizeof(NINT)!= sizeof(uint32_t)){
+        printf("binary graph file needs 64-bit size_t and 32-bit node type\n");
+        return -1;
+    }
+    p= (char*)graph->map+ sizeof(Bin_graph_header)+ sizeof(uint64_t)*hdr->L;
+    for( layer= 0; layer< graph->L; layer++){
+        if( graph_adj( graph, layer)!= layer){
+            graph_share_layer( graph, layer, graph_adj( graph, layer));
+            continue;
+        }
+        //only the sizes were checked, the arcs of every node must stay in the section and point to nodes
+        offsets= (uint64_t*)p;
+        targets= (NINT*)(p+ sizeof(uint64_t)*(graph->_e+ 1));
+        for( n= 0; n< graph->_e&& offsets[n]<= offsets[n+ 1]; n++);
+        if( n< graph->_e|| offsets[graph->_e]!= graph->E[layer]){
+            printf("binary graph file layer[%zu] has wrong offsets\n", layer);
+            return -1;
+        }
+        for( j= 0; j< graph->E[layer]; j++){
+            if( targets[j]< graph->_s|| targets[j]>= graph->_e){
+                printf("node["fmt_n"] of layer[%zu] out of range["fmt_n"/"fmt_n"]\n", targets[j], layer, graph->_s, graph->_e);
+                return -1;
+            }
+        }
+        graph->offsets[layer]= (size_t*)offsets;
+        graph->targets[layer]= targets;
+        if( graph->weighted){
+            graph->weights[layer]= (double*)(p+ sizeof(uint64_t)*(graph->_e+ 1)+ ALIGN8( sizeof(uint32_t)*graph->E[layer]));
+        }
+        p+= bin_layer_size( hdr, graph->E[layer]);
+        time_print("[", gettimenow() - t0, " ]\t");
+        printf("layer[%zu] ", layer+ 1);
+        kilobit_print("[ ", (LONG)graph->E[layer], " ] arcs mapped\n");
+    }
+    //neighbour sweeps jump between nodes
+    posix_madvise( graph->map, graph->map_size, POSIX_MADV_RANDOM);
+    return 0;
+}
+void graph_share_layer( Graph* graph, size_t layer, size_t from){
+    graph->E[layer]= graph->E[from];
+    graph->offsets[layer]= graph->offsets[from];
+    graph->targets[layer]= graph->targets[from];
+    graph->weights[layer]= graph->weights[from];
+}
+void bin_graph_unmap( Graph* graph){
+    if( graph->map!= NULL){
+        munmap( graph->map, graph->map_size);
+        graph->map= NULL;
+    }
+}
+int bin_graph_write( const char* fil_nam, Graph* graph){
+    Bin_graph_header hdr;
+    uint64_t E;
+    size_t layer, layers, pad;
+    FILE* fil;
+    char zero[8]= {0};
+
+    if( sizeof(size_t)!= sizeof(uint64_t)|| sizeof(NINT)!= sizeof(uint32_t)){
+        printf("binary graph file needs 64-bit size_t and 32-bit node type\n");
+        return -1;
+    }
+    fil= fopen( fil_nam, "wb");
+    if( fil== NULL){
+        printf("open binary graph file[%s] error\n", fil_nam);
+        return -1;
+    }
+    memset( &hdr, 0, sizeof(hdr));
+    memcpy( hdr.magic, BIN_GRAPH_MAGIC, sizeof(BIN_GRAPH_MAGIC));
+    hdr.version= BIN_GRAPH_VERSION;
+    hdr.bom= BIN_GRAPH_BOM;
+    hdr.flags= (graph->weighted? 1: 0)| (graph->directed? 2: 0);
+    //layers all sharing one adjacency are written once, and shared again when mapped
+    for( layers= 1, layer= 1; layer< graph->L; layer++){
+        if( graph_adj( graph, layer)!= 0) layers= graph->L;
+    }
+    hdr.L= layers;
+    hdr._s= graph->_s;
+    hdr._e= graph->_e;
+    fwrite( &hdr, sizeof(hdr), 1, fil);
+    for( layer= 0; layer< layers; layer++){
+        E= graph->E[layer];
+        fwrite( &E, sizeof(E), 1, fil);
+    }
+    //CSR sections are written as they are in memory
+    for( layer= 0; layer< layers; layer++){
+        fwrite( graph->offsets[layer], sizeof(uint64_t), graph->_e+ 1, fil);
+        fwrite( graph->targets[layer], sizeof(uint32_t), graph->E[layer], fil);
+        pad= ALIGN8( sizeof(uint32_t)*graph->E[layer])- sizeof(uint32_t)*graph->E[layer];
+        fwrite( zero, 1, pad, fil);
+        if( graph->weighted){
+            fwrite( graph->weights[layer], sizeof(double), graph->E[layer], fil);
+        }
+    }
+    if( fclose( fil)){
+        printf("write binary graph file[%s] error\n", fil_nam);
+        return -1;
+    }
+    return 0;
+}
+int graph_csr_build( Graph* graph, size_t layer){
+    size_t li, E= graph->E[layer];
+    size_t* offsets;
+    NINT* targets;
+    double* weights= NULL;
+    Edge* ed= graph->weighted? NULL: graph->edge[layer];
+    Edge_w* ed_w= graph->weighted? graph->edge_w[layer]: NULL;
+    NINT n, j;
+
+    offsets= (size_t*)calloc( (size_t)graph->_e+ 1, sizeof(size_t));
+    targets= (NINT*)malloc( sizeof(NINT)* (E+ 1));
+    if( graph->weighted){
+        weights= (double*)malloc( sizeof(double)* (E+ 1));
+    }
+    if( offsets== NULL|| targets== NULL|| (graph->weighted&& weights== NULL)){
+        printf("Memory allocation failure for adjacency of layer[%zu], size[%zu]\n", layer, sizeof(double)* E);
+        return -1;
+    }
+    //count arcs of each source
+    for( li= 0; li< E; li++){
+        n= graph->weighted? ed_w[li].i: ed[li].i;
+        j= graph->weighted? ed_w[li].j: ed[li].j;
+        if( n>= graph->_e|| j>= graph->_e){
+            printf("node["fmt_n"] of layer[%zu] out of range["fmt_n"/"fmt_n"]\n", n>= graph->_e? n: j, layer, graph->_s, graph->_e);
+            return -1;
+        }
+        offsets[n]++;
+    }
+    //offsets[n] is the first free slot of n, stable in input order
+    for( li= 0, n= 0; n<= graph->_e; n++){
+        E= offsets[n];
+        offsets[n]= li;
+        li+= E;
+    }
+    E= graph->E[layer];
+    if( graph->weighted){
+        for( li= 0; li< E; li++){
+            targets[offsets[ed_w[li].i]]= ed_w[li].j;
+            weights[offsets[ed_w[li].i]++]= ed_w[li].w;
+        }
+    }
+    else{
+        for( li= 0; li< E; li++){
+            targets[offsets[ed[li].i]++]= ed[li].j;
+        }
+    }
+    //offsets[n] is now the end of n, shift back to the begin
+    for( n= graph->_e; n> 0; n--){
+        offsets[n]= offsets[n- 1];
+    }
+    offsets[0]= 0;
+    graph->offsets[layer]= offsets;
+    graph->targets[layer]= targets;
+    if( graph->weighted){
+        graph->weights[layer]= weights;
+        free( graph->edge_w[layer]);
+        graph->edge_w[layer]= NULL;
+    }
+    else{
+        free( graph->edge[layer]);
+        graph->edge[layer]= NULL;
+    }
+    return 0;
+}
+int graph_reverse_build( Graph* graph, size_t layer){
+    size_t li, E= graph->E[layer];
+    size_t* offsets;
+    NINT* sources;
+    double* weights= NULL;
+    NINT n;
+
+    if( graph->r_offsets== NULL){
+        graph->r_offsets= (size_t**)calloc( graph->L, sizeof(size_t*));
+        graph->r_sources= (NINT**)calloc( graph->L, sizeof(NINT*));
+        graph->r_weights= (double**)calloc( graph->L, sizeof(double*));
+        if( graph->r_offsets== NULL|| graph->r_sources== NULL|| graph->r_weights== NULL){
+            printf("Memory allocation failure for reverse network list, size[%zu]\n", sizeof(double*)*graph->L);
+            return -1;
+        }
+    }
+    graph_reverse_free( graph, layer);
+    if( graph_adj( graph, layer)!= layer){
+        graph->r_offsets[layer]= graph->r_offsets[graph_adj( graph, layer)];
+        graph->r_sources[layer]= graph->r_sources[graph_adj( graph, layer)];
+        graph->r_weights[layer]= graph->r_weights[graph_adj( graph, layer)];
+        return 0;
+    }
+    if( !graph->directed){
+        graph->r_offsets[layer]= graph->offsets[layer];
+        graph->r_sources[layer]= graph->targets[layer];
+        graph->r_weights[layer]= graph->weights[layer];
+        return 0;
+    }
+    offsets= (size_t*)calloc( (size_t)graph->_e+ 1, sizeof(size_t));
+    sources= (NINT*)malloc( sizeof(NINT)* (E+ 1));
+    if( graph->weighted){
+        weights= (double*)malloc( sizeof(double)* (E+ 1));
+    }
+    if( offsets== NULL|| sources== NULL|| (graph->weighted&& weights== NULL)){
+        printf("Memory allocation failure for reverse adjacency of layer[%zu], size[%zu]\n", layer, sizeof(double)* E);
+        free( offsets);
+        free( sources);
+        free( weights);
+        return -1;
+    }
+    //count arcs into each target, then place them by counting sort in source order
+    for( li= 0; li< E; li++){
+        offsets[graph->targets[layer][li]+ 1]++;
+    }
+    for( n= 0; n< graph->_e; n++){
+        offsets[n+ 1]+= offsets[n];
+    }
+    for( n= graph->_s; n< graph->_e; n++){
+        for( li= graph->offsets[layer][n]; li< graph->offsets[layer][n+ 1]; li++){
+            if( graph->weighted){
+                weights[offsets[graph->targets[layer][li]]]= graph->weights[layer][li];
+            }
+            sources[offsets[graph->targets[layer][li]]++]= n;
+        }
+    }
+    //offsets[n] is now the end of n, shift back to the begin
+    for( n= graph->_e; n> 0; n--){
+        offsets[n]= offsets[n- 1];
+    }
+    offsets[0]= 0;
+    graph->r_offsets[layer]= offsets;
+    graph->r_sources[layer]= sources;
+    graph->r_weights[layer]= weights;
+    return 0;
+}
+void graph_reverse_free( Graph* graph, size_t layer){
+    if( graph->r_offsets== NULL) return;
+    if( graph->r_offsets[layer]!= graph->offsets[layer]&& graph_adj( graph, layer)== layer){
+        free( graph->r_offsets[layer]);
+        free( graph->r_sources[layer]);
+        free( graph->r_weights[layer]);
+    }
+    graph->r_offsets[layer]= NULL;
+    graph->r_sources[layer]= NULL;
+    graph->r_weights[layer]= NULL;
+}
+//one chunk of a text edge list, parsed by one thread
+typedef struct{
+    const char* beg;
+    const char* end;
+    int weighted;
+    //parsed edges, Edge or Edge_w
+    void* buf;
+    size_t n;
+    size_t cap;
+    NINT min;
+    NINT max;
+    //first malformed line, NULL if none
+    const char* err;
+    int err_col;
+} Parse_chunk;
+
+static const double POW10[]= { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static int is_blank( char c){
+    return c== ' '|| c== '\t'|| c== '\r'|| c== '\v'|| c== '\f';
+}
+//unsigned integer token, NULL if not a number
+static const char* parse_uint( const char* p, const char* end, LONG* val){
+    LONG v= 0;
+    const char* s= p;
+    while( p< end&& *p>= '0'&& *p<= '9'){
+        if( v<= (LONG)UINT_MAX){
+            v= v* 10+ (*p- '0');
+        }
+        p++;
+    }
+    if( p== s|| (p< end&& !is_blank( *p)&& *p!= '\n')) return NULL;
+    *val= v;
+    return p;
+}
+//floating point token, exact for up to 15 significant digits, strtod otherwise
+static const char* parse_dbl( const char* p, const char* end, double* val){
+    const char* s= p;
+    uint64_t mant= 0;
+    int exp10= 0, e= 0, neg= 0, eneg= 0, digits= 0, exact= 1;
+    char tmp[64];
+    char* q;
+    size_t len;
+
+    if( p< end&& (*p== '-'|| *p== '+')){
+        neg= *p== '-';
+        p++;
+    }
+    for( ; p< end&& *p>= '0'&& *p<= '9'; p++, digits++){
+        if( mant< 100000000000000ULL) mant= mant* 10+ (uint64_t)(*p- '0');
+        else{
+            exp10++;
+            exact&= *p== '0';
+        }
+    }
+    if( p< end&& *p== '.'){
+        for( p++; p< end&& *p>= '0'&& *p<= '9'; p++, digits++){
+            if( mant< 100000000000000ULL){
+                mant= mant* 10+ (uint64_t)(*p- '0');
+                exp10--;
+            }
+            else exact&= *p== '0';
+        }
+    }
+    if( digits&& p< end&& (*p== 'e'|| *p== 'E')){
+        p++;
+        if( p< end&& (*p== '-'|| *p== '+')){
+            eneg= *p== '-';
+            p++;
+        }
+        if( p== end|| *p< '0'|| *p> '9') exact= 0;
+        for( ; p< end&& *p>= '0'&& *p<= '9'; p++){
+            if( e< 10000) e= e* 10+ (*p- '0');
+        }
+        exp10+= eneg? - e: e;
+    }
+    if( digits&& exact&& exp10>= -22&& exp10<= 22&& (p== end|| is_blank( *p)|| *p== '\n')){
+        *val= exp10< 0? (double)mant/ POW10[- exp10]: (double)mant* POW10[exp10];
+        if( neg) *val= - *val;
+        return p;
+    }
+    //rare forms, inf, nan, long mantissa
+    for( p= s; p< end&& !is_blank( *p)&& *p!= '\n'; p++);
+    len= (size_t)(p- s);
+    if( len== 0|| len>= sizeof(tmp)) return NULL;
+    memcpy( tmp, s, len);
+    tmp[len]= '\0';
+    *val= strtod( tmp, &q);
+    if( *q!= '\0') return NULL;
+    return p;
+}
+//parse all lines of a chunk into its own buffer
+static void* parse_chunk( void* arg){
+    Parse_chunk* pc= (Parse_chunk*)arg;
+    const char* p= pc->beg;
+    const char* eol;
+    size_t size= pc->weighted? sizeof(Edge_w): sizeof(Edge);
+    LONG li, lj;
+    double lw= 0;
+    void* tmp;
+    int col;
+
+    pc->cap= (size_t)(pc->end- pc->beg)/ 8+ 16;
+    pc->buf= malloc( size* pc->cap);
+    if( pc->buf== NULL){
+        printf("Memory allocation failure for parser buffer, size[%zu]\n", size* pc->cap);
+        error_exit( -1);
+    }
+    while( p< pc->end){
+        eol= memchr( p, '\n', (size_t)(pc->end- p));
+        if( eol== NULL) eol= pc->end;
+        while( p< eol&& is_blank( *p)) p++;
+        if( p== eol|| *p== '#'){
+            p= eol+ 1;
+            continue;
+        }
+        col= 0;
+        if( (p= parse_uint( p, eol, &li))!= NULL){
+            col++;
+            while( p< eol&& is_blank( *p)) p++;
+            if( (p= parse_uint( p, eol, &lj))!= NULL){
+                col++;
+                while( p< eol&& is_blank( *p)) p++;
+                if( pc->weighted&& (p= parse_dbl( p, eol, &lw))!= NULL){
+                    col++;
+                    while( p< eol&& is_blank( *p)) p++;
+                }
+            }
+        }
+        if( p== NULL|| p!= eol|| col!= 2+ pc->weighted){
+            //keep the first malformed line, stop this chunk
+            for( pc->err= eol; pc->err> pc->beg&& pc->err[-1]!= '\n'; pc->err--);
+            pc->err_col= col;
+            return NULL;
+        }
+        check_int_range( li);
+        check_int_range( lj);
+        if( pc->n== pc->cap){
+            pc->cap*= 2;
+            tmp= realloc( pc->buf, size* pc->cap);
+            if( tmp== NULL){
+                printf("Memory allocation failure for parser buffer, size[%zu]\n", size* pc->cap);
+                error_exit( -1);
+            }
+            pc->buf= tmp;
+        }
+        if( pc->weighted){
+            ((Edge_w*)pc->buf)[pc->n].i= (NINT)li;
+            ((Edge_w*)pc->buf)[pc->n].j= (NINT)lj;
+            ((Edge_w*)pc->buf)[pc->n].w= lw;
+        }
+        else{
+            ((Edge*)pc->buf)[pc->n].i= (NINT)li;
+            ((Edge*)pc->buf)[pc->n].j= (NINT)lj;
+        }
+        if( pc->min> (NINT)li) pc->min= (NINT)li;
+        if( pc->min> (NINT)lj) pc->min= (NINT)lj;
+        if( pc->max< (NINT)li) pc->max= (NINT)li;
+        if( pc->max< (NINT)lj) pc->max= (NINT)lj;
+        pc->n++;
+        p= eol+ 1;
+    }
+    return NULL;
+}
+int text_graph_parse( const char* fil_nam, size_t copies, size_t threads, Text_layer* out){
+    Parse_chunk* pc;
+    pthread_t* tid;
+    struct stat st;
+    const char *data, *p, *end, *eol;
+    size_t size, t, total, col;
+    int fd, ret= 0;
+
+    memset( out, 0, sizeof(Text_layer));
+    fd= open( fil_nam, O_RDONLY);
+    if( fd< 0|| fstat( fd, &st)){
+        printf("read network file[%s] error\n", fil_nam);
+        return -1;
+    }
+    size= (size_t)st.st_size;
+    data= size? (const char*)mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0): NULL;
+    close( fd);
+    if( data== MAP_FAILED){
+        printf("map network file[%s] error\n", fil_nam);
+        return -1;
+    }
+    if( size) posix_madvise( (void*)data, size, POSIX_MADV_SEQUENTIAL);
+    end= data+ size;
+
+    //column number of first edge decides weighted
+    for( p= data; p< end; p= eol+ 1){
+        eol= memchr( p, '\n', (size_t)(end- p));
+        if( eol== NULL) eol= end;
+        while( p< eol&& is_blank( *p)) p++;
+        if( p< eol&& *p!= '#') break;
+    }
+    col= 0;
+    for( eol= p; eol< end&& *eol!= '\n'; ){
+        while( eol< end&& is_blank( *eol)) eol++;
+        if( eol== end|| *eol== '\n') break;
+        col++;
+        while( eol< end&& !is_blank( *eol)&& *eol!= '\n') eol++;
+    }
+    if( col!= 2&& col!= 3){
+        printf("wrong column number[%zu] in file[%s]\n", col, fil_nam);
+        if( size) munmap( (void*)data, size);
+        return -1;
+    }
+    out->weighted= col== 3;
+
+    //split at newlines
+    if( threads< 1) threads= 1;
+    if( (size_t)(end- p)< threads* 65536) threads= 1;
+    pc= (Parse_chunk*)calloc( threads, sizeof(Parse_chunk));
+    tid= (pthread_t*)calloc( threads, sizeof(pthread_t));
+    if( pc== NULL|| tid== NULL){
+        printf("Memory allocation failure for parser threads[%zu]\n", threads);
+        error_exit( -1);
+    }
+    for( t= 0; t< threads; t++){
+        pc[t].beg= t? pc[t- 1].end: p;
+        pc[t].end= t== threads- 1? end: p+ (size_t)(end- p)* (t+ 1)/ threads;
+        if( pc[t].end< pc[t].beg) pc[t].end= pc[t].beg;
+        while( pc[t].end< end&& pc[t].end> pc[t].beg&& pc[t].end[-1]!= '\n') pc[t].end++;
+        pc[t].weighted= out->weighted;
+        pc[t].min= UINT_MAX;
+        pc[t].max= 0;
+    }
+    for( t= 1; t< threads; t++){
+        if( pthread_create( &tid[t], NULL, parse_chunk, &pc[t])){
+            printf("create parser thread[%zu] failed\n", t);
+            error_exit( -1);
+        }
+    }
+    parse_chunk( &pc[0]);
+    for( t= 1; t< threads; t++){
+        pthread_join( tid[t], NULL);
+    }
+
+    //concatenate buffers in file order
+    total= 0;
+    out->min= UINT_MAX;
+    out->max= 0;
+    for( t= 0; t< threads; t++){
+        if( pc[t].err!= NULL&& ret== 0){
+            for( eol= pc[t].err; eol< end&& *eol!= '\n'; eol++);
+            printf("Error! Expecting %d columns, getting %d in file[%s] line[%.*s]\n", 2+ out->weighted, pc[t].err_col, fil_nam,
+                   (int)(eol- pc[t].err), pc[t].err);
+            ret= -1;
+        }
+        total+= pc[t].n;
+        if( pc[t].n&& out->min> pc[t].min) out->min= pc[t].min;
+        if( pc[t].n&& out->max< pc[t].max) out->max= pc[t].max;
+    }
+    size= out->weighted? sizeof(Edge_w): sizeof(Edge);
+    out->E= total;
+    out->edge= ret? NULL: malloc( size* (copies* total+ 1));
+    if( ret== 0&& out->edge== NULL){
+        printf("Memory allocation failure for network file[%s], size[%zu]\n", fil_nam, size* copies* total);
+        error_exit( -1);
+    }
+    total= 0;
+    for( t= 0; t< threads; t++){
+        if( ret== 0){
+            memcpy( (char*)out->edge+ size* total, pc[t].buf, size* pc[t].n);
+        }
+        total+= pc[t].n;
+        free( pc[t].buf);
+    }
+    free( pc);
+    free( tid);
+    if( data!= NULL) munmap( (void*)data, (size_t)st.st_size);
+    return ret;
+}
@@ -0,0 +1,134 @@
+#ifndef GRAPHIOH
+#define GRAPHIOH
+
+#include "common.h"
+#include <stdint.h>
+/*
+ * graph_io.h of GEMF in C language
+ * binary CSR graph file
+ *
+ * layout, native byte order, every section 8-byte aligned:
+ *   header    Bin_graph_header
+ *   E         uint64 by L, stored arcs of each layer (undirected edges stored both ways)
+ *   layer l   uint64 offsets by (_e+1), arcs of node n are [offsets[n], offsets[n+1])
+ *             uint32 targets by E[l], padded to 8 bytes
+ *             double weights by E[l], weighted graph only
+ */
+
+#define BIN_GRAPH_MAGIC "GEMFCSR"
+#define BIN_GRAPH_VERSION 1
+#define BIN_GRAPH_BOM 0x01020304U
+
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    //byte order mark, BIN_GRAPH_BOM in writer byte order
+    uint32_t bom;
+    //bit 0: weighted, bit 1: directed source network
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t L;
+    //nodes start from _s, end at _e - 1
+    uint64_t _s;
+    uint64_t _e;
+    uint64_t reserved2[2];
+} Bin_graph_header;
+
+//layer whose adjacency layer uses, see Graph
+static inline size_t graph_adj( const Graph* graph, size_t layer){
+    return graph->adj== NULL? layer: graph->adj[layer];
+}
+//point a layer at the adjacency of an earlier layer, see Graph
+void graph_share_layer( Graph* graph, size_t layer, size_t from);
+
+/*
+ *number of layers of a binary graph file
+ *
+ *input:  char* fil_nam    [ file name]
+ *return: LONG  [>0: number of layers; <0: not a binary graph file]
+ */
+LONG bin_graph_layers( const char* fil_nam);
+
+/*
+ *map a binary graph file, fill graph sizes, file layers are the layers of
+ *graph that own their adjacency, in order
+ *
+ *input:  char*  fil_nam   [ file name]
+ *inout:  Graph* graph     [ owner layers must match the file; weighted, directed, V, _s, _e, E are set]
+ *return: int   [0: success; <0: failure]
+ */
+int bin_graph_map( const char* fil_nam, Graph* graph);
+
+/*
+ *point adjacency of graph into a mapped binary graph file, no copy is made,
+ *the file stays mapped until bin_graph_unmap, graph must be initialized by init_graph
+ *
+ *inout:  Graph* graph     [ graph struct]
+ *return: int   [0: success; <0: failure]
+ */
+int bin_graph_load( Graph* graph);
+
+//unmap binary graph file
+void bin_graph_unmap( Graph* graph);
+
+/*
+ *write the adjacency of a graph to a binary graph file
+ *
+ *input:  char*  fil_nam   [ file name]
+ *        Graph* graph     [ graph struct, adjacency built]
+ *return: int   [0: success; <0: failure]
+ */
+int bin_graph_write( const char* fil_nam, Graph* graph);
+
+/*
+ *build CSR adjacency of one layer from its edge list by counting sort,
+ *arcs of a node keep their order in the edge list, the edge list is freed
+ *
+ *inout:  Graph* graph     [ graph struct, edge[layer] or edge_w[layer] filled, offsets/targets/weights allocated]
+ *input:  size_t layer     [ layer]
+ *return: int   [0: success; <0: failure]
+ */
+int graph_csr_build( Graph* graph, size_t layer);
+
+/*
+ *build reverse CSR adjacency of one layer, arcs grouped by target node, from
+ *the forward adjacency; undirected graphs store every edge both ways, so
+ *their reverse adjacency is the forward one and nothing is copied
+ *
+ *inout:  Graph* graph     [ graph struct, adjacency of layer built]
+ *input:  size_t layer     [ layer]
+ *return: int   [0: success; <0: failure]
+ */
+int graph_reverse_build( Graph* graph, size_t layer);
+//free reverse adjacency of one layer
+void graph_reverse_free( Graph* graph, size_t layer);
+
+/*
+ * text edge list, "i j" or "i j w" per line, lines starting with '#' are skipped
+ * the file is mapped, split at newlines into one chunk per thread, and each
+ * thread parses its chunk into its own buffer, buffers are concatenated in order
+ */
+typedef struct{
+    //Edge or Edge_w array with room for copies*E arcs
+    void* edge;
+    //number of edges parsed
+    size_t E;
+    //0 for "i j", 1 for "i j w"
+    int weighted;
+    //smallest and largest node
+    NINT min;
+    NINT max;
+} Text_layer;
+
+/*
+ *parse a text edge list in parallel
+ *
+ *input:  char*  fil_nam   [ file name]
+ *        size_t copies    [ 2 to leave room for reversed arcs of undirected graph, otherwise 1]
+ *        size_t threads   [ number of parser threads]
+ *output: Text_layer* out  [ parsed edges]
+ *return: int   [0: success; <0: failure]
+ */
+int text_graph_parse( const char* fil_nam, size_t copies, size_t threads, Text_layer* out);
+
+#endif
@@ -0,0 +1,166 @@
+#include "heap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*
+ * heap.c of GEMF in C language
+ * indexed d-ary heap, see heap.h
+ */
+
+int heap_arity( LONG d){
+    if( d== 2|| d== 4|| d== 8) return (int)d;
+    return -1;
+}
+int heap_scheduler( const char* name){
+    if( !strcmp( name, "heap")) return SCHED_HEAP;
+    if( !strcmp( name, "calendar")) return SCHED_CALENDAR;
+    if( !strcmp( name, "direct")) return SCHED_DIRECT;
+    if( !strcmp( name, "rejection")) return SCHED_REJECTION;
+    return -1;
+}
+void heap_init( Heap* heap, Graph* graph, int sched, int d){
+    size_t slots;
+    memset( heap, 0, sizeof(Heap));
+    heap->_s= graph->_s;
+    heap->_e= graph->_e;
+    heap->V= graph->_e- graph->_s;
+    heap->sched= sched;
+    heap->d= d;
+    if( sched== SCHED_CALENDAR){
+        calendar_init( &heap->cal, graph->_s, graph->_e);
+        return;
+    }
+    if( sched== SCHED_DIRECT|| sched== SCHED_REJECTION){
+        sum_tree_init( &heap->sum, graph->_s, graph->_e);
+        return;
+    }
+    for( heap->shift= 0; (1<< heap->shift)< d; heap->shift++);
+    //room for the d-1 leading pad slots, rounded to a cache line
+    slots= ((size_t)heap->V+ (size_t)d+ 7)& ~(size_t)7;
+    if( posix_memalign( (void**)&heap->t_mem, 64, sizeof(double)* slots)||
+        posix_memalign( (void**)&heap->n_mem, 64, sizeof(NINT)* slots)){
+        printf("malloc reaction list failed.\n");
+        error_exit( -1);
+    }
+    heap->t= heap->t_mem+ d- 1;
+    heap->n= heap->n_mem+ d- 1;
+    heap->idx= (NINT*)calloc( (size_t)heap->_e+ 1, sizeof(NINT));
+    if( heap->idx== NULL){
+        printf("malloc reaction index failed.\n");
+        error_exit( -1);
+    }
+}
+void heap_free( Heap* heap){
+    if( heap->sched== SCHED_CALENDAR){
+        calendar_free( &heap->cal);
+        return;
+    }
+    if( heap->sched== SCHED_DIRECT|| heap->sched== SCHED_REJECTION){
+        sum_tree_free( &heap->sum);
+        return;
+    }
+    free( heap->t_mem);
+    free( heap->n_mem);
+    free( heap->idx);
+    heap->t_mem= NULL;
+    heap->n_mem= NULL;
+    heap->idx= NULL;
+}
+//move the hole at slot i up until t fits, then fill it with (n, t)
+static void sift_up( Heap* heap, NINT i, NINT n, double t){
+    double* ht= heap->t;
+    NINT* hn= heap->n;
+    NINT parent, start= i;
+    while( i> 0){
+        parent= (i- 1)>> heap->shift;
+        if( ht[parent]<= t) break;
+        ht[i]= ht[parent];
+        hn[i]= hn[parent];
+        heap->idx[hn[i]]= i;
+        i= parent;
+    }
+    ht[i]= t;
+    //a node staying in its slot only changes its time
+    if( i!= start){
+        hn[i]= n;
+        heap->idx[n]= i;
+    }
+}
+//move the hole at slot i down until t fits, then fill it with (n, t)
+static void sift_down( Heap* heap, NINT i, NINT n, double t){
+    double* ht= heap->t;
+    NINT* hn= heap->n;
+    size_t child, last, c, V= heap->V;
+    NINT start= i;
+    double tc;
+    while( 1){
+        child= ((size_t)i<< heap->shift)+ 1;
+        if( child>= V) break;
+        last= child+ (size_t)heap->d;
+        if( last> V) last= V;
+        //smallest child, first one wins ties
+        tc= ht[child];
+        for( c= child+ 1; c< last; c++){
+            if( ht[c]< tc){
+                tc= ht[c];
+                child= c;
+            }
+        }
+        if( tc>= t) break;
+        ht[i]= tc;
+        hn[i]= hn[child];
+        heap->idx[hn[i]]= i;
+        i= (NINT)child;
+    }
+    ht[i]= t;
+    if( i!= start){
+        hn[i]= n;
+        heap->idx[n]= i;
+    }
+}
+void heap_sort( Heap* heap){
+    NINT i;
+    if( heap->sched== SCHED_CALENDAR){
+        calendar_build( &heap->cal);
+        return;
+    }
+    for( i= 0; i< heap->V; i++){
+        heap->idx[heap->n[i]]= i;
+    }
+    if( heap->V< 2) return;
+    //bottom-up heapify from the last internal slot
+    for( i= (heap->V- 2)>> heap->shift; ; i--){
+        sift_down( heap, i, heap->n[i], heap->t[i]);
+        if( i== 0) break;
+    }
+}
+void heap_update( Heap* heap, Reaction *reaction){
+    NINT i;
+    if( heap->sched== SCHED_CALENDAR){
+        calendar_update( &heap->cal, reaction->n, reaction->t);
+        return;
+    }
+    i= heap->idx[reaction->n];
+    if( reaction->t< heap->t[i]){
+        sift_up( heap, i, reaction->n, reaction->t);
+    }
+    else{
+        sift_down( heap, i, reaction->n, reaction->t);
+    }
+}
+void dump_heap( Heap* heap){
+    if( heap->sched== SCHED_CALENDAR){
+        printf("calendar queue, [%zu] nodes in [%zu] buckets of width[%.5g]\n", heap->cal.count, heap->cal.nb, heap->cal.w);
+        return;
+    }
+    if( heap->sched== SCHED_DIRECT|| heap->sched== SCHED_REJECTION){
+        printf("sum tree of [" fmt_n "] leaves, total rate[%.5g]\n", heap->sum.P, sum_tree_total( &heap->sum));
+        return;
+    }
+    printf("begin dump heap, arity[%d]\n", heap->d);
+    for( NINT i= 0; i< heap->V; i++){
+        printf("[%d][%d][%.5g] index[" fmt_n "]\n", i, heap->n[i], heap->t[i], heap->idx[heap->n[i]]);
+    }
+    printf("end dump heap\n");
+    fflush(stdout);
+}
@@ -0,0 +1,114 @@
+#ifndef HEAPH
+#define HEAPH
+
+#include "common.h"
+#include "calendar.h"
+#include "sumtree.h"
+#include <float.h>
+/*
+ * heap.h of GEMF in C language
+ * indexed priority queue of next reaction times, one slot per node
+ *
+ * d-ary min heap, d is 2, 4 or 8, with firing times and nodes in separate
+ * arrays; slot 0 is the top, children of slot i are d*i+1 ... d*i+d.
+ * the arrays are offset by d-1 slots on a 64-byte boundary, so the
+ * children of a slot start on a d*8-byte boundary and one sift step
+ * reads a single cache line for d= 8.
+ * sifts move a hole and write every moved node once.
+ *
+ * the scheduler is chosen apart from the arity. with SCHED_CALENDAR the
+ * same functions drive a calendar queue instead, see calendar.h, which
+ * leaves dormant nodes unscheduled.
+ *
+ * with SCHED_DIRECT no firing times are kept: sim_round runs the direct
+ * method on the sum tree of rates, see sumtree.h, and the time functions
+ * below are not used. SCHED_REJECTION keeps upper bounds of the rates in
+ * the sum tree instead, raised only when a rate exceeds its bound.
+ */
+
+#define HEAP_ARITY_DEFAULT 4
+//event schedulers, [SCHEDULER] heap, calendar, direct and rejection
+#define SCHED_HEAP 0
+#define SCHED_CALENDAR 1
+#define SCHED_DIRECT 2
+//the sum tree holds rate bounds
+#define SCHED_REJECTION 3
+//bound set on a node over its rate with SCHED_REJECTION
+#define SCHED_REJECTION_SLACK 1.1
+
+typedef struct{
+    //firing time and node of each slot, V slots
+    double* t;
+    NINT* n;
+    //slot of each node, 1 by _e
+    NINT* idx;
+    //nodes start from _s, end at _e-1
+    NINT _s;
+    NINT _e;
+    //nodes number V
+    NINT V;
+    //scheduler, SCHED_HEAP ... SCHED_REJECTION
+    int sched;
+    //arity d and log2(d), used if sched is SCHED_HEAP
+    int d;
+    int shift;
+    //allocated blocks of t and n
+    double* t_mem;
+    NINT* n_mem;
+    //calendar queue, used if sched is SCHED_CALENDAR
+    Calendar cal;
+    //rates or their bounds, used if sched is SCHED_DIRECT or SCHED_REJECTION
+    Sum_tree sum;
+} Heap;
+
+/*
+ *allocate heap for all nodes of graph
+ *
+ *input:  Graph* graph     [ graph struct]
+ *        int    sched     [ SCHED_HEAP, SCHED_CALENDAR, SCHED_DIRECT or SCHED_REJECTION]
+ *        int    d         [ arity of SCHED_HEAP, 2, 4 or 8]
+ *output: Heap*  heap      [ heap struct]
+ */
+void heap_init( Heap* heap, Graph* graph, int sched, int d);
+//free heap
+void heap_free( Heap* heap);
+//build heap from the times given by heap_fill
+void heap_sort( Heap* heap);
+//set firing time of reaction->n to reaction->t
+void heap_update( Heap* heap, Reaction *reaction);
+//dump heap content
+void dump_heap( Heap* heap);
+//check arity, <0 if not supported
+int heap_arity( LONG d);
+//scheduler of name heap, calendar, direct or rejection, <0 if not supported
+int heap_scheduler( const char* name);
+
+//initial firing time t of node n, the k-th node filled, before heap_sort
+static inline void heap_fill( Heap* heap, NINT k, NINT n, double t){
+    if( heap->sched== SCHED_CALENDAR){
+        heap->cal.t[n]= t;
+        return;
+    }
+    heap->n[k]= n;
+    heap->t[k]= t;
+}
+//firing time of node n
+static inline double get_tau( Heap* heap, NINT n){
+    if( heap->sched== SCHED_CALENDAR) return heap->cal.t[n];
+    return heap->t[heap->idx[n]];
+}
+//earliest firing time and its node, DBL_MAX if no node is scheduled
+static inline double heap_top_t( Heap* heap){
+    NINT n;
+    if( heap->sched== SCHED_CALENDAR){
+        n= calendar_top( &heap->cal);
+        return n== CAL_NIL? DBL_MAX: heap->cal.t[n];
+    }
+    return heap->t[0];
+}
+static inline NINT heap_top_n( Heap* heap){
+    if( heap->sched== SCHED_CALENDAR) return calendar_top( &heap->cal);
+    return heap->n[0];
+}
+
+#endif
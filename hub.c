@@ -0,0 +1,138 @@
+#include "hub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*
+ * hub.c of GEMF in C language
+ * lazy inducer counts along the arcs of hubs, see hub.h
+ */
+
+void* malloc1( size_t l, size_t s);
+
+//compartments reaching the inducer of each layer, through nodal or edge based transitions
+static void hub_reach( Hub_index* hi, Graph* graph, Transition* tran, Status* sts){
+    size_t layer, l, i, j;
+    char* r;
+    int more;
+    hi->cs= sts->_s+ sts->M;
+    hi->reach= (char*)malloc1( graph->L* hi->cs, sizeof(char));
+    memset( hi->reach, 0, graph->L* hi->cs);
+    for( layer= 0; layer< graph->L; layer++){
+        r= hi->reach+ layer* hi->cs;
+        r[tran->inducer_lst[layer]]= 1;
+        do{
+            more= 0;
+            for( i= sts->_s; i< hi->cs; i++){
+                if( r[i]) continue;
+                for( j= sts->_s; j< hi->cs&& !r[i]; j++){
+                    if( !r[j]) continue;
+                    if( tran->nodal_trn[i][j]> 0) r[i]= 1;
+                    for( l= 0; l< graph->L&& !r[i]; l++){
+                        if( tran->edge_trn[l][i][j]> 0) r[i]= 1;
+                    }
+                }
+                more|= r[i];
+            }
+        } while( more);
+    }
+}
+Hub_index* hub_index_build( Graph* graph, Transition* tran, Status* sts, NINT threshold){
+    Hub_index* hi;
+    size_t layer, j, total= 0;
+    size_t* pos;
+    NINT n, v;
+    //count hub arcs into every node
+    hi= (Hub_index*)malloc1( 1, sizeof(Hub_index));
+    hi->threshold= threshold;
+    hi->off= (size_t*)calloc( (size_t)graph->_e+ 1, sizeof(size_t));
+    if( hi->off== NULL){
+        printf("malloc hub index failed.\n");
+        error_exit( -1);
+    }
+    for( layer= 0; layer< graph->L; layer++){
+        if( graph_adj( graph, layer)!= layer) continue;
+        for( n= graph->_s; n< graph->_e; n++){
+            if( !hub_is( hi, graph, layer, n)) continue;
+            for( j= graph->offsets[layer][n]; j< graph->offsets[layer][n+ 1]; j++){
+                hi->off[graph->targets[layer][j]+ 1]++;
+                total++;
+            }
+        }
+    }
+    if( total== 0){
+        free( hi->off);
+        free( hi);
+        return NULL;
+    }
+    for( n= 0; n< graph->_e; n++){
+        hi->off[n+ 1]+= hi->off[n];
+    }
+    hi->hub= (NINT*)malloc1( total, sizeof(NINT));
+    hi->layer= (uint32_t*)malloc1( total, sizeof(uint32_t));
+    hi->w= (double*)malloc1( total, sizeof(double));
+    pos= (size_t*)malloc1( graph->_e, sizeof(size_t));
+    memcpy( pos, hi->off, sizeof(size_t)* graph->_e);
+    for( layer= 0; layer< graph->L; layer++){
+        if( graph_adj( graph, layer)!= layer) continue;
+        for( n= graph->_s; n< graph->_e; n++){
+            if( !hub_is( hi, graph, layer, n)) continue;
+            for( j= graph->offsets[layer][n]; j< graph->offsets[layer][n+ 1]; j++){
+                v= graph->targets[layer][j];
+                hi->hub[pos[v]]= n;
+                hi->layer[pos[v]]= (uint32_t)layer;
+                hi->w[pos[v]]= graph->weighted? graph->weights[layer][j]: 1.0;
+                pos[v]++;
+            }
+        }
+    }
+    free( pos);
+    hub_reach( hi, graph, tran, sts);
+    LOG(1, __FILE__, __LINE__, "[%zu] hub arcs of at least [" fmt_n "] per hub\n", total, threshold);
+    return hi;
+}
+void hub_index_free( Hub_index* hi){
+    if( hi== NULL) return;
+    free( hi->off);
+    free( hi->hub);
+    free( hi->layer);
+    free( hi->w);
+    free( hi->reach);
+    free( hi);
+}
+void hub_round_init( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts){
+    size_t e;
+    NINT v;
+    for( e= 0; e< hi->off[graph->_e]; e++){
+        st->hub_seen[e]= st->init_lst[hi->hub[e]];
+    }
+    for( v= graph->_s; v< graph->_e; v++){
+        st->hub_head[v]= hi->off[v]== hi->off[v+ 1]? 0: hub_headroom( hi, st, graph, tran, sts, v);
+    }
+    hub_rates( hi, st, graph, tran, sts);
+}
+void hub_rates( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts){
+    size_t e, l, a;
+    NINT v;
+    memset( st->hub_rat, 0, sizeof(double)* graph->L* graph->_e);
+    for( v= graph->_s; v< graph->_e; v++){
+        for( e= hi->off[v]; e< hi->off[v+ 1]; e++){
+            a= hi->layer[e];
+            for( l= a; l< graph->L; l++){
+                if( graph_adj( graph, l)!= a) continue;
+                st->hub_rat[l* graph->_e+ hi->hub[e]]+= hi->w[e]* tran->edge_trn[l][st->init_lst[v]][sts->M+ sts->_s];
+            }
+        }
+    }
+}
+double hub_headroom( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts, NINT v){
+    size_t e, l, a, s= st->init_lst[v];
+    double head= 0;
+    for( e= hi->off[v]; e< hi->off[v+ 1]; e++){
+        a= hi->layer[e];
+        for( l= a; l< graph->L; l++){
+            if( graph_adj( graph, l)!= a|| st->hub_seen[e]== tran->inducer_lst[l]|| !hi->reach[l* hi->cs+ st->hub_seen[e]]) continue;
+            head+= hi->w[e]* tran->edge_trn[l][s][sts->M+ sts->_s];
+        }
+    }
+    return head;
+}
@@ -0,0 +1,107 @@
+#ifndef HUBH
+#define HUBH
+
+#include "nrm.h"
+#include "graph_io.h"
+/*
+ * hub.h of GEMF in C language
+ * lazy inducer counts along the arcs of hubs, for the rejection method
+ *
+ * a node with at least [HUB_THRESHOLD] arcs in an adjacency is a hub of it.
+ * when a hub fires, its neighbours are not visited: every node keeps the
+ * hubs pointing to it, and the compartment each hub had when the node last
+ * counted it. the inducer counts of a node are brought up to date, its
+ * hub arcs reconciled, only when it is proposed, so a hub event costs as
+ * little as any other event.
+ *
+ * the rate bound of a node stays valid in between: besides the slack over
+ * its rate, it holds the headroom of the hubs it counts as not inducing
+ * but still able to reach the inducer compartment, the largest rise their
+ * events could cause. hubs in compartments that can never induce again,
+ * recovered or absorbing ones, leave no headroom, so bounds fall to zero
+ * with the last reaction. rates lag the hub events until the nodes are
+ * proposed, events are exact.
+ *
+ * the total rate R is kept exact: each hub holds, for every layer, the
+ * rate it induces on its neighbours as they are, the sum of its arc
+ * weights times their edge based rates out of their compartments. a hub
+ * event adds it to R, and a node that changes compartment updates it
+ * along its hub arcs, which hub_sync has just reconciled.
+ */
+
+typedef struct Hub_index Hub_index;
+struct Hub_index{
+    NINT threshold;
+    //hub arcs into node v are hub[off[v]...off[v+1]-1], with their adjacency layer and weight
+    size_t* off;
+    NINT* hub;
+    uint32_t* layer;
+    double* w;
+    //L by (_s+M), whether a compartment reaches the inducer of a layer by any transitions
+    char* reach;
+    size_t cs;
+};
+
+//index of hub arcs, NULL if no node reaches threshold
+Hub_index* hub_index_build( Graph* graph, Transition* tran, Status* sts, NINT threshold);
+void hub_index_free( Hub_index* hi);
+//start a round from exact counts, hubs counted as they are in st
+void hub_round_init( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts);
+//rates induced by hubs from the compartments in st
+void hub_rates( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts);
+//headroom of node v in its current compartment
+double hub_headroom( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts, NINT v);
+
+//whether node n is a hub of adjacency layer
+static inline int hub_is( Hub_index* hi, Graph* graph, size_t layer, NINT n){
+    return graph->offsets[layer][n+ 1]- graph->offsets[layer][n]>= hi->threshold;
+}
+
+//reconcile the hub arcs into node v, return the change of its rate, already in R, and refresh its headroom
+static inline double hub_sync( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts, NINT v){
+    size_t e, l, a, cur, old;
+    double dr= 0, change;
+    int k;
+    for( e= hi->off[v]; e< hi->off[v+ 1]; e++){
+        cur= st->init_lst[hi->hub[e]];
+        old= st->hub_seen[e];
+        if( cur== old) continue;
+        a= hi->layer[e];
+        for( l= a; l< graph->L; l++){
+            if( graph_adj( graph, l)!= a) continue;
+            k= (cur== tran->inducer_lst[l])- (old== tran->inducer_lst[l]);
+            if( k== 0) continue;
+            change= k* hi->w[e];
+            st->p_inducer_cal_lst[l][v]+= change;
+            dr+= change* tran->edge_trn[l][st->init_lst[v]][sts->M+ sts->_s];
+        }
+        st->hub_seen[e]= cur;
+    }
+    st->hub_head[v]= hub_headroom( hi, st, graph, tran, sts, v);
+    return dr;
+}
+//change of R by hub evt->ns firing evt over adjacency layer
+static inline double hub_fire( Sim_state* st, Graph* graph, Transition* tran, Event* evt, size_t layer){
+    size_t l;
+    double dr= 0;
+    int k;
+    for( l= layer; l< graph->L; l++){
+        if( graph_adj( graph, l)!= layer) continue;
+        k= inducer_change( tran, evt, l);
+        if( k!= 0) dr+= k* st->hub_rat[l* graph->_e+ evt->ns];
+    }
+    return dr;
+}
+//node evt->ns moved from evt->ni to evt->nj, update the rates induced by the hubs into it
+static inline void hub_move( Hub_index* hi, Sim_state* st, Graph* graph, Transition* tran, Status* sts, Event* evt){
+    size_t e, l, a, col= sts->M+ sts->_s;
+    for( e= hi->off[evt->ns]; e< hi->off[evt->ns+ 1]; e++){
+        a= hi->layer[e];
+        for( l= a; l< graph->L; l++){
+            if( graph_adj( graph, l)!= a) continue;
+            st->hub_rat[l* graph->_e+ hi->hub[e]]+= hi->w[e]* (tran->edge_trn[l][evt->nj][col]- tran->edge_trn[l][evt->ni][col]);
+        }
+    }
+}
+
+#endif
@@ -1,9 +1,19 @@
 #include "nrm.h"
+#include "tau.h"
+#include "hub.h"
+#include "ckpt.h"
+#include "stats.h"
+#include "rng.h"
+#include "graph_io.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <float.h>
 #include <string.h>
+#include <pthread.h>
+
+//exponential variates drawn at once when initializing tau
+#define RNG_BATCH 256
 
 
 /*
@@ -21,446 +31,976 @@ void* malloc1( size_t l, size_t s);
 double ** malloc2Dbl( size_t m, size_t n);
 int ** malloc2Int( size_t  m, size_t  n);
 NINT ** malloc2NINT( size_t m, size_t n);
-double** init_inducer(Graph* graph, Status* sts, Transition* tran);
-NINT** init_index(Graph* graph);
-double get_rat_lst(Graph* graph, Transition* tran, Status* sts, double** p_raw_rat_lst, double** p_inducer_cal_lst);
 void heart_beat( Heart_beat *hb);
-void heap_init(Heap* heap, Graph* graph);
-void heap_sort(Heap* heap);
-double cal_new_tau(double r_old, double r_new, double t_old, double t);
-double get_tau( Heap* heap, NINT n);
-void heap_update( Heap* heap, Reaction *reaction);
-void dump_heap( Heap* heap);
-void print_inducer( Graph* graph, Transition* tran, Status *sts, Event* evt, FILE* fil_out);
+double cal_new_tau(double r_old, double r_new, double t_old, double t, Rng* rng);
+void print_inducer( Graph* graph, Transition* tran, Sim_state* st, Event* evt, Out_stream* out, int binary);
+void* ensemble_worker( void* arg);
+void* branch_worker( void* arg);
+void evt_log_begin( Graph* graph, Status* sts, Run* run, NINT* init_cnt, Out_stream* out);
+static void grid_line( Status* sts, NINT* init_cnt, double t, Out_stream* out);
+static void grid_upto( Run* run, Status* sts, Sim_state* st, double t, Out_stream* out);
+
+//shared context of one ensemble or branch worker
+typedef struct{
+    Graph* graph;
+    Transition* tran;
+    Status* sts;
+    Run* run;
+    //initial state of every round or snapshot of every branch, read only
+    Sim_state* master;
+    //state owned by this worker
+    Sim_state* st;
+    //heart beat, only for the first worker
+    Heart_beat* hb;
+    //next round or branch to simulate and its random stream, guarded by lock
+    size_t* next_round;
+    Rng* next_rng;
+    pthread_mutex_t* lock;
+    //statistics across rounds
+    Ens_stats* es;
+    int ret;
+} Ensemble_arg;
+
 int nrm(Graph* graph, Transition* tran, Status* sts, Run* run){
-    FILE* fil_out;
-    size_t j, layer, compartment, section;
-    size_t count= 0;
-    int k;
-    NINT beg_num, end_num, cur_nod, i;
-    int** p_nsim_avg_lst= NULL;
-    //double T= 0.0;
-    double tmp_double, elapse_tim;
-    double *p_raw_rat_lst;
-    double **p_inducer_cal_lst;
-    double timer0, timer1;
-    double R= 0.0;
+    Out_stream* out;
+    size_t j, layer, compartment, section, w, workers;
+    size_t count= 0, next_round= 1;
+    Rng next_rng;
+    int ret= 0;
+    double tmp_double;
+    double timer0, timer1, t;
     Heart_beat hb;
-    Event evt;
-    struct{
-        double R;
-        size_t* init_lst;
-        double *p_raw_rat_lst;
-        double **p_inducer_cal_lst;
-    } restore;
-    Heap heap;
-    Reaction reaction;
+    Perf_counters pc;
+    Ckpt_header ck_hdr;
+    Ens_stats* es;
+    Run pre;
+    Sim_state master;
+    Sim_state* st;
+    Ensemble_arg* args;
+    pthread_t* tid;
+    pthread_mutex_t lock;
 
     if(_LOGLVL_> 1){
         dump_transition(tran);
         dump_graph(graph);
         dump_status(sts);
     }
-    srand((unsigned int)sts->random_seed);
+    if( (run->ckpt!= NULL|| run->resume!= NULL)&& (run->sim_rounds> 1|| run->tau_leap!= TAU_OFF|| run->out_codec!= OUT_CODEC_NONE)){
+        printf("checkpoints need a single round, the exact method and an uncompressed [OUT_FILE]\n");
+        return -1;
+    }
+    if( run->out_grid!= GRID_OFF&& (run->sim_rounds> 1|| run->out_format!= OUT_TEXT)){
+        printf("[OUT_GRID] is text output of a single round\n");
+        return -1;
+    }
+    for( j= 0; j< run->stop_num; j++){
+        if( (run->stop[j].kind== STOP_ZERO|| run->stop[j].kind== STOP_ABOVE)&& (run->stop[j].c< sts->_s|| run->stop[j].c>= sts->_s+ sts->M)){
+            printf("[STOP_WHEN] compartment[%zu] out of range\n", run->stop[j].c);
+            return -1;
+        }
+    }
+    if( run->stats_file!= NULL&& run->sim_rounds<= 1){
+        printf("[STATS_FILE] needs more than one round in [SIM_ROUNDS]\n");
+        return -1;
+    }
+    if( run->branch_num> 0&& (run->sim_rounds> 1|| run->tau_leap!= TAU_OFF|| run->ckpt!= NULL|| run->resume!= NULL)){
+        printf("[BRANCH] needs a single round of the exact method, without checkpoints\n");
+        return -1;
+    }
     //start timer
     timer0= gettimenow();
+    //round r uses the stream after r-1 jumps
+    rng_seed( &next_rng, sts->rng_kind, (uint64_t)sts->random_seed);
 
-    heap.reaction= NULL;
-    heap.idx= NULL;
-    heap._s= 0;
-    heap._e= 0;
-    heap.V= 0;
-    //sort graph
-    if( graph->weighted){
-        for( layer= 0; layer< graph->L; layer++){
-            qsort( graph->edge_w[layer], graph->E[layer], sizeof( Edge_w), Edge_cmp);
-        }
+    //build adjacency
+    prepare_graph(graph);
+    //inducers of a node are its in-neighbours
+    if( run->show_inducer|| run->show_infector){
+        prepare_reverse_graph(graph);
     }
-    else{
-        for( layer= 0; layer< graph->L; layer++){
-            qsort( graph->edge[layer], graph->E[layer], sizeof( Edge), Edge_cmp);
-        }
+    //hub arcs updated lazily
+    if( run->hub_threshold> 0){
+        run->hubs= hub_index_build( graph, tran, sts, run->hub_threshold);
     }
+    perf_phase( run->perf, PERF_BUILD, gettimenow()- timer0);
 
+    //initial state of every round works on the status list directly
+    memset( &master, 0, sizeof(Sim_state));
+    master.init_lst= sts->init_lst;
+    master.init_cnt= sts->init_cnt;
     //init inducer list
-    p_inducer_cal_lst=  init_inducer( graph, sts, tran);
-    //init adjacency index list
-    init_index(graph);
-
+    t= gettimenow();
+    master.p_inducer_cal_lst=  init_inducer( graph, sts, tran);
+    perf_phase( run->perf, PERF_INDUCER, gettimenow()- t);
 
     //calculate initial rate Ri for i in N
-    R= get_rat_lst( graph, tran, sts, &p_raw_rat_lst, p_inducer_cal_lst);
+    t= gettimenow();
+    master.R= get_rat_lst( graph, tran, sts, &master.p_raw_rat_lst, master.p_inducer_cal_lst);
+    perf_phase( run->perf, PERF_RATES, gettimenow()- t);
 
-    //open output file
-    fil_out= fopen( run->out_file, "w");
-    if( fil_out== NULL){
+    //open output file, written by its own thread; a resumed run goes on from the length it had at the checkpoint
+    if( run->resume!= NULL){
+        if( ckpt_header( run->resume, graph, sts, run, &ck_hdr)< 0) return -1;
+        out= out_open_at( run->out_file, ck_hdr.out_offset);
+    }
+    else{
+        out= out_open( run->out_file, run->out_codec, run->out_level);
+    }
+    if( out== NULL){
         printf("open output file[%s] faild\n", run->out_file);
         return -1;
     }
 
-    // ***********************events happen***************************************
-    if( run->sim_rounds> 1){
-        //save initial status
-        p_nsim_avg_lst= malloc2Int(sts->M, run->interval_num+ 1);
-        restore.init_lst= (size_t*)malloc1(graph->_e, sizeof(size_t));
-        restore.p_raw_rat_lst= (double*)malloc1(graph->_e, sizeof(double));
-        restore.p_inducer_cal_lst= malloc2Dbl(graph->L, (size_t)graph->_e);
-
-        restore.R= R;
-        memcpy( restore.init_lst, sts->init_lst, sizeof(size_t)*(graph->_e));
-        memcpy( restore.p_raw_rat_lst, p_raw_rat_lst, sizeof(double)*(graph->_e));
-        for( layer= 0; layer< graph->L; layer++){
-            memcpy( restore.p_inducer_cal_lst[layer], p_inducer_cal_lst[layer],  sizeof(double)*(graph->_e));
-        }
-        LOG(1, __FILE__, __LINE__, "save initial status success\n");
-    }
-
     //alert&reset timer
     timer1= gettimenow() - timer0;
     time_print("preprocess time cost[ ", timer1, "]\n");
-    hb.count= &count;
+    memset( &hb, 0, sizeof(Heart_beat));
     hb.timer0= gettimenow();
+    hb.perf= run->perf;
+    if( run->perf!= NULL){
+        run->perf->out_file= run->out_file;
+        run->perf->last_t= hb.timer0;
+    }
+    memset( &pc, 0, sizeof(Perf_counters));
 
-    heap_init(&heap, graph);
-    //repeat N times
-    size_t round= 1;
-    while(1){
-        LOG(1, __FILE__, __LINE__, "Start simulation round [%zu/%zu]\n", round, run->sim_rounds);
-        //reset count
-        count= 0;
-        //initial tau for all i
-        heap.V= graph->_e- graph->_s;
-        for( i= graph->_s; i< graph->_e; i++){
-            heap.reaction[i].n= i;
-            if( p_raw_rat_lst[i]> FLT_EPSILON){
-                heap.reaction[i].t= - log(rand()/(double)(RAND_MAX))/(p_raw_rat_lst[i]);
-            }
-            else{
-                heap.reaction[i].t= DBL_MAX;
-            }
+    // ***********************events happen***************************************
+    if( run->sim_rounds<= 1){
+        //single round, output events details, tau-leaping needs no heap
+        if( run->tau_leap== TAU_OFF){
+            heap_init(&master.heap, graph, run->scheduler, run->heap_arity);
         }
-
-        //make heap
-        heap_sort(&heap);
-        /*
-            printf("before update[%d]\n", __LINE__);
-        dump_heap( &heap);
-            printf("after update[%d]\n", __LINE__);
-            */
-
-        while( 1){
-            elapse_tim= heap.reaction[heap._s].t;
-            if (run->max_time < elapse_tim){
-                printf("T [%.6g] \treach limit [%6g], stop at [%zu] events.\t", elapse_tim, run->max_time, count);
-                break;
-            }
-            else if(count>= run->max_events){
-                printf("N [%zu] \treach limit [%zu], stop.\t", count, run->max_events);
-                break;
+        if( run->hubs!= NULL){
+            master.hub_seen= (size_t*)malloc1( run->hubs->off[graph->_e], sizeof(size_t));
+            master.hub_head= (double*)malloc1( graph->_e, sizeof(double));
+            master.hub_rat= (double*)malloc1( graph->L* graph->_e, sizeof(double));
+        }
+        master.rng= next_rng;
+        //infector stream as in libgemf
+        rng_infector( &next_rng, &master.inf_rng);
+        //a checkpoint brings its own state, streams included
+        if( run->resume!= NULL&& ckpt_load( run->resume, graph, sts, run, &master)< 0){
+            out_close( out);
+            return -1;
+        }
+        hb.count= &master.total;
+        hb.cnt= &master.perf;
+        if( run->out_format!= OUT_TEXT&& sts->M+ sts->_s> UINT16_MAX){
+            printf("binary output supports at most [%d] compartments\n", UINT16_MAX);
+            out_close( out);
+            return -1;
+        }
+        if( run->out_format!= OUT_TEXT&& run->resume== NULL){
+            evt_log_begin( graph, sts, run, sts->init_cnt, out);
+        }
+        //with branches, the round stops at the branch time and is the prefix of all of them
+        pre= *run;
+        if( run->branch_num> 0&& run->branch_time< run->max_time){
+            pre.max_time= run->branch_time;
+        }
+        ret= sim_round( graph, tran, sts, &pre, &master, 1, out, &hb);
+        count= master.count;
+        pc= master.perf;
+        //post population
+        printf("last moment population[ ");
+        for( compartment= sts->_s; compartment< sts->M+ sts->_s; compartment++){
+            kilobit_print(" ", sts->init_cnt[compartment], "");
+        }
+        printf(" ]\n");
+        if( ret== 0&& run->branch_num> 0){
+            //branch b uses the stream after b jumps, each worker its own copy of the snapshot;
+            //they run for what is left of the limits, and as many rounds as branches
+            master.elapse_tim= pre.max_time;
+            rng_jump( &next_rng);
+            pre= *run;
+            pre.sim_rounds= run->branch_num;
+            pre.max_events= run->max_events- master.count;
+            workers= run->threads;
+            if( workers> run->branch_num) workers= run->branch_num;
+            if( workers< 1) workers= 1;
+            LOG(1, __FILE__, __LINE__, "[%zu] branches at time [%lf] on [%zu] workers\n", run->branch_num, pre.max_time, workers);
+            st= (Sim_state*)malloc1( workers, sizeof(Sim_state));
+            args= (Ensemble_arg*)malloc1( workers, sizeof(Ensemble_arg));
+            tid= (pthread_t*)malloc1( workers, sizeof(pthread_t));
+            pthread_mutex_init( &lock, NULL);
+            hb.count= &st[0].total;
+            hb.cnt= &st[0].perf;
+            for( w= 0; w< workers; w++){
+                sim_state_init( &st[w], graph, sts, run);
+                args[w].graph= graph;
+                args[w].tran= tran;
+                args[w].sts= sts;
+                args[w].run= &pre;
+                args[w].master= &master;
+                args[w].st= &st[w];
+                args[w].hb= w? NULL: &hb;
+                args[w].next_round= &next_round;
+                args[w].next_rng= &next_rng;
+                args[w].lock= &lock;
+                args[w].es= NULL;
+                args[w].ret= 0;
             }
-            //get a weighted radom node, ns-- active node, ni-- past_status, nj-- present_status
-            evt.ns= heap.reaction[heap._s].n;
-
-            get_next_evt(p_raw_rat_lst, p_inducer_cal_lst, graph, tran, sts, &evt, &heap);
-            count++;
-            sts->init_lst[evt.ns]= evt.nj;
-            LOG(2, __FILE__, __LINE__, "event[%d], time[%.4g]\n", count, elapse_tim);
-            //if run only once, output events details, else calculate intervals
-            if( run->sim_rounds<=1){
-                sts->init_cnt[evt.ni] --;
-                sts->init_cnt[evt.nj] ++;
-                fprintf( fil_out, "%lf %lf "fmt_n" %zu %zu", elapse_tim, R, evt.ns, evt.ni, evt.nj);
-                for( compartment= sts->_s; compartment< sts->M+ sts->_s; compartment++){
-                    fprintf( fil_out, " %d", sts->init_cnt[compartment]);
-                }
-                if(run->show_inducer){
-                    print_inducer( graph, tran, sts, &evt, fil_out);
+            for( w= 1; w< workers; w++){
+                if( pthread_create( &tid[w], NULL, branch_worker, &args[w])){
+                    printf("create worker[%zu] failed\n", w);
+                    error_exit( -1);
                 }
-                fprintf( fil_out, "\n");
             }
-            else{
-                //calculate intervals
-                section= (size_t)((double)run->interval_num*(elapse_tim/ run->max_time));
-                if( section>= run->interval_num){
-                    printf("fatal error, wrong interval point value[%zu], max[%zu]\n", section, run->interval_num);
-                    return -1;
-                }
-                p_nsim_avg_lst[evt.ni - sts->_s][section] --;
-                p_nsim_avg_lst[evt.nj - sts->_s][section] ++;
+            branch_worker( &args[0]);
+            for( w= 1; w< workers; w++){
+                pthread_join( tid[w], NULL);
             }
-
-            //update rates
-            //1. ni->nj
-            //nodal transition rate
-            tmp_double= tran->nodal_trn[evt.nj][sts->M+ sts->_s];
-            //edge based transition rate
-            for( layer= 0; layer< graph->L; layer++){
-                tmp_double+= tran->edge_trn[layer][evt.nj][sts->M+ sts->_s]* p_inducer_cal_lst[layer][evt.ns];
+            pthread_mutex_destroy( &lock);
+            for( w= 0; w< workers; w++){
+                if( args[w].ret) ret= args[w].ret;
+                count+= st[w].total;
+                perf_merge( &pc, &st[w].perf);
+                sim_state_free( &st[w], graph, sts);
             }
-            if( tmp_double> FLT_EPSILON){
-                reaction.t= - log(rand()/(double)(RAND_MAX))/(tmp_double)+ elapse_tim;
-            }
-            else{
-                reaction.t= DBL_MAX;
-            }
-            reaction.n= evt.ns;
-            /*
-            printf("before update[%d]\n", __LINE__);
-            dump_heap(&heap);
-            printf("reaction[%d][%lf]LINE[%d]\n", reaction.n, reaction.t, __LINE__);
-            printf("after update[%d]\n", __LINE__);
-            */
-            heap_update(&heap, &reaction);
-            /*
-            dump_heap(&heap);
-            printf("after update[%d]\n", __LINE__);
-            */
-            R= R+ tmp_double - p_raw_rat_lst[evt.ns];
-            p_raw_rat_lst[evt.ns]= tmp_double;
-            //2. inducer_neighbour++/--
-            for( layer= 0; layer< graph->L; layer++){
-                k= 0;
-                if( evt.ni== tran->inducer_lst[layer]){
-                    k= - 1;
-                }
-                else if( evt.nj== tran->inducer_lst[layer]){
-                    k= 1;
-                }
-                if( k != 0){
-                    if( evt.ns== graph->_s){
-                       beg_num= 0;
-                    }
-                    else{
-                        beg_num= graph->index[layer][evt.ns];
-                    }
-                    end_num= graph->index[layer][evt.ns+1];
-                    while( beg_num< end_num){
-                        double change;
-                        if( graph->weighted){
-                            cur_nod= graph->edge_w[layer][beg_num].j;
-                            change= k*graph->edge_w[layer][beg_num].w;
-                        }
-                        else{
-                            cur_nod= graph->edge[layer][beg_num].j;
-                            change= (double)k;
-                        }
-                        p_inducer_cal_lst[layer][cur_nod]+= change;
-                        //adjust neighbour rate& total rate
-                        tmp_double= change* tran->edge_trn[layer][sts->init_lst[cur_nod]][sts->M+ sts->_s];
-                        R+= tmp_double;
-                        //update affected rates and time
-                        reaction.n= cur_nod;
-                        reaction.t= cal_new_tau(p_raw_rat_lst[cur_nod], p_raw_rat_lst[cur_nod]+tmp_double, get_tau(&heap, cur_nod), elapse_tim);
-                        /*
-            printf("before update[%d]\n", __LINE__);
-            dump_heap(&heap);
-            printf("reaction[%d][%lf]LINE[%d]\n", reaction.n, reaction.t, __LINE__);
-            printf("after update[%d]\n", __LINE__);
-            */
-                        heap_update(&heap, &reaction);
-                        /*
-            dump_heap(&heap);
-            printf("after update[%d]\n", __LINE__);
-            */
-                        p_raw_rat_lst[cur_nod]+= tmp_double;
-                        beg_num++;
-                    }
-                }
+            free( st);
+            free( args);
+            free( tid);
+        }
+        heap_free( &master.heap);
+        free( master.hub_seen);
+        free( master.hub_head);
+        free( master.hub_rat);
+    }
+    else{
+        //repeat N times, rounds are independent and spread over workers
+        workers= run->threads;
+        if( workers> run->sim_rounds) workers= run->sim_rounds;
+        if( workers< 1) workers= 1;
+        LOG(1, __FILE__, __LINE__, "Ensemble of [%zu] rounds on [%zu] workers\n", run->sim_rounds, workers);
+        st= (Sim_state*)malloc1( workers, sizeof(Sim_state));
+        args= (Ensemble_arg*)malloc1( workers, sizeof(Ensemble_arg));
+        tid= (pthread_t*)malloc1( workers, sizeof(pthread_t));
+        pthread_mutex_init( &lock, NULL);
+        es= ens_stats_init( sts->M, run->interval_num, run->stats_file!= NULL);
+        hb.count= &st[0].total;
+        hb.cnt= &st[0].perf;
+        for( w= 0; w< workers; w++){
+            sim_state_init( &st[w], graph, sts, run);
+            args[w].graph= graph;
+            args[w].tran= tran;
+            args[w].sts= sts;
+            args[w].run= run;
+            args[w].master= &master;
+            args[w].st= &st[w];
+            args[w].hb= w? NULL: &hb;
+            args[w].next_round= &next_round;
+            args[w].next_rng= &next_rng;
+            args[w].lock= &lock;
+            args[w].es= es;
+            args[w].ret= 0;
+        }
+        for( w= 1; w< workers; w++){
+            if( pthread_create( &tid[w], NULL, ensemble_worker, &args[w])){
+                printf("create worker[%zu] failed\n", w);
+                error_exit( -1);
             }
-            heart_beat(&hb);
         }
-        printf("stop simulation round [%zu/%zu]\n", round, run->sim_rounds);
-        if(++round> run->sim_rounds){
-            break;
+        ensemble_worker( &args[0]);
+        for( w= 1; w< workers; w++){
+            pthread_join( tid[w], NULL);
         }
-        //restore original status and run again
-        R= restore.R;
-        memcpy( sts->init_lst, restore.init_lst, sizeof(size_t)*(graph->_e));
-        memcpy( p_raw_rat_lst, restore.p_raw_rat_lst, sizeof(double)*(graph->_e));
-        for(layer= 0; layer< graph->L; layer++){
-            memcpy( p_inducer_cal_lst[layer], restore.p_inducer_cal_lst[layer],  sizeof(double)*(graph->_e));
+        pthread_mutex_destroy( &lock);
+
+        for( w= 0; w< workers; w++){
+            if( args[w].ret) ret= args[w].ret;
+            count+= st[w].total;
+            perf_merge( &pc, &st[w].perf);
         }
-        LOG(1, __FILE__, __LINE__, "End simulation round [%zu/%zu]\n", round, run->sim_rounds);
-    }
-    //post population
-    if( run->sim_rounds<=1){
-        printf("last moment population[ ");
-        for( compartment= sts->_s; compartment< sts->M+ sts->_s; compartment++){
-            kilobit_print(" ", sts->init_cnt[compartment], "");
+        printf("rounds ended by[");
+        for( j= 0; j< END_KINDS; j++){
+            if( pc.ends[j]> 0) printf(" %s %llu", perf_end_nam[j], (unsigned long long)pc.ends[j]);
         }
         printf(" ]\n");
-    }
-    else{
+
         //save results
         //output initial status count
-        fprintf( fil_out, "0.0");
-        tmp_double= elapse_tim/ run->interval_num;
+        out_printf( out, "0.0");
+        tmp_double= run->max_time/ run->interval_num;
         for( j= sts->_s; j< sts->M+ sts->_s; j++){
-            fprintf( fil_out, " %lf", (double)sts->init_cnt[j]);
+            out_printf( out, " %lf", (double)sts->init_cnt[j]);
         }
-        fprintf( fil_out, "\n%lf ", tmp_double);
-        //output first interval
-        for( j= 0; j< sts->M; j++){
-            p_nsim_avg_lst[j][0]+= run->sim_rounds*sts->init_cnt[j+ sts->_s];
-            fprintf( fil_out, "%lf ", p_nsim_avg_lst[j][0]/ (double)run->sim_rounds);
-        }
-        //output rest interval
-        for( section= 1; section< run->interval_num; section++){
-            fprintf( fil_out, "\n%lf ", (section+1)* tmp_double);
+        //output mean of each interval
+        for( section= 0; section< run->interval_num; section++){
+            out_printf( out, "\n%lf ", (section+1)* tmp_double);
             for( j= 0; j< sts->M; j++){
-                p_nsim_avg_lst[j][section]+= p_nsim_avg_lst[j][section - 1];
-                fprintf( fil_out, "%lf ", p_nsim_avg_lst[j][section]/ (double)run->sim_rounds);
+                out_printf( out, "%lf ", es->sum[j* es->I+ section]/ (double)run->sim_rounds);
             }
         }
+        if( run->stats_file!= NULL&& ens_stats_write( es, run->stats_file, sts->init_cnt+ sts->_s, tmp_double)< 0){
+            printf("write statistics file[%s] faild\n", run->stats_file);
+            ret= -1;
+        }
+        ens_stats_free( es);
+        for( w= 0; w< workers; w++){
+            sim_state_free( &st[w], graph, sts);
+        }
+        free( st);
+        free( args);
+        free( tid);
     }
     // ***********************events end***************************************
     //alert&end timer
     kilobit_print("events number[ ", (LONG)count, " ]\n");
     time_print("preprocess time cost[ ", timer1, "]\n");
-    time_print("simulation time cost[ ", gettimenow() - hb.timer0, "]\n");
+    tmp_double= gettimenow() - hb.timer0;
+    perf_phase( run->perf, PERF_LOOP, tmp_double);
+    time_print("simulation time cost[ ", tmp_double, "]\n");
+    if( tmp_double> 0){
+        kilobit_print("events per second[ ", (LONG)(count/ tmp_double), " ]\n");
+    }
 
     //clean up
     LOG(1, __FILE__, __LINE__, "Begin clean up\n");
     for( layer= 0; layer< graph->L; layer++){
-        free( p_inducer_cal_lst[layer]);
+        free( master.p_inducer_cal_lst[layer]);
     }
-    if( run->sim_rounds> 1){
-        for( j= 0; j< sts->M; j++){
-            free( p_nsim_avg_lst[j]);
+    free( master.p_inducer_cal_lst);
+    free( master.p_raw_rat_lst);
+    hub_index_free( run->hubs);
+    run->hubs= NULL;
+
+    t= gettimenow();
+    if( run->ckpt!= NULL&& ckpt_wait( run->ckpt)< 0){
+        printf("write checkpoint file[%s] faild\n", run->ckpt->fil_nam);
+        ret= -1;
+    }
+    if( out_close( out)< 0){
+        printf("write output file[%s] faild\n", run->out_file);
+        ret= -1;
+    }
+    perf_phase( run->perf, PERF_OUTPUT, gettimenow()- t);
+    if( run->perf!= NULL&& perf_report( run->perf, &pc, count, 1)< 0){
+        printf("write report file[%s] faild\n", run->perf->fil_nam);
+    }
+    LOG(1, __FILE__, __LINE__, "End clean up\n");
+    return ret;
+}
+
+//build CSR adjacency of layers still holding an edge list
+void prepare_graph(Graph* graph){
+    size_t layer;
+    for( layer= 0; layer< graph->L; layer++){
+        if( graph->offsets[layer]!= NULL) continue;
+        if( graph_csr_build( graph, layer)< 0){
+            error_exit( -1);
         }
-        free( p_nsim_avg_lst);
-        free( restore.init_lst);
-        free( restore.p_raw_rat_lst);
-        for( layer= 0; layer< graph->L; layer++){
-            free( restore.p_inducer_cal_lst[layer]);
+    }
+}
+
+void prepare_reverse_graph(Graph* graph){
+    size_t layer;
+    for( layer= 0; layer< graph->L; layer++){
+        if( graph_reverse_build( graph, layer)< 0){
+            error_exit( -1);
         }
-        free( restore.p_inducer_cal_lst);
     }
-    free( p_inducer_cal_lst);
-    free( p_raw_rat_lst);
-    if( heap.reaction!= NULL){
-        free( heap.reaction);
+}
+
+//simulate one round from the current content of st
+int sim_round( Graph* graph, Transition* tran, Status* sts, Run* run, Sim_state* st, size_t round, Out_stream* out, Heart_beat* hb){
+    size_t layer, l;
+    int k, direct, reject, fill= 0, end= END_TIME;
+    NINT cur_nod, i;
+    size_t beg_num, end_num, deg;
+    double tmp_double, elapse_tim, slack;
+    double* p_raw_rat_lst= st->p_raw_rat_lst;
+    double** p_inducer_cal_lst= st->p_inducer_cal_lst;
+    Heap* heap= &st->heap;
+    Hub_index* hubs;
+    Event evt;
+    Reaction reaction;
+    LINE msg;
+    double exp_lst[RNG_BATCH];
+
+    if( run->tau_leap!= TAU_OFF){
+        return tau_round( graph, tran, sts, run, st, round, out, hb);
+    }
+    LOG(1, __FILE__, __LINE__, "Start simulation round [%zu/%zu]\n", round, run->sim_rounds);
+    //direct method, the sum tree holds the rates and no firing time is kept,
+    //rejection method, it holds bounds slack times the rates they were last set from
+    reject= heap->sched== SCHED_REJECTION;
+    direct= heap->sched== SCHED_DIRECT|| reject;
+    slack= reject? SCHED_REJECTION_SLACK: 1.0;
+    //hub arcs are reconciled when their target is proposed, bounds hold the headroom of hubs
+    hubs= reject? run->hubs: NULL;
+    st->t0= gettimenow();
+    //a round restored from a checkpoint goes on from its time, counts and scheduler
+    if( st->resumed== SIM_RESUMED){
+        st->resumed= 0;
+        elapse_tim= st->elapse_tim;
+        grid_begin( run, sts, st, elapse_tim, 0, out);
+        //rates induced by hubs follow from the compartments, they are not in the checkpoint
+        if( hubs!= NULL){
+            hub_rates( hubs, st, graph, tran, sts);
+        }
     }
-    if( heap.idx!= NULL){
-        free( heap.idx);
+    else{
+        //reset count, a branch starts at the time of its snapshot and keeps its hub arcs,
+        //waiting times are memoryless so they are drawn anew
+        st->count= 0;
+        elapse_tim= st->resumed== SIM_BRANCHED? st->elapse_tim: 0;
+        grid_begin( run, sts, st, elapse_tim, 1, out);
+        if( hubs!= NULL&& st->resumed!= SIM_BRANCHED){
+            hub_round_init( hubs, st, graph, tran, sts);
+        }
+        st->resumed= 0;
+        if( direct){
+            sum_tree_build( &heap->sum, p_raw_rat_lst, slack, hubs!= NULL? st->hub_head: NULL);
+        }
+        //initial tau for all i, exponential variates are drawn in batches
+        for( i= graph->_s; i< graph->_e&& !direct; i++){
+            if( (i- graph->_s)% RNG_BATCH== 0){
+                rng_fill_exp( &st->rng, exp_lst, RNG_BATCH);
+            }
+            if( p_raw_rat_lst[i]> FLT_EPSILON){
+                heap_fill( heap, i- graph->_s, i, elapse_tim+ exp_lst[(i- graph->_s)% RNG_BATCH]/(p_raw_rat_lst[i]));
+            }
+            else{
+                heap_fill( heap, i- graph->_s, i, DBL_MAX);
+            }
+        }
+
+        //make heap
+        if( !direct){
+            heap_sort(heap);
+        }
     }
 
-    fclose( fil_out);
-    LOG(1, __FILE__, __LINE__, "End clean up\n");
-    return 0;
-}
+    while( 1){
+        if( direct){
+            //time to the next event of any node, then the node by its share of the total rate;
+            //with bounds, the time to the next proposal and the node by its share of the bounds
+            tmp_double= sum_tree_total( &heap->sum);
+            //bounds may outlast the last reaction, the exact total rate decides, as small rates do for the heap
+            if( reject&& st->R<= FLT_EPSILON) tmp_double= 0;
+            elapse_tim= tmp_double> 0? elapse_tim+ rng_exp( &st->rng)/ tmp_double: DBL_MAX;
+        }
+        else{
+            elapse_tim= heap_top_t(heap);
+        }
+        //no event left first, it is past any finite max_time
+        if( elapse_tim== DBL_MAX){
+            sprintf(msg, "no more events, stop at [%zu] events.\t", st->count);
+            fill= 1;
+            end= END_EMPTY;
+            break;
+        }
+        else if (run->max_time < elapse_tim){
+            sprintf(msg, "T [%.6g] \treach limit [%6g], stop at [%zu] events.\t", elapse_tim, run->max_time, st->count);
+            fill= 1;
+            break;
+        }
+        else if(st->count>= run->max_events){
+            sprintf(msg, "N [%zu] \treach limit [%zu], stop.\t", st->count, run->max_events);
+            end= END_EVENTS;
+            break;
+        }
+        //get a weighted radom node, ns-- active node, ni-- past_status, nj-- present_status
+        evt.ns= direct? sum_tree_sample( &heap->sum, rng_uniform( &st->rng)): heap_top_n(heap);
+        if( reject){
+            if( hubs!= NULL){
+                //R took the change when the hubs fired
+                p_raw_rat_lst[evt.ns]+= hub_sync( hubs, st, graph, tran, sts, evt.ns);
+            }
+            //accepted with probability rate/ bound, else the bound is tightened to the rate
+            tmp_double= sum_tree_get( &heap->sum, evt.ns);
+            if( rng_uniform( &st->rng)* tmp_double>= p_raw_rat_lst[evt.ns]){
+                sum_tree_set( &heap->sum, evt.ns, slack* p_raw_rat_lst[evt.ns]+ (hubs!= NULL? st->hub_head[evt.ns]: 0));
+                st->perf.rejections++;
+                continue;
+            }
+        }
 
-//chose a weighted random node from the network
-size_t weighed_rat_rand(double* rat_lst, size_t len){
-    double* tmp_rat_sum;
-    double key;
-    size_t i, left, right, mid, ret;
-    tmp_rat_sum = (double*)malloc(sizeof(double)* (len+1))+ 1;
-    if( tmp_rat_sum== NULL){
-        printf("Memory allocation failure for temp rate sumation list, size[%zu]\n", sizeof(double)*(len+ 1));
-        exit( - 1);
-    }
-    tmp_rat_sum[- 1]= 0.0;
-
-    //accumulate weight list
-    for( i= 0; i< len; i++){
-        tmp_rat_sum[i]= rat_lst[i]+ tmp_rat_sum[i - 1];
-    }
-    left= 0;
-    right= len - 1;
-    key= (rand()/(double)RAND_MAX)*tmp_rat_sum[right];
-
-    //binary search target section
-    while(1){
-        //stop condition
-        if( left== right){
-            ret= left;
+        get_next_evt(st, graph, tran, sts, &evt);
+        st->count++;
+        st->total++;
+        st->init_lst[evt.ns]= evt.nj;
+        st->init_cnt[evt.ni] --;
+        st->init_cnt[evt.nj] ++;
+        LOG(2, __FILE__, __LINE__, "event[%d], time[%.4g]\n", st->count, elapse_tim);
+        //if run only once, output events details, else calculate intervals
+        k= sim_event_out( graph, tran, sts, run, st, elapse_tim, &evt, out);
+        if( k< 0) return -1;
+        if( k> 0){
+            sprintf(msg, "N [%zu] \tstopped by event callback.\t", st->count);
+            end= END_HOOK;
             break;
         }
-        else if( left== right - 1){
-            if( key< tmp_rat_sum[left]){
-                ret= left;
-                break;
+
+        //update rates
+        //1. ni->nj
+        //nodal transition rate
+        tmp_double= tran->nodal_trn[evt.nj][sts->M+ sts->_s];
+        //edge based transition rate
+        for( layer= 0; layer< graph->L; layer++){
+            tmp_double+= tran->edge_trn[layer][evt.nj][sts->M+ sts->_s]* p_inducer_cal_lst[layer][evt.ns];
+        }
+        if( hubs!= NULL){
+            st->hub_head[evt.ns]= hub_headroom( hubs, st, graph, tran, sts, evt.ns);
+            hub_move( hubs, st, graph, tran, sts, &evt);
+        }
+        if( direct){
+            sum_tree_set( &heap->sum, evt.ns, slack* tmp_double+ (hubs!= NULL? st->hub_head[evt.ns]: 0));
+        }
+        else{
+            if( tmp_double> FLT_EPSILON){
+                reaction.t= rng_exp(&st->rng)/(tmp_double)+ elapse_tim;
             }
             else{
-                ret= right;
+                reaction.t= DBL_MAX;
+            }
+            reaction.n= evt.ns;
+            heap_update(heap, &reaction);
+        }
+        st->perf.heap_updates++;
+        st->R= st->R+ tmp_double - p_raw_rat_lst[evt.ns];
+        p_raw_rat_lst[evt.ns]= tmp_double;
+        //2. inducer_neighbour++/--, one sweep over each adjacency for all layers sharing it
+        deg= 0;
+        for( layer= 0; layer< graph->L; layer++){
+            if( graph_adj( graph, layer)!= layer) continue;
+            beg_num= graph->offsets[layer][evt.ns];
+            end_num= graph->offsets[layer][evt.ns+1];
+            deg+= end_num- beg_num;
+            k= 0;
+            for( l= layer; l< graph->L&& !k; l++){
+                k= graph_adj( graph, l)== layer&& inducer_change( tran, &evt, l);
+            }
+            if( k== 0) continue;
+            //neighbours of a hub catch up when they are proposed, R at once
+            if( hubs!= NULL&& hub_is( hubs, graph, layer, evt.ns)){
+                st->R+= hub_fire( st, graph, tran, &evt, layer);
+                continue;
+            }
+            st->perf.neighbor_updates+= end_num- beg_num;
+            while( beg_num< end_num){
+                double change, w, head;
+                cur_nod= graph->targets[layer][beg_num];
+                w= graph->weighted? graph->weights[layer][beg_num]: 1.0;
+                //adjust inducer weights and the rate change of the neighbour over the layers
+                tmp_double= 0.0;
+                for( l= layer; l< graph->L; l++){
+                    if( graph_adj( graph, l)!= layer) continue;
+                    k= inducer_change( tran, &evt, l);
+                    if( k== 0) continue;
+                    change= k* w;
+                    p_inducer_cal_lst[l][cur_nod]+= change;
+                    tmp_double+= change* tran->edge_trn[l][st->init_lst[cur_nod]][sts->M+ sts->_s];
+                }
+                st->R+= tmp_double;
+                //a neighbour in a compartment without edge based transitions keeps its time or leaf
+                if( tmp_double== 0.0){
+                    beg_num++;
+                    continue;
+                }
+                if( direct){
+                    //with bounds, a neighbour whose rate is still within its bound keeps its leaf
+                    p_raw_rat_lst[cur_nod]+= tmp_double;
+                    head= hubs!= NULL? st->hub_head[cur_nod]: 0;
+                    if( !reject|| p_raw_rat_lst[cur_nod]+ head> sum_tree_get( &heap->sum, cur_nod)){
+                        sum_tree_set( &heap->sum, cur_nod, slack* p_raw_rat_lst[cur_nod]+ head);
+                        st->perf.heap_updates++;
+                    }
+                    beg_num++;
+                    continue;
+                }
+                //update affected rates and time
+                reaction.n= cur_nod;
+                reaction.t= cal_new_tau(p_raw_rat_lst[cur_nod], p_raw_rat_lst[cur_nod]+tmp_double, get_tau(heap, cur_nod), elapse_tim, &st->rng);
+                heap_update(heap, &reaction);
+                st->perf.heap_updates++;
+                p_raw_rat_lst[cur_nod]+= tmp_double;
+                beg_num++;
+            }
+        }
+        st->perf.deg_hist[perf_deg_bucket( deg)]++;
+        if( hb!= NULL){
+            heart_beat(hb);
+        }
+        if( run->stop_num> 0&& (k= stop_check( run, st, &evt))!= 0){
+            sprintf(msg, "T [%.6g] \t[STOP_WHEN] %s met, stop at [%zu] events.\t", elapse_tim, perf_end_nam[k], st->count);
+            end= k;
+            break;
+        }
+        if( run->ckpt!= NULL&& ckpt_due( run->ckpt, st->count)){
+            st->elapse_tim= elapse_tim;
+            ckpt_save( run->ckpt, graph, sts, run, st, out);
+            if( ckpt_signal== 2){
+                sprintf(msg, "N [%zu] 	checkpoint taken on SIGTERM, stop.\t", st->count);
+                end= END_SIGNAL;
                 break;
             }
         }
+    }
+    st->elapse_tim= elapse_tim;
+    if( fill){
+        grid_end( run, sts, st, out);
+    }
+    st->end= end;
+    st->perf.ends[end]++;
+    st->perf.rounds++;
+    if( !run->quiet){
+        printf("%sstop simulation round [%zu/%zu]\n", msg, round, run->sim_rounds);
+    }
+    LOG(1, __FILE__, __LINE__, "End simulation round [%zu/%zu]\n", round, run->sim_rounds);
+    return 0;
+}
 
-        //binary
-        mid= (left+right)/2;
-        if( key < tmp_rat_sum[mid]){
-            right= mid;
+//write an event to out, the hook or the histogram, 1 if the hook stops the round
+int sim_event_out( Graph* graph, Transition* tran, Status* sts, Run* run, Sim_state* st, double t, Event* evt, Out_stream* out){
+    Evt_record rec;
+    uint32_t cnt;
+    size_t compartment, section;
+    NINT i;
+
+    if( st->hook!= NULL){
+        return st->hook( st, t, evt, st->hook_arg)? 1: 0;
+    }
+    else if( st->p_nsim_avg_lst== NULL&& run->out_grid== GRID_TIME){
+        //grid points before the event see the population before it
+        if( (double)st->grid_i* run->grid_step< t){
+            st->init_cnt[evt->ni]++;
+            st->init_cnt[evt->nj]--;
+            grid_upto( run, sts, st, t, out);
+            st->init_cnt[evt->ni]--;
+            st->init_cnt[evt->nj]++;
         }
-        else{
-            left= mid;
+    }
+    else if( st->p_nsim_avg_lst== NULL&& run->out_grid== GRID_EVENTS){
+        if( st->count% run->grid_events== 0){
+            grid_line( sts, st->init_cnt, t, out);
         }
     }
-    while(1){
-        if( ret== 0) break;
-        if( tmp_rat_sum[ret] < tmp_rat_sum[ret - 1]){
-            ret --;
+    else if( st->p_nsim_avg_lst== NULL&& run->out_format!= OUT_TEXT){
+        rec.t= t;
+        rec.R= st->R;
+        rec.ns= evt->ns;
+        rec.ni= (uint16_t)evt->ni;
+        rec.nj= (uint16_t)evt->nj;
+        out_write( out, &rec, sizeof(rec));
+        if(run->show_infector){
+            i= sample_infector( graph, tran, st, evt, &st->inf_rng);
+            out_write( out, &i, sizeof(NINT));
         }
-        else{
+        if(run->show_inducer){
+            print_inducer( graph, tran, st, evt, out, 1);
+        }
+        //population keyframe, in between it follows from ni/nj
+        if( run->out_format== OUT_BINARY_COUNTS&& st->count% EVT_LOG_KEYFRAME== 0){
+            for( compartment= sts->_s; compartment< sts->M+ sts->_s; compartment++){
+                cnt= st->init_cnt[compartment];
+                out_write( out, &cnt, sizeof(cnt));
+            }
+        }
+    }
+    else if( st->p_nsim_avg_lst== NULL){
+        out_printf( out, "%lf %lf "fmt_n" %zu %zu", t, st->R, evt->ns, evt->ni, evt->nj);
+        for( compartment= sts->_s; compartment< sts->M+ sts->_s; compartment++){
+            out_printf( out, " %d", st->init_cnt[compartment]);
+        }
+        if(run->show_infector){
+            i= sample_infector( graph, tran, st, evt, &st->inf_rng);
+            if( i== NO_INFECTOR) out_write( out, " -1", 3);
+            else out_printf( out, " "fmt_n, i);
+        }
+        if(run->show_inducer){
+            print_inducer( graph, tran, st, evt, out, 0);
+        }
+        out_write( out, "\n", 1);
+    }
+    else{
+        //calculate intervals
+        section= (size_t)((double)run->interval_num*(t/ run->max_time));
+        if( section>= run->interval_num){
+            printf("fatal error, wrong interval point value[%zu], max[%zu]\n", section, run->interval_num);
+            return -1;
+        }
+        st->p_nsim_avg_lst[evt->ni - sts->_s][section] --;
+        st->p_nsim_avg_lst[evt->nj - sts->_s][section] ++;
+    }
+    return 0;
+}
+
+//population at time t, a line of [OUT_GRID]
+static void grid_line( Status* sts, NINT* init_cnt, double t, Out_stream* out){
+    size_t compartment;
+    out_printf( out, "%lf", t);
+    for( compartment= sts->_s; compartment< sts->M+ sts->_s; compartment++){
+        out_printf( out, " %d", init_cnt[compartment]);
+    }
+    out_write( out, "\n", 1);
+}
+void grid_begin( Run* run, Status* sts, Sim_state* st, double t, int line, Out_stream* out){
+    size_t i;
+    if( st->hook!= NULL|| st->p_nsim_avg_lst!= NULL) return;
+    if( run->out_grid== GRID_TIME){
+        //first grid point at or after t, points before it are written already
+        i= (size_t)ceil( t/ run->grid_step);
+        while( i> 0&& (double)(i- 1)* run->grid_step>= t) i--;
+        while( (double)i* run->grid_step< t) i++;
+        st->grid_i= i;
+    }
+    else if( run->out_grid== GRID_EVENTS&& line){
+        grid_line( sts, st->init_cnt, t, out);
+    }
+}
+//grid points before time t
+static void grid_upto( Run* run, Status* sts, Sim_state* st, double t, Out_stream* out){
+    for( ; (double)st->grid_i* run->grid_step< t; st->grid_i++){
+        grid_line( sts, st->init_cnt, (double)st->grid_i* run->grid_step, out);
+    }
+}
+void grid_end( Run* run, Status* sts, Sim_state* st, Out_stream* out){
+    if( st->hook!= NULL|| st->p_nsim_avg_lst!= NULL|| run->out_grid!= GRID_TIME) return;
+    grid_upto( run, sts, st, run->max_time, out);
+    if( (double)st->grid_i* run->grid_step== run->max_time){
+        grid_line( sts, st->init_cnt, run->max_time, out);
+        st->grid_i++;
+    }
+}
+
+//pull rounds from the shared counter until all rounds are done
+void* ensemble_worker( void* arg){
+    Ensemble_arg* ea= (Ensemble_arg*)arg;
+    size_t round;
+    NINT* traj= (NINT*)malloc1( ea->es->M* ea->es->I, sizeof(NINT));
+    while( 1){
+        pthread_mutex_lock( ea->lock);
+        round= (*ea->next_round)++;
+        rng_split( ea->next_rng, &ea->st->rng);
+        pthread_mutex_unlock( ea->lock);
+        if( round> ea->run->sim_rounds) break;
+        //restore original status and run again
+        sim_state_copy( ea->st, ea->master, ea->graph, ea->sts);
+        if( sim_round( ea->graph, ea->tran, ea->sts, ea->run, ea->st, round, NULL, ea->hb)< 0){
+            ea->ret= -1;
             break;
         }
+        //population at the end of each interval, into the statistics
+        ens_stats_round( ea->es, round, ea->master->init_cnt+ ea->sts->_s, ea->st->p_nsim_avg_lst, traj);
     }
-    free(tmp_rat_sum - 1);
-    return ret;
+    free( traj);
+    return NULL;
 }
 
-int get_next_evt(double* p_raw_rat_lst, double** p_inducer_cal_lst, Graph* graph, Transition* tran, Status* sts, Event* evt, Heap* heap){
-    double* nodal_tmp_rat_lst, *edgeb_tmp_rat_lst;
-    double nodal_rat_ttl, edgeb_rat_ttl;
-    size_t layer, i, j;
-    //pick out one node randomly by weight
-    //evt->ns= weighed_rat_rand( p_raw_rat_lst+ graph->_s, graph->V)+ graph->_s;
-    evt->ni= sts->init_lst[evt->ns];
-    nodal_tmp_rat_lst= (double*)malloc(sizeof(double)*(sts->M+ sts->_s+ 1))+ 1;
-    if( nodal_tmp_rat_lst== NULL){
-        printf("Memory allocation failure for temp nodal rate sumation list, size[%zu]\n",
-                                        sizeof(double)*(sts->M+ sts->_s+ 1));
-        exit( - 1);
-    }
-    edgeb_tmp_rat_lst= (double*)malloc(sizeof(double)*(graph->L*(sts->M+sts->_s+ 1)))+ 1;
-    if( edgeb_tmp_rat_lst== NULL){
-        printf("Memory allocation failure for temp edge based rate sumation list, size[%zu]\n",
-                                        sizeof(double)*(sts->M*graph->L+ sts->_s+ 1));
-        exit( - 1);
-    }
-    nodal_tmp_rat_lst[sts->_s - 1]= 0.0;
-    edgeb_tmp_rat_lst[sts->_s - 1]= 0.0;
-    nodal_rat_ttl= 0.0;
-    edgeb_rat_ttl= 0.0;
-    for( j= sts->_s; j< sts->M+ sts->_s; j++){
-        nodal_tmp_rat_lst[j]= tran->nodal_trn[evt->ni][j];
-        nodal_rat_ttl+= nodal_tmp_rat_lst[j];
+//pull branches until all are done, each goes on from the snapshot to [OUT_FILE].<branch>
+void* branch_worker( void* arg){
+    Ensemble_arg* ea= (Ensemble_arg*)arg;
+    Out_stream* out;
+    Hub_index* hubs= ea->run->hubs;
+    char* fil_nam;
+    size_t b;
+    int ret;
+    fil_nam= (char*)malloc1( strlen( ea->run->out_file)+ 24, sizeof(char));
+    while( 1){
+        pthread_mutex_lock( ea->lock);
+        b= (*ea->next_round)++;
+        rng_split( ea->next_rng, &ea->st->rng);
+        pthread_mutex_unlock( ea->lock);
+        if( b> ea->run->sim_rounds) break;
+        //the snapshot, hub arcs as last counted, infector stream of its own
+        sim_state_copy( ea->st, ea->master, ea->graph, ea->sts);
+        if( hubs!= NULL){
+            memcpy( ea->st->hub_seen, ea->master->hub_seen, sizeof(size_t)* hubs->off[ea->graph->_e]);
+            memcpy( ea->st->hub_head, ea->master->hub_head, sizeof(double)* ea->graph->_e);
+            memcpy( ea->st->hub_rat, ea->master->hub_rat, sizeof(double)* ea->graph->L* ea->graph->_e);
+        }
+        rng_infector( &ea->st->rng, &ea->st->inf_rng);
+        ea->st->elapse_tim= ea->master->elapse_tim;
+        ea->st->resumed= SIM_BRANCHED;
+        sprintf( fil_nam, "%s.%zu", ea->run->out_file, b);
+        out= out_open( fil_nam, ea->run->out_codec, ea->run->out_level);
+        if( out== NULL){
+            printf("open output file[%s] faild\n", fil_nam);
+            ea->ret= -1;
+            break;
+        }
+        if( ea->run->out_format!= OUT_TEXT){
+            evt_log_begin( ea->graph, ea->sts, ea->run, ea->st->init_cnt, out);
+        }
+        ret= sim_round( ea->graph, ea->tran, ea->sts, ea->run, ea->st, b, out, ea->hb);
+        if( out_close( out)< 0){
+            printf("write output file[%s] faild\n", fil_nam);
+            ret= -1;
+        }
+        if( ret< 0){
+            ea->ret= -1;
+            break;
+        }
+    }
+    free( fil_nam);
+    return NULL;
+}
+
+//binary event log header and the population events start from
+void evt_log_begin( Graph* graph, Status* sts, Run* run, NINT* init_cnt, Out_stream* out){
+    Evt_log_header hdr;
+    uint32_t cnt;
+    size_t compartment;
+    memset( &hdr, 0, sizeof(hdr));
+    memcpy( hdr.magic, EVT_LOG_MAGIC, sizeof(EVT_LOG_MAGIC));
+    hdr.version= EVT_LOG_VERSION;
+    hdr.flags= (run->out_format== OUT_BINARY_COUNTS? EVT_LOG_COUNTS: 0)| (run->show_inducer? EVT_LOG_INDUCER: 0)| (run->show_infector? EVT_LOG_INFECTOR: 0);
+    hdr.M= (uint32_t)sts->M;
+    hdr._s= (uint32_t)sts->_s;
+    hdr.L= (uint32_t)graph->L;
+    out_write( out, &hdr, sizeof(hdr));
+    for( compartment= sts->_s; compartment< sts->M+ sts->_s; compartment++){
+        cnt= init_cnt[compartment];
+        out_write( out, &cnt, sizeof(cnt));
+    }
+}
+
+//allocate a worker state, including its own heap and histogram
+void sim_state_init( Sim_state* st, Graph* graph, Status* sts, Run* run){
+    memset( st, 0, sizeof(Sim_state));
+    st->init_lst= (size_t*)malloc1( graph->_e, sizeof(size_t));
+    st->init_cnt= (NINT*)malloc1( sts->_s+ sts->M, sizeof(NINT));
+    st->p_raw_rat_lst= (double*)malloc1( graph->_e, sizeof(double));
+    st->p_inducer_cal_lst= malloc2Dbl( graph->L, (size_t)graph->_e);
+    if( run->sim_rounds> 1){
+        st->p_nsim_avg_lst= malloc2Int( sts->M, run->interval_num+ 1);
+    }
+    if( run->tau_leap== TAU_OFF){
+        heap_init( &st->heap, graph, run->scheduler, run->heap_arity);
+    }
+    if( run->hubs!= NULL){
+        st->hub_seen= (size_t*)malloc1( run->hubs->off[graph->_e], sizeof(size_t));
+        st->hub_head= (double*)malloc1( graph->_e, sizeof(double));
+        st->hub_rat= (double*)malloc1( graph->L* graph->_e, sizeof(double));
     }
+}
+//copy status and rates of src to dst, heap and histogram are untouched
+void sim_state_copy( Sim_state* dst, Sim_state* src, Graph* graph, Status* sts){
+    size_t layer;
+    dst->R= src->R;
+    memcpy( dst->init_lst, src->init_lst, sizeof(size_t)*(graph->_e));
+    memcpy( dst->init_cnt, src->init_cnt, sizeof(NINT)*(sts->_s+ sts->M));
+    memcpy( dst->p_raw_rat_lst, src->p_raw_rat_lst, sizeof(double)*(graph->_e));
     for( layer= 0; layer< graph->L; layer++){
-        for( j= sts->_s; j< sts->M+ sts->_s; j++){
-            edgeb_tmp_rat_lst[layer* (sts->M)+ j]= tran->edge_trn[layer][evt->ni][j]*p_inducer_cal_lst[layer][evt->ns];
-            edgeb_rat_ttl+= edgeb_tmp_rat_lst[layer* (sts->M)+ j];
+        memcpy( dst->p_inducer_cal_lst[layer], src->p_inducer_cal_lst[layer],  sizeof(double)*(graph->_e));
+    }
+}
+void sim_state_free( Sim_state* st, Graph* graph, Status* sts){
+    size_t layer, j;
+    for( layer= 0; layer< graph->L; layer++){
+        free( st->p_inducer_cal_lst[layer]);
+    }
+    free( st->p_inducer_cal_lst);
+    if( st->p_nsim_avg_lst!= NULL){
+        for( j= 0; j< sts->M; j++){
+            free( st->p_nsim_avg_lst[j]);
         }
+        free( st->p_nsim_avg_lst);
     }
-    if(rand()/(double)(RAND_MAX)< nodal_rat_ttl/(nodal_rat_ttl+ edgeb_rat_ttl)){
-        //nodal
-        i= weighed_rat_rand(nodal_tmp_rat_lst+ sts->_s, sts->M);
+    free( st->init_lst);
+    free( st->init_cnt);
+    free( st->p_raw_rat_lst);
+    free( st->hub_seen);
+    free( st->hub_head);
+    free( st->hub_rat);
+    heap_free( &st->heap);
+}
+
+/*
+ *called after the status of evt->ns changed and before the inducer weights are updated,
+ *the transition rate is split into the nodal rate and the rate of each inducer neighbour
+ */
+NINT sample_infector( Graph* graph, Transition* tran, Sim_state* st, Event* evt, Rng* rng){
+    double key, w, rat;
+    size_t layer, li;
+    NINT j, ret= NO_INFECTOR;
+    key= tran->nodal_trn[evt->ni][evt->nj];
+    for( layer= 0; layer< graph->L; layer++){
+        key+= tran->edge_trn[layer][evt->ni][evt->nj]* st->p_inducer_cal_lst[layer][evt->ns];
     }
-    else{
-        //edgebased
-        i= weighed_rat_rand(edgeb_tmp_rat_lst+ sts->_s, sts->M*graph->L);
+    key*= rng_uniform( rng);
+    if( key< tran->nodal_trn[evt->ni][evt->nj]) return NO_INFECTOR;
+    key-= tran->nodal_trn[evt->ni][evt->nj];
+    for( layer= 0; layer< graph->L; layer++){
+        rat= tran->edge_trn[layer][evt->ni][evt->nj];
+        w= rat* st->p_inducer_cal_lst[layer][evt->ns];
+        if( w<= 0) continue;
+        //the layer is the last one with a share if rounding runs past all of them
+        key/= rat;
+        for( li= graph->r_offsets[layer][evt->ns]; li< graph->r_offsets[layer][evt->ns+ 1]; li++){
+            j= graph->r_sources[layer][li];
+            if( st->init_lst[j]!= tran->inducer_lst[layer]) continue;
+            ret= j;
+            w= graph->weighted? graph->r_weights[layer][li]: 1.0;
+            if( key< w) return ret;
+            key-= w;
+        }
+        key*= rat;
+    }
+    return ret;
+}
+int get_next_evt(Sim_state* st, Graph* graph, Transition* tran, Status* sts, Event* evt){
+    double *row, *seg;
+    double key, w, scale;
+    size_t layer, j, M= sts->M;
+    //pick out one transition of node ns by weight, no memory allocation
+    evt->ni= st->init_lst[evt->ns];
+    row= tran->trn_table[evt->ni];
+    //total rate of the node
+    key= row[M- 1];
+    for( layer= 0; layer< graph->L; layer++){
+        key+= row[(layer+ 2)*M- 1]* st->p_inducer_cal_lst[layer][evt->ns];
     }
-    evt->nj= i%sts->M+ sts->_s;
-    free( nodal_tmp_rat_lst - 1);
-    free( edgeb_tmp_rat_lst - 1);
+    key*= rng_uniform(&st->rng);
+    //nodal part first, then each layer scaled by its inducer count
+    seg= row;
+    scale= 1.0;
+    if( key>= row[M- 1]){
+        key-= row[M- 1];
+        for( layer= 0; layer< graph->L; layer++){
+            w= row[(layer+ 2)*M- 1]* st->p_inducer_cal_lst[layer][evt->ns];
+            if( w<= 0) continue;
+            seg= row+ (layer+ 1)*M;
+            scale= st->p_inducer_cal_lst[layer][evt->ns];
+            if( key< w) break;
+            key-= w;
+        }
+        key/= scale;
+    }
+    //first compartment whose cumulative rate exceeds key
+    for( j= 0; j< M- 1&& key>= seg[j]; j++);
+    //rounding may run past the last non zero rate
+    while( j> 0&& seg[j]<= seg[j- 1]) j--;
+    evt->nj= j+ sts->_s;
     return 0;
 }
+/*
+ *build per source compartment cumulative rate table, once at load time
+ *
+ *row i has (L+1) segments of M cumulative rates, nodal first then each layer,
+ *the last item of each segment is the total rate of the segment
+ */
+void init_trn_table(Transition* tran){
+    size_t i, j, layer;
+    double **mtx;
+    double *seg;
+    tran->trn_table= (double**)malloc1( tran->_s+ tran->M, sizeof(double*));
+    for( i= tran->_s; i< tran->_s+ tran->M; i++){
+        tran->trn_table[i]= (double*)malloc1( tran->M*(tran->L+ 1), sizeof(double));
+        for( layer= 0; layer<= tran->L; layer++){
+            mtx= layer? tran->edge_trn[layer- 1]: tran->nodal_trn;
+            seg= tran->trn_table[i]+ layer* tran->M;
+            for( j= 0; j< tran->M; j++){
+                seg[j]= (j? seg[j- 1]: 0.0)+ mtx[i][j+ tran->_s];
+            }
+        }
+    }
+}
 void* malloc1( size_t l, size_t s){
     void* ret = malloc(s*l);
     if( ret== NULL){
         printf("Memory allocation failure, size[%zu]\n", s*l);
-        exit( - 1);
+        error_exit( -1);
     }
     memset(ret, 0, s*l);
     return ret;
@@ -470,77 +1010,25 @@ double** init_inducer(Graph* graph, Status* sts, Transition* tran){
     double** mtx=  malloc2Dbl( graph->L, (size_t)graph->_e);
     size_t l;
     size_t li;
-    if( graph->weighted== 1){
-        Edge_w * p_ew;
-        for( l=0; l< graph->L; l++){
-            p_ew= graph->edge_w[l];
-            for( li= 0; li< graph->E[l]; li++){
-                if( sts->init_lst[p_ew->i] == tran->inducer_lst[l]){
-                    mtx[l][p_ew->j]+= p_ew->w;
+    NINT i;
+    for( l=0; l< graph->L; l++){
+        for( i= graph->_s; i< graph->_e; i++){
+            if( sts->init_lst[i] != tran->inducer_lst[l]) continue;
+            if( graph->weighted){
+                for( li= graph->offsets[l][i]; li< graph->offsets[l][i+ 1]; li++){
+                    mtx[l][graph->targets[l][li]]+= graph->weights[l][li];
                 }
-                p_ew++;
             }
-        }
-    }
-    else{
-        Edge * p_e;
-        for( l=0; l< graph->L; l++){
-            p_e= graph->edge[l];
-            for( li= 0; li< graph->E[l]; li++){
-                if( sts->init_lst[p_e->i] == tran->inducer_lst[l]){
-                    mtx[l][p_e->j]++;
+            else{
+                for( li= graph->offsets[l][i]; li< graph->offsets[l][i+ 1]; li++){
+                    mtx[l][graph->targets[l][li]]++;
                 }
-                p_e++;
             }
         }
     }
     LOG(1, __FILE__, __LINE__, " initial inducer success\n");
     return mtx;
 }
-NINT** init_index(Graph* graph){
-    LOG(1, __FILE__, __LINE__, " initial index\n");
-    graph->index= malloc2NINT( graph->L, (size_t)graph->_e+1);
-    NINT cur_nod, next_nod, count;
-    int init_flag;
-    size_t layer, li;
-    for( layer= 0; layer< graph->L; layer++){
-        //cur_nod= -1;
-        init_flag= 1;
-        for( li= 0; li< graph->E[layer]; li++){
-            //next_nod= next_node
-            if( graph->weighted){
-                next_nod= graph->edge_w[layer][li].i;
-            }
-            else{
-                next_nod= graph->edge[layer][li].i;
-            }
-            //if( cur_nod== -1){
-            if( init_flag){
-                init_flag= 0;
-                cur_nod= next_nod;
-                count= 1;
-            }
-            else if( cur_nod== next_nod){
-                count++;
-            }
-            else if( cur_nod> next_nod){
-                printf("cur_nod "fmt_n" next_nod "fmt_n"\n", cur_nod, next_nod);
-                printf("fatal error:[data matrix sort failed]\n");
-                exit( -1);
-            }
-            else{
-                while(cur_nod< next_nod){
-                    graph->index[layer][cur_nod+1]= count;
-                    cur_nod++;
-                }
-                count++;
-            }
-        }
-        graph->index[layer][cur_nod+1]= count;
-    }
-    LOG(1, __FILE__, __LINE__, " initial index success\n");
-    return graph->index;
-}
 double get_rat_lst(Graph* graph, Transition* tran, Status* sts, double** p_raw_rat_lst, double** p_inducer_cal_lst){
     LOG(1, __FILE__, __LINE__, "calculate initial Ri\n");
     double ret= 0.0, tmp_double;
@@ -563,12 +1051,6 @@ double get_rat_lst(Graph* graph, Transition* tran, Status* sts, double** p_raw_r
     LOG(1, __FILE__, __LINE__, "calculate initial Ri success\n");
     return ret;
 }
-int Edge_cmp( const void *a, const void *b){
-    LONG ret= (LONG)((Edge*)a)->i - (LONG)((Edge*)b)->i;
-    if( ret== 0){ return 0; }
-    else if( ret > 0){ return 1; }
-    else return -1;
-}
 void heart_beat( Heart_beat *hb){
     if( -- hb->count_down <= 0){
         if( hb->count_down< 0){
@@ -599,6 +1081,9 @@ void heart_beat( Heart_beat *hb){
             time_print("elapse time[", hb->timer2, "]");
             kilobit_print(", [", (LONG)*(hb->count), "]events generated\n");
             hb->last_report= *(hb->count);
+            if( hb->perf!= NULL){
+                perf_report( hb->perf, hb->cnt, *(hb->count), 0);
+            }
         }
     }
 }
@@ -608,13 +1093,13 @@ double ** malloc2Dbl( size_t m, size_t n){
     size_t l;
     if( ret== NULL){
         printf("2-D Memory allocation failure, size[%zu]\n", sizeof(double*)*m);
-        exit( - 1);
+        error_exit( -1);
     }
     for( l= 0; l< m; l++){
         ret[l]= (double*)malloc(sizeof(double)*(n));
         if( ret[l]== NULL){
             printf("2-D Memory allocation failure for layer[%zu/%zu], size[%zu]\n", l+ 1, m, sizeof(double)*(n));
-            exit( - 1);
+            error_exit( -1);
         }
         memset(ret[l], 0, sizeof(double)*(n));
     }
@@ -625,13 +1110,13 @@ NINT ** malloc2NINT( size_t m, size_t n){
     size_t l;
     if( ret== NULL){
         printf("2-D Memory allocation failure, size[%zu]\n", sizeof(NINT*)*m);
-        exit( - 1);
+        error_exit( -1);
     }
     for( l= 0; l< m; l++){
         ret[l]= (NINT*)malloc(sizeof(NINT)*(n));
         if( ret[l]== NULL){
             printf("2-D Memory allocation failure for layer[%zu/%zu], size[%zu]\n", l+ 1, m, sizeof(NINT)*(n));
-            exit( - 1);
+            error_exit( -1);
         }
         memset(ret[l], 0, sizeof(NINT)*(n));
     }
@@ -642,145 +1127,60 @@ int ** malloc2Int( size_t m, size_t n){
     size_t l;
     if( ret== NULL){
         printf("2-D Memory allocation failure, size[%zu]\n", sizeof(int*)*m);
-        exit( - 1);
+        error_exit( -1);
     }
     for( l= 0; l< m; l++){
         ret[l]= (int*)malloc(sizeof(int)*(n));
         if( ret[l]== NULL){
             printf("2-D Memory allocation failure for layer[%zu/%zu], size[%zu]\n", l+ 1, m, sizeof(int)*(n));
-            exit( - 1);
+            error_exit( -1);
         }
         memset(ret[l], 0, sizeof(int)*(n));
     }
     return ret;
 }
-int Reaction_cmp(const void* a, const void* b){
-    double d = ((Reaction*)a)->t - ((Reaction*)b)->t;
-    if( d > 0) return 1;
-    if( d < 0) return -1;
-    return 0;
-}
-void heap_init(Heap* heap, Graph* graph){
-    heap->_s= graph->_s;
-    heap->_e= graph->_e;
-    heap->reaction= (Reaction*)malloc(sizeof(Reaction)*heap->_e);
-    if( heap->reaction== NULL){
-        printf("malloc reaction list failed.\n");
-        exit(-1);
-    }
-    heap->idx= (NINT*)malloc1((size_t)heap->_e, sizeof(NINT));
-}
-void heap_sort(Heap* heap){
-    qsort( heap->reaction+ heap->_s, heap->V, sizeof( Reaction), Reaction_cmp);
-    NINT i;
-    for( i= heap->_s; i< heap->_e; i++){
-        heap->idx[heap->reaction[i].n]= i;
-    }
-}
-void heap_swap(Heap* heap, NINT a, NINT b){
-    Reaction tr;
-    tr.n= heap->reaction[a].n;
-    tr.t= heap->reaction[a].t;
-    heap->reaction[a].n= heap->reaction[b].n;
-    heap->reaction[a].t= heap->reaction[b].t;
-    heap->reaction[b].n= tr.n;
-    heap->reaction[b].t= tr.t;
-    heap->idx[heap->reaction[a].n]= a;
-    heap->idx[heap->reaction[b].n]= b;
+double cal_new_tau(double r_old, double r_new, double t_old, double t, Rng* rng){
+    if( r_new< FLT_EPSILON) return DBL_MAX;
+    if( r_old< FLT_EPSILON) return (rng_exp(rng)/(r_new)+ t);
+    return (r_old/r_new)*(t_old- t)+ t;
 }
-void heap_update_aux( Heap* heap, NINT n){
-    NINT parent= (n+heap->_s-1)/2;
-    NINT lchild= 2*n+ 1-heap->_s;
-    NINT rchild= 2*n+ 2-heap->_s;
-    if( n> heap->_s&& heap->reaction[parent].t > heap->reaction[n].t){
-        heap_swap(heap, n, parent);
-        heap_update_aux(heap, parent);
+//inducers of an event, in-neighbours in the inducer state in st, as text "[n],[..],[..]" or as binary lists, see output.h
+void print_inducer( Graph* graph, Transition* tran, Sim_state* st, Event* evt, Out_stream* out, int binary){
+    uint32_t n;
+    size_t i;
+    if( binary){
+        n= tran->nodal_trn[evt->ni][evt->nj]> 0;
+        out_write( out, &n, sizeof(n));
+        if( n) out_write( out, &evt->ns, sizeof(NINT));
     }
-    else if( lchild< (heap->_s+ heap->V)){
-        if( rchild< (heap->_s+ heap->V)&& heap->reaction[rchild].t< heap->reaction[lchild].t && heap->reaction[rchild].t< heap->reaction[n].t){
-            heap_swap(heap, rchild, n);
-            heap_update_aux(heap, rchild);
-        }
-        else if( heap->reaction[lchild].t< heap->reaction[n].t){
-            heap_swap(heap, lchild, n);
-            heap_update_aux(heap, lchild);
+    else{
+        out_write( out, " [", 2);
+        if( tran->nodal_trn[evt->ni][evt->nj]> 0){
+            out_printf( out, "%d", evt->ns);
         }
     }
-}
-void heap_update( Heap* heap, Reaction *reaction){
-    NINT n= heap->idx[reaction->n];
-    heap->reaction[n].t= reaction->t;;
-    heap_update_aux(heap, n);
-}
-/*void heap_update( Heap* heap, Reaction *reaction){
-    int n= heap->idx[reaction->n];
-    //swap until ok
-    int parent= (n+ heap->_s- 1)/2;
-    while( n> heap->_s&& heap->reaction[parent].t > reaction->t){
-        heap->reaction[n].n= heap->reaction[parent].n;
-        heap->reaction[n].t = heap->reaction[parent].t;
-        heap->idx[heap->reaction[n].n]= n;
-        n= parent;
-        parent= (n+ heap->_s- 1)/2;
-    }
-    heap->reaction[n].n= reaction->n;
-    heap->reaction[n].t = reaction->t;
-    heap->idx[reaction->n]= n;
-}
-*/
-double cal_new_tau(double r_old, double r_new, double t_old, double t){
-    if( r_new< FLT_EPSILON) return DBL_MAX;
-    if( r_old< FLT_EPSILON) return (- log(rand()/(double)(RAND_MAX))/(r_new)+ t);
-    return (r_old/r_new)*(t_old- t)+ t;
-}
-double get_tau( Heap* heap, NINT n){
-    return heap->reaction[heap->idx[n]].t;
-}
-void dump_heap( Heap* heap){
-    printf("begin dump heap\n");
-    for( int i= 0; i< heap->_e; i++){
-        if( heap->idx[i]> 10000){ exit(-1);}
-        printf("[%d][%d][%.5g] index[" fmt_n "]\n", i, heap->reaction[i].n, heap->reaction[i].t, heap->idx[i]);
-    }
-    printf("end dump heap\n");
-    fflush(stdout);
-}
-void print_inducer( Graph* graph, Transition* tran, Status* sts, Event* evt, FILE* fil_out){
-    fprintf( fil_out, " [");
-    if( tran->nodal_trn[evt->ni][evt->nj]> 0){
-        fprintf( fil_out, "%d", evt->ns);
-    }
-    for( int layer= 0; layer< graph->L; layer++){
-        fprintf( fil_out, "],[");
-        if( tran->edge_trn[layer][evt->ni][evt->nj]> 0){
-            int flag= 0;
-            if( graph->weighted){
-                for( int i= graph->index[layer][evt->ns]; i< graph->index[layer][evt->ns+1]; i++){
-                    if( sts->init_lst[graph->edge_w[layer][i].j] == tran->inducer_lst[layer]){
-                        if( flag){
-                            fprintf( fil_out, ",");
-                        }
-                        else{
-                            flag= 1;
-                        }
-                        fprintf( fil_out, "%d", graph->edge_w[layer][i].j);
-                    }
-                }
+    for( size_t layer= 0; layer< graph->L; layer++){
+        if( !binary) out_write( out, "],[", 3);
+        if( tran->edge_trn[layer][evt->ni][evt->nj]<= 0){
+            n= 0;
+            if( binary) out_write( out, &n, sizeof(n));
+            continue;
+        }
+        if( binary){
+            //count first, then the nodes
+            n= 0;
+            for( i= graph->r_offsets[layer][evt->ns]; i< graph->r_offsets[layer][evt->ns+1]; i++){
+                n+= st->init_lst[graph->r_sources[layer][i]] == tran->inducer_lst[layer];
             }
-            else{
-                for( int i= graph->index[layer][evt->ns]; i< graph->index[layer][evt->ns+1]; i++){
-                    if( sts->init_lst[graph->edge[layer][i].j] == tran->inducer_lst[layer]){
-                        if( flag){
-                            fprintf( fil_out, ",");
-                        }
-                        else{
-                            flag= 1;
-                        }
-                        fprintf( fil_out, "%d", graph->edge[layer][i].j);
-                    }
-                }
+            out_write( out, &n, sizeof(n));
+        }
+        n= 0;
+        for( i= graph->r_offsets[layer][evt->ns]; i< graph->r_offsets[layer][evt->ns+1]; i++){
+            if( st->init_lst[graph->r_sources[layer][i]] == tran->inducer_lst[layer]){
+                if( binary) out_write( out, &graph->r_sources[layer][i], sizeof(NINT));
+                else out_printf( out, n++? ",%d": "%d", graph->r_sources[layer][i]);
             }
         }
     }
-    fprintf( fil_out, "]");
+    if( !binary) out_write( out, "]", 1);
 }
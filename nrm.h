@@ -3,6 +3,10 @@
 
 
 #include "common.h"
+#include "rng.h"
+#include "heap.h"
+#include "output.h"
+#include "perf.h"
 /*
  * nrm.h of GEMF in C language
  * Futing Fan
@@ -19,22 +23,123 @@ typedef struct{
     size_t* count, last_report;
     int count_down, frequency;
     double timer0, timer2, last_report_time;
+    //run report written on each beat, NULL if none, and counters of the reported worker
+    Perf* perf;
+    Perf_counters* cnt;
 }Heart_beat;
 
-//compare two Edge or Edge struct
-//return 0 if equal
-//return 1 if a is greater
-//return -1 otherwise
-int Edge_cmp( const void *a, const void *b);
+//per-worker simulation state, everything a round writes to
+typedef struct Sim_state Sim_state;
+struct Sim_state{
+    //status of each node, 1 by _e
+    size_t* init_lst;
+    //population of each compartment, 1 by (_s+M)
+    NINT* init_cnt;
+    //rate of each node, 1 by _e
+    double* p_raw_rat_lst;
+    //weighted number of inducer neighbours, L by _e
+    double** p_inducer_cal_lst;
+    Heap heap;
+    //total rate
+    double R;
+    //events number of current round, and of all rounds run by this worker
+    size_t count, total;
+    //time of the last event
+    double elapse_tim;
+    //random number stream of current round
+    Rng rng;
+    //random number stream of infector sampling, apart from rng so events do not depend on it
+    Rng inf_rng;
+    //M by (interval_num+ 1) status change histogram of the round, NULL for single round
+    int** p_nsim_avg_lst;
+    //called on each event instead of writing output, nonzero return stops the round
+    int (*hook)( Sim_state* st, double t, Event* evt, void* arg);
+    void* hook_arg;
+    //performance counters of all rounds run by this worker
+    Perf_counters perf;
+    //with a hub index, compartment of the hub of each hub arc when last counted, the
+    //headroom of each node, and the rate each hub induces over each layer, L by _e, see hub.h
+    size_t* hub_seen;
+    double* hub_head;
+    double* hub_rat;
+    //next point of a GRID_TIME output
+    size_t grid_i;
+    //how the last round ended, END_*, and when the current one started
+    int end;
+    double t0;
+    //SIM_RESUMED or SIM_BRANCHED, the next sim_round goes on from the content of st
+    int resumed;
+};
+//restored from a checkpoint, scheduler included
+#define SIM_RESUMED 1
+//a continuation of [BRANCH] from time elapse_tim, firing times drawn anew from the rates
+#define SIM_BRANCHED 2
+
+//change of the inducer count of layer by an event, -1, 0 or 1
+static inline int inducer_change( Transition* tran, Event* evt, size_t layer){
+    return (evt->nj== tran->inducer_lst[layer])- (evt->ni== tran->inducer_lst[layer]);
+}
+
+//[STOP_WHEN] condition met after evt, END_COND plus its kind, or 0; with no evt, as after any event
+static inline int stop_check( Run* run, Sim_state* st, Event* evt){
+    Stop_cond* sc;
+    size_t k;
+    for( k= 0; k< run->stop_num; k++){
+        sc= &run->stop[k];
+        switch( sc->kind){
+        case STOP_ZERO:
+            if( (evt== NULL|| evt->ni== sc->c)&& st->init_cnt[sc->c]== 0) return END_COND+ STOP_ZERO;
+            break;
+        case STOP_ABOVE:
+            if( (evt== NULL|| evt->nj== sc->c)&& st->init_cnt[sc->c]> sc->v) return END_COND+ STOP_ABOVE;
+            break;
+        case STOP_RATE:
+            if( st->R< sc->v) return END_COND+ STOP_RATE;
+            break;
+        case STOP_WALL:
+            if( (evt== NULL|| !(st->count& STOP_WALL_MASK))&& gettimenow()- st->t0>= sc->v) return END_COND+ STOP_WALL;
+            break;
+        }
+    }
+    return 0;
+}
+
+//build CSR adjacency from edge lists, once per graph
+void prepare_graph(Graph* graph);
+//build reverse adjacency of all layers, for inducers and infectors
+void prepare_reverse_graph(Graph* graph);
 
 //Next reaction method
 int nrm(Graph* graph, Transition* tran, Status* sts, Run* run);
 
-//weighted random draw from a double array
-size_t weighed_rat_rand( double* rat_lst, size_t len);
+//worker state of a round, histogram only for multiple rounds
+void sim_state_init( Sim_state* st, Graph* graph, Status* sts, Run* run);
+//copy status and rates of src to dst
+void sim_state_copy( Sim_state* dst, Sim_state* src, Graph* graph, Status* sts);
+void sim_state_free( Sim_state* st, Graph* graph, Status* sts);
+//simulate one round from the current content of st, output to out or st->hook
+int sim_round( Graph* graph, Transition* tran, Status* sts, Run* run, Sim_state* st, size_t round, Out_stream* out, Heart_beat* hb);
+//write an event to out, st->hook or the histogram, 1 if the hook stops the round, -1 on error
+int sim_event_out( Graph* graph, Transition* tran, Status* sts, Run* run, Sim_state* st, double t, Event* evt, Out_stream* out);
+//start [OUT_GRID] output of a round at time t, line for the population at t of an event grid
+void grid_begin( Run* run, Status* sts, Sim_state* st, double t, int line, Out_stream* out);
+//grid points up to [MAX_TIME], for a round that ends by time or has no more events
+void grid_end( Run* run, Status* sts, Sim_state* st, Out_stream* out);
+//initial inducer weights and rates of all nodes
+double** init_inducer(Graph* graph, Status* sts, Transition* tran);
+double get_rat_lst(Graph* graph, Transition* tran, Status* sts, double** p_raw_rat_lst, double** p_inducer_cal_lst);
+
+//infector of a nodal transition
+#define NO_INFECTOR ((NINT)-1)
+//sample the in-neighbour that caused the event of evt->ns by its share of the rate, NO_INFECTOR for nodal transitions,
+//needs the reverse adjacency
+NINT sample_infector( Graph* graph, Transition* tran, Sim_state* st, Event* evt, Rng* rng);
+
+//build per source compartment cumulative rate table
+void init_trn_table(Transition* tran);
 
 //get next event according to rate list
-int get_next_evt(double* p_raw_rat_lst, double** p_inducer_cal_lst, Graph* graph, Transition* tran, Status* sts, Event *evt, Heap* heap);
+int get_next_evt(Sim_state* st, Graph* graph, Transition* tran, Status* sts, Event *evt);
 
 #endif
 
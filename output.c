@@ -0,0 +1,428 @@
+#include "output.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <errno.h>
+#ifdef GEMF_ZLIB
+#include <zlib.h>
+#endif
+#ifdef GEMF_ZSTD
+#include <zstd.h>
+#endif
+/*
+ * output.c of GEMF in C language
+ * buffered output stream and binary event log, see output.h
+ */
+
+//write all n bytes
+static int write_all( int fd, const char* p, size_t n){
+    ssize_t ret;
+    while( n> 0){
+        ret= write( fd, p, n);
+        if( ret< 0){
+            if( errno== EINTR) continue;
+            return -1;
+        }
+        p+= ret;
+        n-= (size_t)ret;
+    }
+    return 0;
+}
+//size of compressed output chunks
+#define OUT_ZBUF_SIZE (1<< 20)
+
+int out_codec( const char* name){
+    if( !strcmp( name, "none")) return OUT_CODEC_NONE;
+#ifdef GEMF_ZLIB
+    if( !strcmp( name, "gzip")) return OUT_CODEC_GZIP;
+#endif
+#ifdef GEMF_ZSTD
+    if( !strcmp( name, "zstd")) return OUT_CODEC_ZSTD;
+#endif
+    return -1;
+}
+int out_codec_of_file( const char* fil_nam){
+    size_t n= strlen( fil_nam);
+    if( n> 3&& !strcmp( fil_nam+ n- 3, ".gz")) return OUT_CODEC_GZIP;
+    if( n> 4&& !strcmp( fil_nam+ n- 4, ".zst")) return OUT_CODEC_ZSTD;
+    return OUT_CODEC_NONE;
+}
+//set up compressor state, <0 if codec is not built in
+static int out_codec_init( Out_stream* out){
+    if( out->codec== OUT_CODEC_NONE) return 0;
+    out->zbuf= (char*)malloc( OUT_ZBUF_SIZE);
+    if( out->zbuf== NULL){
+        printf("Memory allocation failure for compression buffer, size[%d]\n", OUT_ZBUF_SIZE);
+        error_exit( -1);
+    }
+#ifdef GEMF_ZLIB
+    if( out->codec== OUT_CODEC_GZIP){
+        z_stream* z= (z_stream*)calloc( 1, sizeof(z_stream));
+        //window bits 15+ 16 for a gzip header, level 1 by default to keep up with the simulation
+        if( z== NULL|| deflateInit2( z, out->level> 0? out->level: 1, Z_DEFLATED, 15+ 16, 8, Z_DEFAULT_STRATEGY)!= Z_OK){
+            free( z);
+            return -1;
+        }
+        out->zs= z;
+        return 0;
+    }
+#endif
+#ifdef GEMF_ZSTD
+    if( out->codec== OUT_CODEC_ZSTD){
+        ZSTD_CCtx* z= ZSTD_createCCtx();
+        if( z== NULL) return -1;
+        ZSTD_CCtx_setParameter( z, ZSTD_c_compressionLevel, out->level> 0? out->level: ZSTD_CLEVEL_DEFAULT);
+        out->zs= z;
+        return 0;
+    }
+#endif
+    return -1;
+}
+static void out_codec_free( Out_stream* out){
+#ifdef GEMF_ZLIB
+    if( out->codec== OUT_CODEC_GZIP&& out->zs!= NULL){
+        deflateEnd( (z_stream*)out->zs);
+        free( out->zs);
+    }
+#endif
+#ifdef GEMF_ZSTD
+    if( out->codec== OUT_CODEC_ZSTD&& out->zs!= NULL){
+        ZSTD_freeCCtx( (ZSTD_CCtx*)out->zs);
+    }
+#endif
+    out->zs= NULL;
+    free( out->zbuf);
+    out->zbuf= NULL;
+}
+//compress and write n bytes, end the compressed stream if last
+static int out_emit( Out_stream* out, const char* p, size_t n, int last){
+    if( out->codec== OUT_CODEC_NONE) return write_all( out->fd, p, n);
+#ifdef GEMF_ZLIB
+    if( out->codec== OUT_CODEC_GZIP){
+        z_stream* z= (z_stream*)out->zs;
+        int ret;
+        z->next_in= (Bytef*)p;
+        z->avail_in= (uInt)n;
+        do{
+            z->next_out= (Bytef*)out->zbuf;
+            z->avail_out= OUT_ZBUF_SIZE;
+            ret= deflate( z, last? Z_FINISH: Z_NO_FLUSH);
+            if( ret== Z_STREAM_ERROR) return -1;
+            if( write_all( out->fd, out->zbuf, OUT_ZBUF_SIZE- z->avail_out)) return -1;
+        } while( z->avail_in> 0|| z->avail_out== 0|| (last&& ret!= Z_STREAM_END));
+        return 0;
+    }
+#endif
+#ifdef GEMF_ZSTD
+    if( out->codec== OUT_CODEC_ZSTD){
+        ZSTD_inBuffer in= { p, n, 0};
+        ZSTD_outBuffer zout;
+        size_t left;
+        do{
+            zout.dst= out->zbuf;
+            zout.size= OUT_ZBUF_SIZE;
+            zout.pos= 0;
+            left= ZSTD_compressStream2( (ZSTD_CCtx*)out->zs, &zout, &in, last? ZSTD_e_end: ZSTD_e_continue);
+            if( ZSTD_isError( left)) return -1;
+            if( write_all( out->fd, out->zbuf, zout.pos)) return -1;
+        } while( in.pos< in.size|| (last&& left> 0));
+        return 0;
+    }
+#endif
+    return -1;
+}
+static void* out_writer( void* arg){
+    Out_stream* out= (Out_stream*)arg;
+    char* p;
+    size_t n;
+    pthread_mutex_lock( &out->lock);
+    while( 1){
+        while( out->pending== NULL&& !out->closing){
+            pthread_cond_wait( &out->cond, &out->lock);
+        }
+        if( out->pending== NULL){
+            //end of the compressed stream
+            if( out->codec!= OUT_CODEC_NONE&& out_emit( out, NULL, 0, 1)&& out->err== 0){
+                out->err= -1;
+            }
+            break;
+        }
+        p= out->pending;
+        n= out->pending_len;
+        pthread_mutex_unlock( &out->lock);
+        if( out_emit( out, p, n, 0)&& out->err== 0){
+            out->err= -1;
+        }
+        pthread_mutex_lock( &out->lock);
+        out->pending= NULL;
+        out->written+= n;
+        pthread_cond_broadcast( &out->cond);
+    }
+    pthread_mutex_unlock( &out->lock);
+    return NULL;
+}
+//open with O_TRUNC, or cut to offset and append if resume, the file holding at least offset bytes
+static Out_stream* out_open_file( const char* fil_nam, int codec, int level, int resume, uint64_t offset){
+    struct stat sb;
+    Out_stream* out= (Out_stream*)calloc( 1, sizeof(Out_stream));
+    if( out== NULL) return NULL;
+    out->codec= codec;
+    out->level= level;
+    if( out_codec_init( out)< 0){
+        printf("compression[%s] not built in, see Makefile\n", codec== OUT_CODEC_GZIP? "gzip": "zstd");
+        out_codec_free( out);
+        free( out);
+        return NULL;
+    }
+    out->fd= open( fil_nam, O_WRONLY| O_CREAT| (resume? 0: O_TRUNC), 0644);
+    //a shorter file lost output written before the checkpoint, ftruncate would pad it with zeros
+    if( out->fd>= 0&& resume&& (fstat( out->fd, &sb)|| (uint64_t)sb.st_size< offset)){
+        printf("output file[%s] is shorter than the checkpoint, [%llu] bytes\n", fil_nam, (unsigned long long)offset);
+        close( out->fd);
+        out->fd= -1;
+    }
+    if( out->fd>= 0&& resume&& (ftruncate( out->fd, (off_t)offset)|| lseek( out->fd, 0, SEEK_END)!= (off_t)offset)){
+        close( out->fd);
+        out->fd= -1;
+    }
+    if( out->fd< 0){
+        out_codec_free( out);
+        free( out);
+        return NULL;
+    }
+    out->flushed= offset;
+    out->written= offset;
+    out->mem[0]= (char*)malloc( OUT_BUF_SIZE);
+    out->mem[1]= (char*)malloc( OUT_BUF_SIZE);
+    if( out->mem[0]== NULL|| out->mem[1]== NULL){
+        printf("Memory allocation failure for output buffer, size[%d]\n", OUT_BUF_SIZE);
+        error_exit( -1);
+    }
+    out->buf= out->mem[0];
+    pthread_mutex_init( &out->lock, NULL);
+    pthread_cond_init( &out->cond, NULL);
+    if( pthread_create( &out->tid, NULL, out_writer, out)){
+        printf("create output writer thread failed\n");
+        error_exit( -1);
+    }
+    return out;
+}
+Out_stream* out_open( const char* fil_nam, int codec, int level){
+    return out_open_file( fil_nam, codec, level, 0, 0);
+}
+Out_stream* out_open_at( const char* fil_nam, uint64_t offset){
+    return out_open_file( fil_nam, OUT_CODEC_NONE, 0, 1, offset);
+}
+int out_sync( Out_stream* out, uint64_t n){
+    int ret;
+    pthread_mutex_lock( &out->lock);
+    while( out->written< n&& out->err== 0){
+        pthread_cond_wait( &out->cond, &out->lock);
+    }
+    ret= out->err;
+    pthread_mutex_unlock( &out->lock);
+    if( ret== 0&& fdatasync( out->fd)) ret= -1;
+    return ret;
+}
+void out_flush_buf( Out_stream* out){
+    if( out->len== 0) return;
+    pthread_mutex_lock( &out->lock);
+    while( out->pending!= NULL){
+        pthread_cond_wait( &out->cond, &out->lock);
+    }
+    out->pending= out->buf;
+    out->pending_len= out->len;
+    pthread_cond_broadcast( &out->cond);
+    pthread_mutex_unlock( &out->lock);
+    out->buf= out->buf== out->mem[0]? out->mem[1]: out->mem[0];
+    out->flushed+= out->len;
+    out->len= 0;
+}
+void out_write( Out_stream* out, const void* data, size_t n){
+    const char* p= (const char*)data;
+    size_t k;
+    while( n> 0){
+        if( out->len== OUT_BUF_SIZE) out_flush_buf( out);
+        k= OUT_BUF_SIZE- out->len;
+        if( k> n) k= n;
+        memcpy( out->buf+ out->len, p, k);
+        out->len+= k;
+        p+= k;
+        n-= k;
+    }
+}
+void out_printf( Out_stream* out, const char* format, ...){
+    va_list args;
+    int n;
+    char* p;
+    va_start( args, format);
+    n= vsnprintf( out_reserve( out, 256), 256, format, args);
+    va_end( args);
+    if( n>= 256){
+        //long line, format it on the heap
+        p= (char*)malloc( (size_t)n+ 1);
+        if( p== NULL){
+            printf("Memory allocation failure for output line, size[%d]\n", n+ 1);
+            error_exit( -1);
+        }
+        va_start( args, format);
+        vsnprintf( p, (size_t)n+ 1, format, args);
+        va_end( args);
+        out_write( out, p, (size_t)n);
+        free( p);
+        return;
+    }
+    if( n> 0) out_commit( out, (size_t)n);
+}
+int out_close( Out_stream* out){
+    int ret;
+    out_flush_buf( out);
+    pthread_mutex_lock( &out->lock);
+    out->closing= 1;
+    pthread_cond_broadcast( &out->cond);
+    pthread_mutex_unlock( &out->lock);
+    pthread_join( out->tid, NULL);
+    ret= out->err;
+    if( close( out->fd)) ret= -1;
+    pthread_mutex_destroy( &out->lock);
+    pthread_cond_destroy( &out->cond);
+    out_codec_free( out);
+    free( out->mem[0]);
+    free( out->mem[1]);
+    free( out);
+    return ret;
+}
+//input of the decoder, read through zlib if built in, which also reads uncompressed files
+#ifdef GEMF_ZLIB
+typedef gzFile Evt_in;
+#define evt_open( nam) gzopen( nam, "rb")
+#define evt_close( in) gzclose( in)
+#define evt_eof( in) gzeof( in)
+static size_t evt_read( void* p, size_t size, size_t n, Evt_in in){
+    int ret= gzread( in, p, (unsigned)(size* n));
+    return ret< 0? 0: (size_t)ret/ size;
+}
+#else
+typedef FILE* Evt_in;
+#define evt_open( nam) fopen( nam, "rb")
+#define evt_close( in) fclose( in)
+#define evt_eof( in) feof( in)
+#define evt_read fread
+#endif
+int evt_log_decode( const char* in_nam, const char* out_nam){
+    Evt_log_header hdr;
+    Evt_record rec;
+    Evt_in fil_in;
+    FILE* fil_out;
+    uint32_t* cnt= NULL;
+    uint32_t* ind= NULL;
+    uint32_t k, n, l;
+    size_t count= 0, ind_cap= 0;
+    int ret= 0;
+
+    fil_in= evt_open( in_nam);
+    if( fil_in== NULL){
+        printf("read event log[%s] error\n", in_nam);
+        return -1;
+    }
+    if( evt_read( &hdr, sizeof(hdr), 1, fil_in)!= 1|| memcmp( hdr.magic, EVT_LOG_MAGIC, sizeof(EVT_LOG_MAGIC))){
+        printf("[%s] is not a binary event log\n", in_nam);
+        evt_close( fil_in);
+        return -1;
+    }
+    if( hdr.version!= EVT_LOG_VERSION){
+        printf("event log[%s] version[%u] not supported\n", in_nam, hdr.version);
+        evt_close( fil_in);
+        return -1;
+    }
+    fil_out= out_nam== NULL? stdout: fopen( out_nam, "w");
+    if( fil_out== NULL){
+        printf("open output file[%s] faild\n", out_nam);
+        evt_close( fil_in);
+        return -1;
+    }
+    //population indexed by compartment
+    cnt= (uint32_t*)calloc( hdr._s+ hdr.M, sizeof(uint32_t));
+    if( cnt== NULL|| evt_read( cnt+ hdr._s, sizeof(uint32_t), hdr.M, fil_in)!= hdr.M){
+        printf("event log[%s] truncated\n", in_nam);
+        ret= -1;
+    }
+    while( ret== 0&& (k= (uint32_t)evt_read( &rec, 1, sizeof(rec), fil_in))> 0){
+        if( k!= sizeof(rec)){
+            ret= -1;
+            break;
+        }
+        if( rec.ni< hdr._s|| rec.ni>= hdr._s+ hdr.M|| rec.nj< hdr._s|| rec.nj>= hdr._s+ hdr.M){
+            printf("event log[%s] record[%zu] has wrong status\n", in_nam, count);
+            ret= -1;
+            break;
+        }
+        cnt[rec.ni]--;
+        cnt[rec.nj]++;
+        fprintf( fil_out, "%lf %lf "fmt_n" %u %u", rec.t, rec.R, rec.ns, (unsigned)rec.ni, (unsigned)rec.nj);
+        for( k= hdr._s; k< hdr._s+ hdr.M; k++){
+            fprintf( fil_out, " %d", (int)cnt[k]);
+        }
+        if( hdr.flags& EVT_LOG_INFECTOR){
+            if( evt_read( &n, sizeof(n), 1, fil_in)!= 1){
+                ret= -1;
+                break;
+            }
+            if( n== UINT32_MAX) fprintf( fil_out, " -1");
+            else fprintf( fil_out, " %u", n);
+        }
+        if( hdr.flags& EVT_LOG_INDUCER){
+            fprintf( fil_out, " [");
+            for( l= 0; l<= hdr.L; l++){
+                if( l) fprintf( fil_out, "],[");
+                if( evt_read( &n, sizeof(n), 1, fil_in)!= 1){
+                    ret= -1;
+                    break;
+                }
+                if( n> ind_cap){
+                    ind_cap= 2* n;
+                    free( ind);
+                    ind= (uint32_t*)malloc( sizeof(uint32_t)* ind_cap);
+                    if( ind== NULL){
+                        printf("Memory allocation failure for inducer list, size[%zu]\n", sizeof(uint32_t)* ind_cap);
+                        error_exit( -1);
+                    }
+                }
+                if( evt_read( ind, sizeof(uint32_t), n, fil_in)!= n){
+                    ret= -1;
+                    break;
+                }
+                for( k= 0; k< n; k++){
+                    fprintf( fil_out, k? ",%d": "%d", (int)ind[k]);
+                }
+            }
+            fprintf( fil_out, "]");
+        }
+        fprintf( fil_out, "\n");
+        count++;
+        //keyframe of the population
+        if( hdr.flags& EVT_LOG_COUNTS&& count% EVT_LOG_KEYFRAME== 0){
+            for( k= 0; k< hdr.M&& ret== 0; k++){
+                if( evt_read( &n, sizeof(n), 1, fil_in)!= 1|| n!= cnt[hdr._s+ k]){
+                    printf("event log[%s] population mismatch after record[%zu]\n", in_nam, count);
+                    ret= -1;
+                }
+            }
+        }
+    }
+    if( ret== 0&& !evt_eof( fil_in)){
+        ret= -1;
+    }
+    if( ret< 0){
+        printf("event log[%s] decode failed after [%zu] records\n", in_nam, count);
+    }
+    free( cnt);
+    free( ind);
+    evt_close( fil_in);
+    if( fil_out!= stdout) fclose( fil_out);
+    return ret;
+}
@@ -0,0 +1,137 @@
+#ifndef OUTPUTH
+#define OUTPUTH
+
+#include "common.h"
+#include <stdint.h>
+#include <pthread.h>
+/*
+ * output.h of GEMF in C language
+ * buffered output stream with a background writer thread, and the
+ * binary event log written through it
+ *
+ * the simulation fills one buffer while the writer thread compresses and
+ * writes the other one with large write() calls, the simulation only
+ * waits if the writer is a whole buffer behind.
+ * gzip needs zlib (GEMF_ZLIB), zstd needs libzstd (GEMF_ZSTD), see Makefile.
+ *
+ * binary event log, native byte order:
+ *   header    Evt_log_header, then uint32 initial population by M
+ *   record    Evt_record, 24 bytes
+ *             with EVT_LOG_INFECTOR, followed by uint32 infector, 0xFFFFFFFF
+ *             for a nodal transition
+ *             with EVT_LOG_INDUCER, followed by uint32 number of nodal
+ *             inducers (0 or 1), of inducers of each layer, then the nodes
+ *   counts    with EVT_LOG_COUNTS, uint32 population by M after every
+ *             EVT_LOG_KEYFRAME records; in between, the population is
+ *             delta encoded by ni/nj of each record
+ */
+
+#define OUT_BUF_SIZE (4<< 20)
+
+#define OUT_CODEC_NONE 0
+#define OUT_CODEC_GZIP 1
+#define OUT_CODEC_ZSTD 2
+
+typedef struct{
+    int fd;
+    //buffer filled by the simulation, and its used bytes
+    char* buf;
+    size_t len;
+    //buffer handed to the writer thread, NULL if writer is idle
+    char* pending;
+    size_t pending_len;
+    char* mem[2];
+    //compression codec and level, codec state and its output buffer
+    int codec;
+    int level;
+    void* zs;
+    char* zbuf;
+    int closing;
+    //bytes handed to the writer thread, and bytes it has written
+    uint64_t flushed;
+    uint64_t written;
+    //first write error of the writer thread
+    int err;
+    pthread_t tid;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} Out_stream;
+
+/*
+ *open output file and start its writer thread
+ *
+ *input:  char* fil_nam   [ file name]
+ *        int   codec     [ OUT_CODEC_NONE, OUT_CODEC_GZIP or OUT_CODEC_ZSTD]
+ *        int   level     [ compression level, <=0 for the codec default]
+ *return: Out_stream*  [NULL: failure]
+ */
+Out_stream* out_open( const char* fil_nam, int codec, int level);
+//open uncompressed output file cut to offset bytes and append to it, to resume a run
+Out_stream* out_open_at( const char* fil_nam, uint64_t offset);
+//append n bytes
+void out_write( Out_stream* out, const void* data, size_t n);
+//append formatted text
+void out_printf( Out_stream* out, const char* format, ...);
+//flush, stop writer thread, close file, return <0 if any write failed
+int out_close( Out_stream* out);
+//hand the filled buffer to the writer thread
+void out_flush_buf( Out_stream* out);
+//wait until the first n bytes are in the file and on disk, <0 if a write failed
+int out_sync( Out_stream* out, uint64_t n);
+//codec of name "none", "gzip" or "zstd", <0 if unknown or not built in
+int out_codec( const char* name);
+//codec implied by the file name extension, .gz or .zst
+int out_codec_of_file( const char* fil_nam);
+
+//room for at least n bytes in the current buffer
+static inline char* out_reserve( Out_stream* out, size_t n){
+    if( out->len+ n> OUT_BUF_SIZE) out_flush_buf( out);
+    return out->buf+ out->len;
+}
+static inline void out_commit( Out_stream* out, size_t n){
+    out->len+= n;
+}
+//bytes appended so far, uncompressed
+static inline uint64_t out_tell( Out_stream* out){
+    return out->flushed+ out->len;
+}
+
+#define EVT_LOG_MAGIC "GEMFEVT"
+#define EVT_LOG_VERSION 1
+#define EVT_LOG_COUNTS 1
+#define EVT_LOG_INDUCER 2
+#define EVT_LOG_INFECTOR 4
+#define EVT_LOG_KEYFRAME 65536
+
+typedef struct{
+    char magic[8];
+    uint32_t version;
+    //EVT_LOG_COUNTS, EVT_LOG_INDUCER, EVT_LOG_INFECTOR
+    uint32_t flags;
+    //compartments start from _s, M compartments, L layers
+    uint32_t M;
+    uint32_t _s;
+    uint32_t L;
+    uint32_t reserved[3];
+} Evt_log_header;
+
+typedef struct{
+    double t;
+    //total rate after the event
+    double R;
+    NINT ns;
+    uint16_t ni;
+    uint16_t nj;
+} Evt_record;
+
+/*
+ *decode binary event log to the text event format, the log may be
+ *gzip compressed
+ *
+ *input:  char* in_nam    [ binary event log]
+ *        char* out_nam   [ text file, NULL for stdout]
+ *return: int   [0: success; <0: failure]
+ */
+int evt_log_decode( const char* in_nam, const char* out_nam);
+
+#endif
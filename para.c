@@ -1,5 +1,6 @@
 #include "para.h"
 #include "common.h"
+#include "rng.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,6 +8,7 @@
 #include <math.h>
 #include <ctype.h>
 #include <limits.h>
+#include <time.h>
 /*
  * process configuration
  * Futing Fan
@@ -97,6 +99,24 @@ int locate_section_only( FILE* p_file, char* target_section){
     }
     return 0;
 }
+/*
+ * check section exists and has at least 1 item, silent if missing
+ *
+ *input:  FILE* p_file     [ file pointer]
+ *input:  char* target_section     [ name of target section]
+ *return: int   [1: section has item; 0: section missing or empty]
+ */
+int section_exist( FILE* p_file, char* target_section){
+    LINE tmp_str;
+
+    rewind( p_file);
+    while( fgetline( p_file, tmp_str, MAX_LINE_LEN)){
+        if( !strcmp( tmp_str, target_section)){
+            return fget_next_item( p_file, tmp_str, MAX_LINE_LEN)> 0;
+        }
+    }
+    return 0;
+}
 /*
  *locate section with 0 itme check
  *
@@ -153,88 +173,6 @@ size_t column_count( char* string){
     }
     return c/2;
 }
-/*
- *analysis network metrics
- *
- *input:  FILE* fil_para   [ parameter file, with pointer pointing at the beginning of the first network data file name]
- *inout:  Graph* graph     [graph struct]
- *return: int   [0: success; <0: failure]
- */
-int analysis_network(FILE* fil_para, Graph* graph){
-    int _weighted;
-    size_t count, layer;
-    LONG li, lj;
-    int ret;
-    NINT _end_num, _begin_num;
-    double time0;
-    double lw;
-    LINE fil_nam;
-    LINE tmp_str;
-    FILE* fil_dat;
-
-    _begin_num= INT_MAX;
-    _end_num= 0;
-    _weighted= -1;
-    graph->E= (size_t*)malloc(sizeof(size_t)*graph->L);
-    if( graph->E== NULL){
-        printf("Memory allocation failure for edges number list, size[%zu]\n", sizeof(size_t)*graph->L);
-        exit( - 1);
-    }
-    for( layer= 0; layer< graph->L; layer++){
-        //fscanf( fil_para, "%s ", fil_nam);
-        fget_next_item( fil_para, fil_nam, MAX_LINE_LEN);
-        fil_dat= fopen( fil_nam, "r");
-        if( fil_dat== NULL){
-            printf("read layer[%zu] network file[%s] error\n", layer, fil_nam);
-            exit( - 1);
-        }
-        fget_next_item( fil_dat, tmp_str, MAX_LINE_LEN);
-        _weighted= (int)column_count( tmp_str);
-        if( _weighted== 2){
-            _weighted= 0;
-        }
-        else if( _weighted== 3){
-            _weighted= 1;
-        }
-        else{
-            printf("wrong column number[%d] in file[%s]\n", _weighted, fil_nam);
-            return -1;
-        }
-        count= 0;
-        skip_top_comment( fil_dat, '#');
-        time0= gettimenow();
-        while( 1){
-            if( _weighted){
-                ret= fscanf(fil_dat,"%lld %lld %lf", &li, &lj, &lw);
-            }
-            else{
-                ret= fscanf(fil_dat, "%lld %lld", &li, &lj);
-            }
-            if( ret!= (2+ _weighted)) break;
-            if( count&& !(count%5000000)){
-                time_print( "[ ", gettimenow() - time0, " ]");
-                kilobit_print(", [ ", (LONG)count, " ] edges detected\n");
-            }
-
-            check_int_range( li);
-            check_int_range( lj);
-            if( _begin_num> (NINT)li) _begin_num= (NINT)li;
-            if( _begin_num> (NINT)lj) _begin_num= (NINT)lj;
-            if( _end_num< (NINT)li) _end_num= (NINT)li;
-            if( _end_num< (NINT)lj) _end_num= (NINT)lj;
-            count++;
-        }
-        graph->E[layer]= count;
-        printf("layer %zu edges", layer);
-        kilobit_print("\t\t[ ", (LONG)count, " ]\n");
-        fclose( fil_dat);
-    }
-    graph->_s= _begin_num;
-    graph->_e= _end_num +1;
-    graph->V= _end_num - _begin_num+ 1;
-    graph->weighted= _weighted;
-    return 0;
-}
 /*
  *initial status
  *
@@ -288,8 +226,9 @@ int initial_con(FILE* fil_sts, Graph* graph, Status* sts){
     int j, k, val;
     NINT count, max_compartment, ni;
     LINE ch;
+    Rng rng;
     sts->init_lst= (size_t*)malloc(sizeof(size_t)*graph->_e);
-    sts->init_cnt= (NINT*)malloc(sizeof(NINT)*(sts->_s+sts->M));
+    sts->init_cnt= (NINT*)calloc(sts->_s+sts->M, sizeof(NINT));
 
     line_num= 0;
     while( fgetline( fil_sts, ch, MAX_LINE_LEN)) line_num++;
@@ -308,7 +247,9 @@ int initial_con(FILE* fil_sts, Graph* graph, Status* sts){
     else if( line_num== 1){
         //MODE 2.
         LOG(2, __FILE__, __LINE__, "Status file mode [2]\n");
-        srand((unsigned int)sts->random_seed);
+        //own stream group, apart from the simulation rounds
+        rng_seed( &rng, sts->rng_kind, (uint64_t)sts->random_seed);
+        rng_long_jump( &rng);
         k= 0;
         count= 0;
         rewind( fil_sts);
@@ -360,9 +301,9 @@ int initial_con(FILE* fil_sts, Graph* graph, Status* sts){
         for( li=sts->_s; li< sts->M+ sts->_s; li++){
             if( li!= max_compartmet_value){
                 for( j= 0; j< sts->init_cnt[li];){
-                    lj= (size_t)((rand()/(double)RAND_MAX)*graph->V);
+                    lj= graph->_s+ (size_t)rng_below( &rng, graph->V);
                     if( sts->init_lst[lj]!= max_compartmet_value) continue;
-                    sts->init_lst[graph->_s+ lj%graph->V]= li;
+                    sts->init_lst[lj]= li;
                     j++;
                 }
             }
@@ -511,6 +452,15 @@ LONG getValInt( FILE* fil, char* section, int echo){
     }
     return ret;
 }
+LONG getValIntOpt( FILE* fil, char* section, LONG def, int echo){
+    if( section_exist( fil, section)){
+        return getValInt( fil, section, echo);
+    }
+    if( echo){
+        printf("%s\t\t[%lld]\n", section, def);
+    }
+    return def;
+}
 double getValDbl( FILE* fil, char* section, int echo){
     double ret;
     locate_section( fil, section);
@@ -31,6 +31,15 @@ int item_count( FILE* p_file, char* target_section);
  */
 int locate_section_only( FILE* p_file, char* target_section);
 
+/*
+ * check section exists and has at least 1 item, silent if missing
+ *
+ *input:  FILE* p_file     [ file pointer]
+ *input:  char* target_section     [ name of target section]
+ *return: int   [1: section has item; 0: section missing or empty]
+ */
+int section_exist( FILE* p_file, char* target_section);
+
 /*
  *locate section with 0 itme check
  *
@@ -56,15 +65,6 @@ int fcolumn_count( FILE* p_file);
  */
 size_t column_count( char* string);
 
-/*
- *analysis network metrics
- *
- *input:  FILE* fil_para   [ parameter file, with pointer pointing at the beginning of the first network data file name]
- *inout:  Graph* graph     [graph struct]
- *return: int   [0: success; <0: failure]
- */
-int analysis_network(FILE* fil_para, Graph* graph);
-
 /*
  *fgetline( skip blank line and trim space on both end)
  *
@@ -122,6 +122,8 @@ int initial_con(FILE* fil_sts, Graph* graph, Status* sts);
 int _auto_sscanf(char** str, char* format, ...);
 //get an integer value from section of fil
 LONG getValInt( FILE* fil, char* section, int echo);
+//get an integer value from an optional section of fil, def if missing
+LONG getValIntOpt( FILE* fil, char* section, LONG def, int echo);
 //get a size_t value from section of fil
 size_t* getValSize_tLst( FILE* fil, char* section, size_t len, int echo);
 //get a double value from section of fil
@@ -0,0 +1,167 @@
+#include "perf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+/*
+ * perf.c of GEMF in C language
+ * performance counters and run report, see perf.h
+ */
+
+static const char* perf_phase_nam[PERF_PHASES]= { "parse", "build", "init_inducer", "get_rat_lst", "loop", "output"};
+const char* perf_end_nam[END_KINDS]= { "max_time", "max_events", "no_events", "callback", "signal", "zero", "above", "rate", "wall"};
+
+Perf* perf_open( const char* fil_nam){
+    Perf* perf;
+    FILE* fil;
+    size_t len= strlen( fil_nam);
+    int p;
+    perf= (Perf*)calloc( 1, sizeof(Perf));
+    if( perf== NULL) return NULL;
+    perf->fil_nam= (char*)malloc( len+ 1);
+    perf->tmp_nam= (char*)malloc( len+ 5);
+    if( perf->fil_nam== NULL|| perf->tmp_nam== NULL){
+        perf_close( perf);
+        return NULL;
+    }
+    strcpy( perf->fil_nam, fil_nam);
+    sprintf( perf->tmp_nam, "%s.tmp", fil_nam);
+    perf->csv= len>= 4&& !strcmp( fil_nam+ len- 4, ".csv");
+    perf->t0= gettimenow();
+    perf->last_t= perf->t0;
+    if( perf->csv){
+        //header row, reports are appended
+        fil= fopen( fil_nam, "w");
+        if( fil== NULL){
+            perf_close( perf);
+            return NULL;
+        }
+        fprintf( fil, "report,elapsed,events,rounds,events_per_second,heap_updates_per_event,neighbor_updates_per_event,rejections_per_event,peak_rss_kb,bytes_written");
+        for( p= 0; p< PERF_PHASES; p++){
+            fprintf( fil, ",%s", perf_phase_nam[p]);
+        }
+        fprintf( fil, ",fired_degree_histogram\n");
+        fclose( fil);
+    }
+    return perf;
+}
+
+void perf_phase( Perf* perf, int phase, double sec){
+    if( perf!= NULL) perf->phase[phase]+= sec;
+}
+
+void perf_merge( Perf_counters* dst, const Perf_counters* src){
+    size_t b;
+    dst->heap_updates+= src->heap_updates;
+    dst->neighbor_updates+= src->neighbor_updates;
+    dst->rejections+= src->rejections;
+    dst->rounds+= src->rounds;
+    for( b= 0; b< END_KINDS; b++){
+        dst->ends[b]+= src->ends[b];
+    }
+    for( b= 0; b< PERF_DEG_BUCKETS; b++){
+        dst->deg_hist[b]+= src->deg_hist[b];
+    }
+}
+
+//keep one events per second sample
+static int perf_sample( Perf* perf, double t, double eps){
+    double* p;
+    if( perf->samples== perf->cap){
+        perf->cap= perf->cap? 2* perf->cap: 64;
+        p= (double*)realloc( perf->sample_t, perf->cap* sizeof(double));
+        if( p== NULL) return -1;
+        perf->sample_t= p;
+        p= (double*)realloc( perf->sample_eps, perf->cap* sizeof(double));
+        if( p== NULL) return -1;
+        perf->sample_eps= p;
+    }
+    perf->sample_t[perf->samples]= t;
+    perf->sample_eps[perf->samples]= eps;
+    perf->samples++;
+    return 0;
+}
+
+int perf_report( Perf* perf, const Perf_counters* cnt, uint64_t events, int final){
+    FILE* fil;
+    struct rusage ru;
+    struct stat sb;
+    double now= gettimenow();
+    double eps, per_evt= events? (double)events: 1.0;
+    long rss= 0;
+    long long written= 0;
+    size_t b, hist_len, s;
+    int p;
+
+    //events per second since the last report, over the whole loop at the end
+    eps= now> perf->last_t? (double)(events- perf->last_events)/ (now- perf->last_t): 0.0;
+    if( final&& perf->phase[PERF_LOOP]> 0){
+        eps= (double)events/ perf->phase[PERF_LOOP];
+    }
+    if( !final){
+        if( perf_sample( perf, now- perf->t0, eps)< 0) return -1;
+        perf->last_t= now;
+        perf->last_events= events;
+    }
+    if( getrusage( RUSAGE_SELF, &ru)== 0) rss= ru.ru_maxrss;
+    if( perf->out_file!= NULL&& stat( perf->out_file, &sb)== 0) written= (long long)sb.st_size;
+    for( hist_len= PERF_DEG_BUCKETS; hist_len> 0&& cnt->deg_hist[hist_len- 1]== 0; hist_len--);
+
+    if( perf->csv){
+        fil= fopen( perf->fil_nam, "a");
+        if( fil== NULL) return -1;
+        fprintf( fil, "%s,%.6f,%llu,%llu,%.3f,%.4f,%.4f,%.4f,%ld,%lld", final? "final": "heartbeat", now- perf->t0, (unsigned long long)events,
+            (unsigned long long)cnt->rounds, eps, cnt->heap_updates/ per_evt, cnt->neighbor_updates/ per_evt, cnt->rejections/ per_evt, rss, written);
+        for( p= 0; p< PERF_PHASES; p++){
+            fprintf( fil, ",%.6f", perf->phase[p]);
+        }
+        //histogram buckets separated by ';' to keep one column
+        fprintf( fil, ",");
+        for( b= 0; b< hist_len; b++){
+            fprintf( fil, b? ";%llu": "%llu", (unsigned long long)cnt->deg_hist[b]);
+        }
+        fprintf( fil, "\n");
+        return fclose( fil)== 0? 0: -1;
+    }
+
+    //JSON is replaced as a whole, readers never see a partial report
+    fil= fopen( perf->tmp_nam, "w");
+    if( fil== NULL) return -1;
+    fprintf( fil, "{\n  \"final\": %s,\n  \"elapsed\": %.6f,\n", final? "true": "false", now- perf->t0);
+    fprintf( fil, "  \"phases\": {");
+    for( p= 0; p< PERF_PHASES; p++){
+        fprintf( fil, "%s\"%s\": %.6f", p? ", ": "", perf_phase_nam[p], perf->phase[p]);
+    }
+    fprintf( fil, "},\n");
+    fprintf( fil, "  \"events\": %llu,\n  \"rounds\": %llu,\n  \"events_per_second\": %.3f,\n", (unsigned long long)events, (unsigned long long)cnt->rounds, eps);
+    fprintf( fil, "  \"heap_updates\": %llu,\n  \"heap_updates_per_event\": %.4f,\n", (unsigned long long)cnt->heap_updates, cnt->heap_updates/ per_evt);
+    fprintf( fil, "  \"neighbor_updates\": %llu,\n  \"neighbor_updates_per_event\": %.4f,\n", (unsigned long long)cnt->neighbor_updates, cnt->neighbor_updates/ per_evt);
+    fprintf( fil, "  \"rejections\": %llu,\n  \"rejections_per_event\": %.4f,\n", (unsigned long long)cnt->rejections, cnt->rejections/ per_evt);
+    fprintf( fil, "  \"round_ends\": {");
+    for( b= 0; b< END_KINDS; b++){
+        fprintf( fil, "%s\"%s\": %llu", b? ", ": "", perf_end_nam[b], (unsigned long long)cnt->ends[b]);
+    }
+    fprintf( fil, "},\n");
+    fprintf( fil, "  \"fired_degree_histogram\": [");
+    for( b= 0; b< hist_len; b++){
+        fprintf( fil, "%s%llu", b? ", ": "", (unsigned long long)cnt->deg_hist[b]);
+    }
+    fprintf( fil, "],\n  \"peak_rss_kb\": %ld,\n  \"bytes_written\": %lld,\n", rss, written);
+    fprintf( fil, "  \"events_per_second_samples\": [");
+    for( s= 0; s< perf->samples; s++){
+        fprintf( fil, "%s[%.3f, %.3f]", s? ", ": "", perf->sample_t[s], perf->sample_eps[s]);
+    }
+    fprintf( fil, "]\n}\n");
+    if( fclose( fil)!= 0) return -1;
+    return rename( perf->tmp_nam, perf->fil_nam)== 0? 0: -1;
+}
+
+void perf_close( Perf* perf){
+    if( perf== NULL) return;
+    free( perf->fil_nam);
+    free( perf->tmp_nam);
+    free( perf->sample_t);
+    free( perf->sample_eps);
+    free( perf);
+}
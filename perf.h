@@ -0,0 +1,90 @@
+#ifndef PERFH
+#define PERFH
+
+#include "common.h"
+#include <stdint.h>
+/*
+ * perf.h of GEMF in C language
+ * performance counters of a run and its machine-readable report
+ *
+ * every worker counts into the Perf_counters of its Sim_state, they are
+ * merged when the simulation ends. the report is written to [REPORT_FILE]
+ * at every heart beat and once at the end, as JSON, or as CSV with one
+ * row per report if the file name ends with .csv. heart beat reports of
+ * an ensemble only cover the first worker, as the console heart beat does.
+ */
+
+//phases of a run, seconds of each are reported
+#define PERF_PARSE 0
+//sorting edges into CSR and building the reverse adjacency
+#define PERF_BUILD 1
+#define PERF_INDUCER 2
+#define PERF_RATES 3
+#define PERF_LOOP 4
+//flushing and closing the output file after the last event
+#define PERF_OUTPUT 5
+#define PERF_PHASES 6
+
+//histogram of fired node degrees, bucket b> 0 holds degrees in [2^(b-1), 2^b)
+#define PERF_DEG_BUCKETS 32
+
+typedef struct{
+    uint64_t heap_updates;
+    //neighbours whose rate an event changed
+    uint64_t neighbor_updates;
+    //proposals turned down by the rejection method
+    uint64_t rejections;
+    uint64_t rounds;
+    //rounds by how they ended, END_*
+    uint64_t ends[END_KINDS];
+    uint64_t deg_hist[PERF_DEG_BUCKETS];
+} Perf_counters;
+
+//names of the END_* kinds, as reported
+extern const char* perf_end_nam[END_KINDS];
+
+typedef struct Perf Perf;
+struct Perf{
+    char* fil_nam;
+    //JSON is written here and renamed to fil_nam
+    char* tmp_nam;
+    int csv;
+    //output file, its size is reported as bytes written
+    const char* out_file;
+    double t0;
+    double phase[PERF_PHASES];
+    //events per second samples, one per report
+    size_t samples, cap;
+    double* sample_t;
+    double* sample_eps;
+    double last_t;
+    uint64_t last_events;
+};
+
+//degree bucket of the histogram
+static inline size_t perf_deg_bucket( size_t deg){
+    size_t b= 0;
+    while( deg> 0&& b< PERF_DEG_BUCKETS- 1){
+        deg>>= 1;
+        b++;
+    }
+    return b;
+}
+
+//report to fil_nam, NULL on failure
+Perf* perf_open( const char* fil_nam);
+//add seconds to a phase, perf may be NULL
+void perf_phase( Perf* perf, int phase, double sec);
+void perf_merge( Perf_counters* dst, const Perf_counters* src);
+/*
+ *write the report of the run so far
+ *
+ *input:  Perf_counters* cnt    [ counters of the workers reported]
+ *        uint64_t       events [ events of the workers reported]
+ *        int            final  [ 0: heart beat, otherwise end of the run]
+ *return: int   [0 or -1]
+ */
+int perf_report( Perf* perf, const Perf_counters* cnt, uint64_t events, int final);
+void perf_close( Perf* perf);
+
+#endif
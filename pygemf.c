@@ -0,0 +1,370 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "gemf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+/*
+ * pygemf.c of GEMF in C language
+ * python module gemf, runs libgemf in process, built by setup.py
+ *
+ * arrays are passed through the buffer protocol (array.array, numpy,
+ * memoryview) and read in place; events are returned as array.array
+ * objects, or written in place into buffers given by the caller.
+ */
+
+//events of a round, in growing arrays or in buffers of the caller
+typedef struct{
+    double* t;
+    unsigned int* node;
+    unsigned int* from;
+    unsigned int* to;
+    long long* infector;
+    size_t n;
+    size_t cap;
+    //buffers of the caller, never grown
+    int fixed;
+    int nomem;
+} Evt_buf;
+
+static int evt_buf_grow( Evt_buf* b){
+    size_t cap= b->cap? 2* b->cap: 4096;
+    void* p;
+    if( (p= realloc( b->t, sizeof(double)* cap))== NULL) return -1;
+    b->t= (double*)p;
+    if( (p= realloc( b->node, sizeof(unsigned int)* cap))== NULL) return -1;
+    b->node= (unsigned int*)p;
+    if( (p= realloc( b->from, sizeof(unsigned int)* cap))== NULL) return -1;
+    b->from= (unsigned int*)p;
+    if( (p= realloc( b->to, sizeof(unsigned int)* cap))== NULL) return -1;
+    b->to= (unsigned int*)p;
+    if( (p= realloc( b->infector, sizeof(long long)* cap))== NULL) return -1;
+    b->infector= (long long*)p;
+    b->cap= cap;
+    return 0;
+}
+static int on_event( const gemf_event* e, void* user){
+    Evt_buf* b= (Evt_buf*)user;
+    if( b->n== b->cap){
+        if( b->fixed) return 1;
+        if( evt_buf_grow( b)){
+            b->nomem= 1;
+            return 1;
+        }
+    }
+    b->t[b->n]= e->t;
+    b->node[b->n]= e->node;
+    b->from[b->n]= e->from;
+    b->to[b->n]= e->to;
+    b->infector[b->n]= e->infector== GEMF_NO_INFECTOR? -1: (long long)e->infector;
+    b->n++;
+    return 0;
+}
+
+/*
+ *contiguous buffer of 32-bit integers ('I'), doubles ('d') or 64-bit integers ('q')
+ *
+ *return: int   [0: success; <0: failure, exception set]
+ */
+static int get_buf( PyObject* obj, Py_buffer* view, char kind, int writable, const char* name){
+    const char* f;
+    int ok;
+    if( PyObject_GetBuffer( obj, view, PyBUF_C_CONTIGUOUS| PyBUF_FORMAT| (writable? PyBUF_WRITABLE: 0))< 0){
+        return -1;
+    }
+    f= view->format!= NULL? view->format: "B";
+    if( *f== '@'|| *f== '='|| *f== '<') f++;
+    if( kind== 'd') ok= view->itemsize== 8&& !strcmp( f, "d");
+    else if( kind== 'I') ok= view->itemsize== 4&& f[0]!= '\0'&& strchr( "IiLl", f[0])!= NULL&& f[1]== '\0';
+    else ok= view->itemsize== 8&& f[0]!= '\0'&& strchr( "qQlL", f[0])!= NULL&& f[1]== '\0';
+    if( !ok){
+        PyErr_Format( PyExc_TypeError, "%s must be a contiguous buffer of %s", name, kind== 'd'? "float64": kind== 'I'? "32-bit integers": "64-bit integers");
+        PyBuffer_Release( view);
+        return -1;
+    }
+    return 0;
+}
+static PyObject* gemf_error( int code){
+    if( code== GEMF_ERR_ARG) PyErr_SetString( PyExc_ValueError, gemf_strerror( code));
+    else if( code== GEMF_ERR_MEM) PyErr_NoMemory();
+    else PyErr_SetString( PyExc_RuntimeError, gemf_strerror( code));
+    return NULL;
+}
+//array.array of typecode with a copy of n bytes at p
+static PyObject* to_array( PyObject* array_mod, const char* code, void* p, size_t n){
+    PyObject *arr, *mem, *ret;
+    arr= PyObject_CallMethod( array_mod, "array", "s", code);
+    if( arr== NULL) return NULL;
+    if( n== 0) return arr;
+    mem= PyMemoryView_FromMemory( (char*)p, (Py_ssize_t)n, PyBUF_READ);
+    if( mem== NULL){
+        Py_DECREF( arr);
+        return NULL;
+    }
+    ret= PyObject_CallMethod( arr, "frombytes", "O", mem);
+    Py_DECREF( mem);
+    if( ret== NULL){
+        Py_DECREF( arr);
+        return NULL;
+    }
+    Py_DECREF( ret);
+    return arr;
+}
+
+PyDoc_STRVAR( simulate_doc,
+"simulate(M, nodal, edge, inducers, src, dst, states, weights=None, directed=True,\n"
+"         max_time=inf, max_events=-1, seed=0, rng=None, scheduler=None, arity=4, out=None)\n"
+"\n"
+"Simulate one round of a GEMF model, nodes and compartments numbered from 0.\n"
+"\n"
+"M          number of compartments\n"
+"nodal      M*M float64 nodal rates, nodal[i*M+j] for i -> j\n"
+"edge       L*M*M float64 edge based rates, edge[(l*M+i)*M+j]\n"
+"inducers   inducer compartment of each of the L layers\n"
+"src, dst   uint32 edge arrays, stored once and shared by all layers, or a sequence of L of them\n"
+"states     uint32 initial compartment of each node\n"
+"weights    float64 edge weights like src, None for unweighted\n"
+"directed   False to add every edge in both directions\n"
+"scheduler  event scheduler, 'heap' (None), 'calendar', 'direct' or 'rejection'\n"
+"arity      arity of the heap scheduler, 2, 4 or 8\n"
+"out        five writable buffers (float64, uint32, uint32, uint32, int64) to\n"
+"           fill in place, the round stops when they are full\n"
+"\n"
+"Returns arrays (time, node, from, to, infector) of all events as array.array,\n"
+"infector is -1 for nodal transitions; with out, returns the number of events.");
+
+static PyObject* py_simulate( PyObject* self, PyObject* args, PyObject* kwds){
+    static char* kwlist[]= { "M", "nodal", "edge", "inducers", "src", "dst", "states", "weights", "directed",
+        "max_time", "max_events", "seed", "rng", "scheduler", "arity", "out", NULL};
+    Py_ssize_t M;
+    PyObject *nodal_o, *edge_o, *inducers_o, *src_o, *dst_o, *states_o, *weights_o= Py_None, *out_o= Py_None;
+    int directed= 1, arity= 4;
+    double max_time= DBL_MAX;
+    long long max_events= -1;
+    unsigned long long seed= 0;
+    const char* rng= NULL;
+    const char* scheduler= NULL;
+    Py_buffer nodal, edge, states, *src= NULL, *dst= NULL, *wgt= NULL, out[5];
+    Py_ssize_t L, layers= 0, l, i, j, E;
+    gemf_graph* graph= NULL;
+    gemf_model* model= NULL;
+    gemf_run* run= NULL;
+    Evt_buf evts;
+    PyObject *seq, *item, *array_mod, *ret= NULL;
+    int code= GEMF_OK, per_layer, views= 0;
+    size_t cap;
+
+    if( !PyArg_ParseTupleAndKeywords( args, kwds, "nOOOOOO|OpdLKzziO", kwlist, &M, &nodal_o, &edge_o, &inducers_o,
+        &src_o, &dst_o, &states_o, &weights_o, &directed, &max_time, &max_events, &seed, &rng, &scheduler, &arity, &out_o)){
+        return NULL;
+    }
+    memset( &evts, 0, sizeof(Evt_buf));
+    seq= PySequence_Fast( inducers_o, "inducers must be a sequence");
+    if( seq== NULL) return NULL;
+    L= PySequence_Fast_GET_SIZE( seq);
+    if( M< 1|| L< 1){
+        Py_DECREF( seq);
+        PyErr_SetString( PyExc_ValueError, "M and the number of inducers must be positive");
+        return NULL;
+    }
+    if( get_buf( nodal_o, &nodal, 'd', 0, "nodal")< 0){
+        Py_DECREF( seq);
+        return NULL;
+    }
+    if( get_buf( edge_o, &edge, 'd', 0, "edge")< 0){
+        Py_DECREF( seq);
+        PyBuffer_Release( &nodal);
+        return NULL;
+    }
+    if( get_buf( states_o, &states, 'I', 0, "states")< 0){
+        Py_DECREF( seq);
+        PyBuffer_Release( &nodal);
+        PyBuffer_Release( &edge);
+        return NULL;
+    }
+    //everything below releases through done
+    src= (Py_buffer*)calloc( (size_t)L, sizeof(Py_buffer));
+    dst= (Py_buffer*)calloc( (size_t)L, sizeof(Py_buffer));
+    wgt= (Py_buffer*)calloc( (size_t)L, sizeof(Py_buffer));
+    if( src== NULL|| dst== NULL|| wgt== NULL){
+        PyErr_NoMemory();
+        goto done;
+    }
+    if( nodal.len/ 8!= M* M|| edge.len/ 8!= L* M* M){
+        PyErr_SetString( PyExc_ValueError, "nodal must have M*M items and edge L*M*M items");
+        goto done;
+    }
+    //edges, the same arrays for every layer or one set per layer
+    per_layer= PyList_Check( src_o)|| PyTuple_Check( src_o);
+    for( layers= 0; layers< L; layers++){
+        l= layers;
+        item= per_layer? PySequence_GetItem( src_o, l): (Py_INCREF( src_o), src_o);
+        if( item== NULL|| get_buf( item, &src[l], 'I', 0, "src")< 0){
+            Py_XDECREF( item);
+            goto done;
+        }
+        Py_DECREF( item);
+        item= per_layer? PySequence_GetItem( dst_o, l): (Py_INCREF( dst_o), dst_o);
+        if( item== NULL|| get_buf( item, &dst[l], 'I', 0, "dst")< 0){
+            Py_XDECREF( item);
+            PyBuffer_Release( &src[l]);
+            goto done;
+        }
+        Py_DECREF( item);
+        if( weights_o!= Py_None){
+            item= per_layer? PySequence_GetItem( weights_o, l): (Py_INCREF( weights_o), weights_o);
+            if( item== NULL|| get_buf( item, &wgt[l], 'd', 0, "weights")< 0){
+                Py_XDECREF( item);
+                PyBuffer_Release( &src[l]);
+                PyBuffer_Release( &dst[l]);
+                goto done;
+            }
+            Py_DECREF( item);
+        }
+        if( src[l].len!= dst[l].len|| (weights_o!= Py_None&& wgt[l].len/ 8!= src[l].len/ 4)){
+            PyErr_SetString( PyExc_ValueError, "src, dst and weights must have the same length");
+            PyBuffer_Release( &src[l]);
+            PyBuffer_Release( &dst[l]);
+            if( weights_o!= Py_None) PyBuffer_Release( &wgt[l]);
+            goto done;
+        }
+    }
+    if( out_o!= Py_None){
+        if( !PyTuple_Check( out_o)|| PyTuple_GET_SIZE( out_o)!= 5){
+            PyErr_SetString( PyExc_TypeError, "out must be a tuple of 5 buffers");
+            goto done;
+        }
+        for( views= 0; views< 5; views++){
+            if( get_buf( PyTuple_GET_ITEM( out_o, views), &out[views], views== 0? 'd': views== 4? 'q': 'I', 1, "out")< 0){
+                goto done;
+            }
+        }
+        cap= (size_t)out[0].len/ 8;
+        for( i= 1; i< 5; i++){
+            if( (size_t)(out[i].len/ out[i].itemsize)< cap) cap= (size_t)(out[i].len/ out[i].itemsize);
+        }
+        evts.t= (double*)out[0].buf;
+        evts.node= (unsigned int*)out[1].buf;
+        evts.from= (unsigned int*)out[2].buf;
+        evts.to= (unsigned int*)out[3].buf;
+        evts.infector= (long long*)out[4].buf;
+        evts.cap= cap;
+        evts.fixed= 1;
+    }
+
+    //the engine runs without the interpreter lock, on the buffers held above
+    Py_BEGIN_ALLOW_THREADS
+    code= gemf_graph_create( &graph, (unsigned int)(states.len/ 4), (size_t)L, directed, weights_o!= Py_None);
+    for( l= 0; l< L&& code== GEMF_OK; l++){
+        //edges given once are stored once
+        if( l> 0&& !per_layer){
+            code= gemf_graph_share_layer( graph, (size_t)l, 0);
+            continue;
+        }
+        E= src[l].len/ 4;
+        code= gemf_graph_set_layer( graph, (size_t)l, (size_t)E, (unsigned int*)src[l].buf, (unsigned int*)dst[l].buf,
+            weights_o!= Py_None? (double*)wgt[l].buf: NULL);
+    }
+    if( code== GEMF_OK) code= gemf_model_create( &model, (size_t)M, (size_t)L);
+    for( i= 0; i< M&& code== GEMF_OK; i++){
+        for( j= 0; j< M&& code== GEMF_OK; j++){
+            if( i== j) continue;
+            code= gemf_model_nodal( model, (unsigned int)i, (unsigned int)j, ((double*)nodal.buf)[i* M+ j]);
+            for( l= 0; l< L&& code== GEMF_OK; l++){
+                code= gemf_model_edge( model, (size_t)l, (unsigned int)i, (unsigned int)j, ((double*)edge.buf)[(l* M+ i)* M+ j]);
+            }
+        }
+    }
+    Py_END_ALLOW_THREADS
+    for( l= 0; l< L&& code== GEMF_OK; l++){
+        j= PyLong_AsSsize_t( PySequence_Fast_GET_ITEM( seq, l));
+        if( j== -1&& PyErr_Occurred()) goto done;
+        if( j>= 0) code= gemf_model_inducer( model, (size_t)l, (unsigned int)j);
+    }
+    if( code!= GEMF_OK){
+        gemf_error( code);
+        goto done;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    code= gemf_run_create( &run, graph, model, (unsigned int*)states.buf);
+    if( code== GEMF_OK) code= gemf_run_seed( run, (uint64_t)seed, rng);
+    if( code== GEMF_OK) code= gemf_run_limits( run, max_time, max_events< 0? (size_t)-1: (size_t)max_events);
+    if( code== GEMF_OK) code= gemf_run_scheduler( run, scheduler, arity);
+    if( code== GEMF_OK) code= gemf_run_infector( run, 1);
+    if( code== GEMF_OK) code= gemf_run_simulate( run, on_event, &evts);
+    Py_END_ALLOW_THREADS
+    if( code!= GEMF_OK){
+        gemf_error( code);
+        goto done;
+    }
+    if( evts.nomem){
+        PyErr_NoMemory();
+        goto done;
+    }
+    if( evts.fixed){
+        ret= PyLong_FromSize_t( evts.n);
+        goto done;
+    }
+    array_mod= PyImport_ImportModule( "array");
+    if( array_mod== NULL) goto done;
+    ret= PyTuple_New( 5);
+    if( ret!= NULL){
+        PyObject* a[5];
+        a[0]= to_array( array_mod, "d", evts.t, sizeof(double)* evts.n);
+        a[1]= to_array( array_mod, "I", evts.node, sizeof(unsigned int)* evts.n);
+        a[2]= to_array( array_mod, "I", evts.from, sizeof(unsigned int)* evts.n);
+        a[3]= to_array( array_mod, "I", evts.to, sizeof(unsigned int)* evts.n);
+        a[4]= to_array( array_mod, "q", evts.infector, sizeof(long long)* evts.n);
+        for( i= 0; i< 5; i++){
+            if( a[i]== NULL){
+                Py_CLEAR( ret);
+                continue;
+            }
+            if( ret!= NULL) PyTuple_SET_ITEM( ret, i, a[i]);
+            else Py_DECREF( a[i]);
+        }
+        if( ret== NULL){
+            for( i= 0; i< 5; i++) Py_XDECREF( a[i]);
+        }
+    }
+    Py_DECREF( array_mod);
+
+done:
+    gemf_run_free( run);
+    gemf_model_free( model);
+    gemf_graph_free( graph);
+    if( !evts.fixed){
+        free( evts.t);
+        free( evts.node);
+        free( evts.from);
+        free( evts.to);
+        free( evts.infector);
+    }
+    for( i= 0; i< views; i++){
+        PyBuffer_Release( &out[i]);
+    }
+    for( l= 0; l< layers; l++){
+        PyBuffer_Release( &src[l]);
+        PyBuffer_Release( &dst[l]);
+        if( weights_o!= Py_None) PyBuffer_Release( &wgt[l]);
+    }
+    free( src);
+    free( dst);
+    free( wgt);
+    PyBuffer_Release( &nodal);
+    PyBuffer_Release( &edge);
+    PyBuffer_Release( &states);
+    Py_DECREF( seq);
+    return ret;
+}
+
+static PyMethodDef gemf_methods[]= {
+    { "simulate", (PyCFunction)(void(*)(void))py_simulate, METH_VARARGS| METH_KEYWORDS, simulate_doc},
+    { NULL, NULL, 0, NULL}
+};
+static struct PyModuleDef gemf_module= {
+    PyModuleDef_HEAD_INIT, "gemf", "GEMF simulation engine, see gemf.h", -1, gemf_methods
+};
+PyMODINIT_FUNC PyInit_gemf( void){
+    return PyModule_Create( &gemf_module);
+}
@@ -0,0 +1,129 @@
+#include "rng.h"
+#include <string.h>
+/*
+ * rng.c of GEMF in C language
+ * random number streams, see rng.h
+ */
+
+//splitmix64, expand a seed into generator state
+static uint64_t splitmix64( uint64_t* x){
+    uint64_t z= (*x+= 0x9E3779B97F4A7C15ULL);
+    z= (z^ (z>> 30))* 0xBF58476D1CE4E5B9ULL;
+    z= (z^ (z>> 27))* 0x94D049BB133111EBULL;
+    return z^ (z>> 31);
+}
+void rng_seed( Rng* rng, int kind, uint64_t seed){
+    uint64_t x= seed;
+    memset( rng, 0, sizeof(Rng));
+    rng->kind= kind;
+    if( kind== RNG_PHILOX){
+        x= splitmix64( &x);
+        rng->key[0]= (uint32_t)x;
+        rng->key[1]= (uint32_t)(x>> 32);
+        rng->used= 2;
+        return;
+    }
+    rng->s[0]= splitmix64( &x);
+    rng->s[1]= splitmix64( &x);
+    rng->s[2]= splitmix64( &x);
+    rng->s[3]= splitmix64( &x);
+}
+//xoshiro256 jump by polynomial
+static void xoshiro_jump( Rng* rng, const uint64_t* poly){
+    uint64_t s0= 0, s1= 0, s2= 0, s3= 0;
+    int i, b;
+    for( i= 0; i< 4; i++){
+        for( b= 0; b< 64; b++){
+            if( poly[i]& (1ULL<< b)){
+                s0^= rng->s[0];
+                s1^= rng->s[1];
+                s2^= rng->s[2];
+                s3^= rng->s[3];
+            }
+            rng_next( rng);
+        }
+    }
+    rng->s[0]= s0;
+    rng->s[1]= s1;
+    rng->s[2]= s2;
+    rng->s[3]= s3;
+}
+void rng_jump( Rng* rng){
+    static const uint64_t JUMP[]= { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    if( rng->kind== RNG_PHILOX){
+        //counter words 2 is the stream, words 0-1 the position in stream
+        rng->ctr[0]= rng->ctr[1]= 0;
+        rng->ctr[2]++;
+        rng->used= 2;
+        return;
+    }
+    xoshiro_jump( rng, JUMP);
+}
+void rng_long_jump( Rng* rng){
+    static const uint64_t LONG_JUMP[]= { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+    if( rng->kind== RNG_PHILOX){
+        //word 3 is the group, the stream in word 2 is kept
+        rng->ctr[0]= rng->ctr[1]= 0;
+        rng->ctr[3]++;
+        rng->used= 2;
+        return;
+    }
+    xoshiro_jump( rng, LONG_JUMP);
+}
+void rng_split( Rng* parent, Rng* child){
+    *child= *parent;
+    rng_jump( parent);
+}
+void rng_infector( const Rng* rng, Rng* inf){
+    //past the group of the initial status
+    *inf= *rng;
+    rng_long_jump( inf);
+    rng_long_jump( inf);
+}
+int rng_kind( const char* name){
+    if( !strcmp( name, "xoshiro256pp")|| !strcmp( name, "xoshiro")) return RNG_XOSHIRO;
+    if( !strcmp( name, "philox4x32")|| !strcmp( name, "philox")) return RNG_PHILOX;
+    return -1;
+}
+const char* rng_name( int kind){
+    return kind== RNG_PHILOX? "philox4x32": "xoshiro256pp";
+}
+void rng_philox_block( Rng* rng){
+    uint32_t c0= rng->ctr[0], c1= rng->ctr[1], c2= rng->ctr[2], c3= rng->ctr[3];
+    uint32_t k0= rng->key[0], k1= rng->key[1];
+    uint64_t p0, p1;
+    int r;
+    for( r= 0; r< 10; r++){
+        p0= (uint64_t)0xD2511F53U* c0;
+        p1= (uint64_t)0xCD9E8D57U* c2;
+        c0= (uint32_t)(p1>> 32)^ c1^ k0;
+        c2= (uint32_t)(p0>> 32)^ c3^ k1;
+        c1= (uint32_t)p1;
+        c3= (uint32_t)p0;
+        k0+= 0x9E3779B9U;
+        k1+= 0xBB67AE85U;
+    }
+    rng->out[0]= ((uint64_t)c0<< 32)| c1;
+    rng->out[1]= ((uint64_t)c2<< 32)| c3;
+    rng->used= 0;
+    if( ++rng->ctr[0]== 0){
+        rng->ctr[1]++;
+    }
+}
+void rng_fill_uniform( Rng* rng, double* out, size_t n){
+    size_t i;
+    for( i= 0; i< n; i++){
+        out[i]= (double)((rng_next( rng)>> 11)+ 1);
+    }
+    //scaling is independent of the generator, keep it vectorizable
+    for( i= 0; i< n; i++){
+        out[i]*= 0x1.0p-53;
+    }
+}
+void rng_fill_exp( Rng* rng, double* out, size_t n){
+    size_t i;
+    rng_fill_uniform( rng, out, n);
+    for( i= 0; i< n; i++){
+        out[i]= - log( out[i]);
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef RNGH
+#define RNGH
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+/*
+ * rng.h of GEMF in C language
+ * random number streams, one per simulation round/worker
+ *
+ * two generators are available:
+ *   xoshiro256++  fast, jump() moves 2^128 draws ahead, long_jump() 2^192
+ *   philox4x32-10 counter based, jump()/long_jump() select a new substream
+ * both are reproducible from (seed, number of jumps), never share state
+ * between threads, and never return 0 for the open interval variates
+ *
+ * streams of a seed: events of rounds by jumps, the initial status one
+ * long jump away (para.c), infectors of each event stream two long jumps
+ * away from it (rng_infector)
+ */
+
+#define RNG_XOSHIRO 0
+#define RNG_PHILOX 1
+
+typedef struct{
+    //generator, RNG_XOSHIRO or RNG_PHILOX
+    int kind;
+    //xoshiro256++ state
+    uint64_t s[4];
+    //philox counter and key
+    uint32_t ctr[4];
+    uint32_t key[2];
+    //philox output block and number of 64-bit words consumed from it
+    uint64_t out[2];
+    int used;
+} Rng;
+
+//seed generator of kind from a 64-bit seed
+void rng_seed( Rng* rng, int kind, uint64_t seed);
+//move to the next independent stream
+void rng_jump( Rng* rng);
+//move to the next independent group of streams
+void rng_long_jump( Rng* rng);
+//child gets the current stream, parent moves to the next one
+void rng_split( Rng* parent, Rng* child);
+//inf gets the infector stream of event stream rng
+void rng_infector( const Rng* rng, Rng* inf);
+//parse generator name, <0 if unknown
+int rng_kind( const char* name);
+//name of generator kind
+const char* rng_name( int kind);
+//fill out with n uniform variates in (0,1]
+void rng_fill_uniform( Rng* rng, double* out, size_t n);
+//fill out with n unit exponential variates
+void rng_fill_exp( Rng* rng, double* out, size_t n);
+//philox block function, refills rng->out
+void rng_philox_block( Rng* rng);
+
+static inline uint64_t rng_rotl( uint64_t x, int k){
+    return (x<< k)| (x>> (64- k));
+}
+//next raw 64-bit word
+static inline uint64_t rng_next( Rng* rng){
+    uint64_t ret, t;
+    if( rng->kind== RNG_PHILOX){
+        if( rng->used>= 2){
+            rng_philox_block( rng);
+        }
+        return rng->out[rng->used++];
+    }
+    ret= rng_rotl( rng->s[0]+ rng->s[3], 23)+ rng->s[0];
+    t= rng->s[1]<< 17;
+    rng->s[2]^= rng->s[0];
+    rng->s[3]^= rng->s[1];
+    rng->s[1]^= rng->s[2];
+    rng->s[0]^= rng->s[3];
+    rng->s[2]^= t;
+    rng->s[3]= rng_rotl( rng->s[3], 45);
+    return ret;
+}
+//uniform in [0,1), 53-bit resolution
+static inline double rng_uniform( Rng* rng){
+    return (rng_next( rng)>> 11)* 0x1.0p-53;
+}
+//uniform in (0,1], safe for log()
+static inline double rng_uniform_pos( Rng* rng){
+    return ((rng_next( rng)>> 11)+ 1)* 0x1.0p-53;
+}
+//unit exponential variate, always finite
+static inline double rng_exp( Rng* rng){
+    return - log( rng_uniform_pos( rng));
+}
+//uniform integer in [0,n)
+static inline uint64_t rng_below( Rng* rng, uint64_t n){
+    return (uint64_t)(rng_uniform( rng)* (double)n)% n;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#! /usr/bin/env python3
+'''
+Build the gemf Python module, libgemf run in process (see pygemf.c)
+python3 setup.py build_ext --inplace
+'''
+from setuptools import setup, Extension
+
+gemf = Extension('gemf',
+    sources=['pygemf.c', 'gemf.c', 'nrm.c', 'common.c', 'rng.c', 'graph_io.c', 'heap.c', 'calendar.c', 'sumtree.c', 'output.c', 'perf.c', 'tau.c', 'hub.c', 'ckpt.c', 'stats.c'],
+    define_macros=[('_POSIX_C_SOURCE', '200809L'), ('GEMF_ZLIB', None)],
+    libraries=['z', 'm'],
+    extra_compile_args=['-std=c99', '-pthread'],
+    extra_link_args=['-pthread'])
+
+setup(name='gemf', version='1.0.4', description='GEMF epidemic simulation engine', ext_modules=[gemf])
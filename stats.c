@@ -0,0 +1,211 @@
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/*
+ * stats.c of GEMF in C language
+ * streaming statistics of an ensemble, see stats.h
+ */
+
+void* malloc1( size_t l, size_t s);
+
+static const double ens_q[ENS_QUANTILES]= { 0.05, 0.25, 0.5, 0.75, 0.95};
+
+Ens_stats* ens_stats_init( size_t M, size_t I, int quant){
+    Ens_stats* es= (Ens_stats*)malloc1( 1, sizeof(Ens_stats));
+    memset( es, 0, sizeof(Ens_stats));
+    es->M= M;
+    es->I= I;
+    es->next= 1;
+    es->sum= (int64_t*)malloc1( M* I, sizeof(int64_t));
+    memset( es->sum, 0, M* I* sizeof(int64_t));
+    es->quant= quant;
+    if( quant){
+        es->mean= (double*)malloc1( M* I, sizeof(double));
+        es->m2= (double*)malloc1( M* I, sizeof(double));
+        es->p2= (P2_markers*)malloc1( M* I* ENS_QUANTILES, sizeof(P2_markers));
+        memset( es->mean, 0, M* I* sizeof(double));
+        memset( es->m2, 0, M* I* sizeof(double));
+    }
+    pthread_mutex_init( &es->lock, NULL);
+    return es;
+}
+void ens_stats_free( Ens_stats* es){
+    size_t k;
+    if( es== NULL) return;
+    for( k= 0; k< es->wait_cap; k++){
+        free( es->wait[k]);
+    }
+    free( es->wait);
+    free( es->wait_round);
+    free( es->sum);
+    free( es->mean);
+    free( es->m2);
+    free( es->p2);
+    pthread_mutex_destroy( &es->lock);
+    free( es);
+}
+
+//add x as the value c+ 1 of quantile p, the first five are kept sorted
+static void p2_add( P2_markers* m, double p, size_t c, double x){
+    double dn[5]= { 0, p/ 2, p, (1+ p)/ 2, 1};
+    double d, qp;
+    int i, k, s;
+    if( c< 5){
+        for( i= (int)c; i> 0&& m->q[i- 1]> x; i--){
+            m->q[i]= m->q[i- 1];
+        }
+        m->q[i]= x;
+        m->n[c]= (int64_t)c+ 1;
+        return;
+    }
+    //cell of x, extremes move with it
+    if( x< m->q[0]){
+        m->q[0]= x;
+        k= 0;
+    }
+    else if( x>= m->q[4]){
+        m->q[4]= x;
+        k= 3;
+    }
+    else{
+        for( k= 0; x>= m->q[k+ 1]; k++);
+    }
+    for( i= k+ 1; i< 5; i++){
+        m->n[i]++;
+    }
+    //middle markers step towards their desired positions 1+ c* dn
+    for( i= 1; i< 4; i++){
+        d= 1+ (double)c* dn[i]- (double)m->n[i];
+        if( !(d>= 1&& m->n[i+ 1]- m->n[i]> 1)&& !(d<= -1&& m->n[i- 1]- m->n[i]< -1)) continue;
+        s= d> 0? 1: -1;
+        //piecewise parabolic prediction, linear if it leaves the neighbours
+        qp= m->q[i]+ (double)s/ (double)(m->n[i+ 1]- m->n[i- 1])*
+            ((double)(m->n[i]- m->n[i- 1]+ s)* (m->q[i+ 1]- m->q[i])/ (double)(m->n[i+ 1]- m->n[i])+
+             (double)(m->n[i+ 1]- m->n[i]- s)* (m->q[i]- m->q[i- 1])/ (double)(m->n[i]- m->n[i- 1]));
+        if( !(m->q[i- 1]< qp&& qp< m->q[i+ 1])){
+            qp= m->q[i]+ (double)s* (m->q[i+ s]- m->q[i])/ (double)(m->n[i+ s]- m->n[i]);
+        }
+        m->q[i]= qp;
+        m->n[i]+= s;
+    }
+}
+//estimate of quantile p after c values, interpolated while all of them are kept
+static double p2_get( P2_markers* m, double p, size_t c){
+    double h;
+    size_t i;
+    if( c== 0) return 0;
+    if( c> 5) return m->q[2];
+    h= p* (double)(c- 1);
+    i= (size_t)h;
+    if( i+ 1>= c) return m->q[c- 1];
+    return m->q[i]+ (h- (double)i)* (m->q[i+ 1]- m->q[i]);
+}
+
+//feed the trajectory of round next, lock held
+static void ens_feed( Ens_stats* es, NINT* traj){
+    size_t k, q;
+    double v, d;
+    for( k= 0; k< es->M* es->I; k++){
+        es->sum[k]+= traj[k];
+    }
+    if( es->quant){
+        for( k= 0; k< es->M* es->I; k++){
+            v= (double)traj[k];
+            d= v- es->mean[k];
+            es->mean[k]+= d/ (double)(es->n+ 1);
+            es->m2[k]+= d* (v- es->mean[k]);
+            for( q= 0; q< ENS_QUANTILES; q++){
+                p2_add( &es->p2[k* ENS_QUANTILES+ q], ens_q[q], es->n, v);
+            }
+        }
+    }
+    es->n++;
+    es->next++;
+}
+void ens_stats_round( Ens_stats* es, size_t round, NINT* init_cnt, int** delta, NINT* traj){
+    size_t j, s, k;
+    int64_t v;
+    NINT* buf;
+    for( j= 0; j< es->M; j++){
+        v= init_cnt[j];
+        for( s= 0; s< es->I; s++){
+            v+= delta[j][s];
+            delta[j][s]= 0;
+            traj[j* es->I+ s]= (NINT)v;
+        }
+    }
+    pthread_mutex_lock( &es->lock);
+    //sums do not depend on the order, the rest is fed round by round
+    if( !es->quant|| round== es->next){
+        ens_feed( es, traj);
+        for( k= 0; k< es->wait_num; ){
+            if( es->wait_round[k]!= es->next){
+                k++;
+                continue;
+            }
+            ens_feed( es, es->wait[k]);
+            //buffer goes back to the free ones after the waiting
+            buf= es->wait[k];
+            es->wait_num--;
+            es->wait[k]= es->wait[es->wait_num];
+            es->wait_round[k]= es->wait_round[es->wait_num];
+            es->wait[es->wait_num]= buf;
+            k= 0;
+        }
+    }
+    else{
+        if( es->wait_num== es->wait_cap){
+            k= es->wait_cap;
+            es->wait_cap= k? 2* k: 8;
+            es->wait= (NINT**)realloc( es->wait, es->wait_cap* sizeof(NINT*));
+            es->wait_round= (size_t*)realloc( es->wait_round, es->wait_cap* sizeof(size_t));
+            if( es->wait== NULL|| es->wait_round== NULL){
+                printf("Memory allocation failure, size[%zu]\n", es->wait_cap* sizeof(NINT*));
+                error_exit( -1);
+            }
+            for( ; k< es->wait_cap; k++){
+                es->wait[k]= NULL;
+            }
+        }
+        if( es->wait[es->wait_num]== NULL){
+            es->wait[es->wait_num]= (NINT*)malloc1( es->M* es->I, sizeof(NINT));
+        }
+        memcpy( es->wait[es->wait_num], traj, es->M* es->I* sizeof(NINT));
+        es->wait_round[es->wait_num++]= round;
+    }
+    pthread_mutex_unlock( &es->lock);
+}
+
+int ens_stats_write( Ens_stats* es, const char* fil_nam, NINT* init_cnt, double dt){
+    FILE* fil;
+    size_t j, s, k, q;
+    double sd;
+    fil= fopen( fil_nam, "w");
+    if( fil== NULL) return -1;
+    fprintf( fil, "#time compartment rounds mean sd");
+    for( q= 0; q< ENS_QUANTILES; q++){
+        fprintf( fil, " q%g", 100* ens_q[q]);
+    }
+    fprintf( fil, "\n");
+    for( j= 0; j< es->M; j++){
+        fprintf( fil, "%lf %zu %zu %lf %lf", 0.0, j, es->n, (double)init_cnt[j], 0.0);
+        for( q= 0; q< ENS_QUANTILES; q++){
+            fprintf( fil, " %lf", (double)init_cnt[j]);
+        }
+        fprintf( fil, "\n");
+    }
+    for( s= 0; s< es->I; s++){
+        for( j= 0; j< es->M; j++){
+            k= j* es->I+ s;
+            sd= es->n> 1? sqrt( es->m2[k]/ (double)(es->n- 1)): 0;
+            fprintf( fil, "%lf %zu %zu %lf %lf", (s+ 1)* dt, j, es->n, es->n? (double)es->sum[k]/ (double)es->n: 0, sd);
+            for( q= 0; q< ENS_QUANTILES; q++){
+                fprintf( fil, " %lf", p2_get( &es->p2[k* ENS_QUANTILES+ q], ens_q[q], es->n));
+            }
+            fprintf( fil, "\n");
+        }
+    }
+    return fclose( fil)== 0? 0: -1;
+}
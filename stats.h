@@ -0,0 +1,67 @@
+#ifndef STATSH
+#define STATSH
+
+#include "common.h"
+#include <stdint.h>
+#include <pthread.h>
+/*
+ * stats.h of GEMF in C language
+ * streaming statistics of an ensemble, across rounds
+ *
+ * the population of every compartment at the end of every interval of a
+ * round is its trajectory. trajectories are summed in 64-bit integers for
+ * the ensemble mean, and with [STATS_FILE] also fed to the variance
+ * (Welford) and to P^2 estimates of ENS_QUANTILES quantiles, 5 markers
+ * each, so no trajectory is kept. workers finish rounds in any order;
+ * those ahead wait in a buffer until their turn, so the statistics are
+ * the same for any number of threads.
+ *
+ * the summary file is text, one line per interval end and compartment,
+ * the initial population first:
+ *   time compartment rounds mean sd q5 q25 q50 q75 q95
+ */
+
+#define ENS_QUANTILES 5
+
+//P^2 markers of one quantile, heights and positions from 1
+typedef struct{
+    double q[5];
+    int64_t n[5];
+} P2_markers;
+
+typedef struct Ens_stats Ens_stats;
+struct Ens_stats{
+    //compartments and intervals
+    size_t M, I;
+    //rounds fed, and the next round to feed
+    size_t n, next;
+    //M by I sums of trajectories
+    int64_t* sum;
+    //with variance and quantiles, M by I means, squared deviations and markers
+    int quant;
+    double* mean;
+    double* m2;
+    P2_markers* p2;
+    //trajectories of rounds ahead of next, and free buffers for them
+    NINT** wait;
+    size_t* wait_round;
+    size_t wait_num, wait_cap;
+    pthread_mutex_t lock;
+};
+
+//statistics of M compartments over I intervals, quant for variance and quantiles
+Ens_stats* ens_stats_init( size_t M, size_t I, int quant);
+void ens_stats_free( Ens_stats* es);
+/*
+ *add round to the statistics
+ *
+ *input:  size_t round     [ 1 ... rounds, each once]
+ *        NINT*  init_cnt  [ population of the M compartments at time 0]
+ *        int**  delta     [ M by I changes of the population in each interval, zeroed]
+ *        NINT*  traj      [ M by I buffer of the caller]
+ */
+void ens_stats_round( Ens_stats* es, size_t round, NINT* init_cnt, int** delta, NINT* traj);
+//write the summary, interval i ending at (i+1)* dt, <0 on failure
+int ens_stats_write( Ens_stats* es, const char* fil_nam, NINT* init_cnt, double dt);
+
+#endif
@@ -0,0 +1,55 @@
+#include "sumtree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*
+ * sumtree.c of GEMF in C language
+ * sum tree of node rates, see sumtree.h
+ */
+
+void sum_tree_init( Sum_tree* tree, NINT _s, NINT _e){
+    memset( tree, 0, sizeof(Sum_tree));
+    tree->_s= _s;
+    tree->_e= _e;
+    for( tree->P= 1; tree->P< _e- _s; tree->P<<= 1);
+    tree->w= (double*)calloc( 2* (size_t)tree->P, sizeof(double));
+    if( tree->w== NULL){
+        printf("malloc sum tree failed.\n");
+        error_exit( -1);
+    }
+}
+void sum_tree_free( Sum_tree* tree){
+    free( tree->w);
+    memset( tree, 0, sizeof(Sum_tree));
+}
+void sum_tree_build( Sum_tree* tree, const double* rat, double scale, const double* add){
+    double* w= tree->w;
+    size_t P= tree->P;
+    NINT n;
+    memset( w, 0, 2* P* sizeof(double));
+    for( n= tree->_s; n< tree->_e; n++){
+        w[P+ n- tree->_s]= (rat[n]> FLT_EPSILON? scale* rat[n]: 0)+ (add!= NULL? add[n]: 0);
+    }
+    sum_tree_sum( tree);
+}
+void sum_tree_sum( Sum_tree* tree){
+    double* w= tree->w;
+    size_t i;
+    for( i= tree->P- 1; i> 0; i--){
+        w[i]= w[2* i]+ w[2* i+ 1];
+    }
+}
+NINT sum_tree_sample( Sum_tree* tree, double u){
+    double* w= tree->w;
+    double x= u* w[1];
+    size_t i= 1, P= tree->P;
+    //a child of rate 0 is never taken, so rounding cannot end on a dormant leaf
+    while( i< P){
+        i<<= 1;
+        if( (x>= w[i]&& w[i+ 1]> 0)|| w[i]<= 0){
+            x-= w[i];
+            i++;
+        }
+    }
+    return (NINT)(i- P)+ tree->_s;
+}
@@ -0,0 +1,55 @@
+#ifndef SUMTREEH
+#define SUMTREEH
+
+#include "common.h"
+#include <float.h>
+/*
+ * sumtree.h of GEMF in C language
+ * sum tree of node rates, for the direct method
+ *
+ * complete binary tree over P leaves, P a power of 2 not below the number
+ * of nodes; slot 1 is the root, children of slot i are 2i and 2i+1, node
+ * n is leaf P+n-_s. an internal slot is always recomputed as the sum of
+ * its children, never adjusted by differences, so the total does not
+ * drift over long runs. rates up to FLT_EPSILON are stored as 0, as the
+ * heap treats them as dormant.
+ */
+
+typedef struct{
+    //2P slots, slot 0 unused
+    double* w;
+    NINT P;
+    //nodes start from _s, end at _e-1
+    NINT _s;
+    NINT _e;
+} Sum_tree;
+
+//allocate tree for nodes [_s, _e)
+void sum_tree_init( Sum_tree* tree, NINT _s, NINT _e);
+void sum_tree_free( Sum_tree* tree);
+//set all leaves from scale* rat[_s...e-1], plus add[_s...e-1] unless add is NULL, and sum them up
+void sum_tree_build( Sum_tree* tree, const double* rat, double scale, const double* add);
+//sum up the internal slots from leaves written in place, w[P+ n- _s] of node n
+void sum_tree_sum( Sum_tree* tree);
+//node whose cumulative rate range holds u* total, u uniform in [0,1), never a node of rate 0
+NINT sum_tree_sample( Sum_tree* tree, double u);
+
+//set rate of node n
+static inline void sum_tree_set( Sum_tree* tree, NINT n, double r){
+    double* w= tree->w;
+    size_t i= (size_t)tree->P+ (n- tree->_s);
+    w[i]= r> FLT_EPSILON? r: 0;
+    for( i>>= 1; i> 0; i>>= 1){
+        w[i]= w[2* i]+ w[2* i+ 1];
+    }
+}
+//rate of node n
+static inline double sum_tree_get( Sum_tree* tree, NINT n){
+    return tree->w[(size_t)tree->P+ (n- tree->_s)];
+}
+//total rate
+static inline double sum_tree_total( Sum_tree* tree){
+    return tree->w[1];
+}
+
+#endif
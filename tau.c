@@ -0,0 +1,449 @@
+#include "tau.h"
+#include "graph_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <pthread.h>
+/*
+ * tau.c of GEMF in C language
+ * approximate tau-leaping, see tau.h
+ *
+ * a step runs in phases, each over all workers:
+ *   draw     every worker draws the events of its nodes
+ *   (serial) the events are sorted, applied to the compartments and written
+ *   push     every worker walks the neighbours of its own events, inducer
+ *            counts of its own nodes are changed in place, the others go
+ *            to the inbox of the worker owning them
+ *   merge    every worker applies its inboxes, then recomputes the rate of
+ *            each node it touched
+ * rates are frozen within a step, so the order of the pushes does not matter.
+ */
+
+void* malloc1( size_t l, size_t s);
+void heart_beat( Heart_beat *hb);
+
+//event drawn in a step, t from the start of the step
+typedef struct{
+    double t;
+    Event evt;
+} Tau_evt;
+
+//inducer count change of node n by event evt, over the layers sharing adjacency layer
+typedef struct{
+    NINT n;
+    uint32_t layer;
+    double w;
+    Event* evt;
+} Tau_push;
+
+//growing array of items
+typedef struct{
+    void* p;
+    size_t n, cap;
+} Tau_buf;
+
+#define TAU_RATES 0
+#define TAU_DRAW 1
+#define TAU_PUSH 2
+#define TAU_MERGE 3
+#define TAU_EXIT 4
+
+typedef struct Tau_pool Tau_pool;
+//one worker, nodes [beg, end)
+typedef struct{
+    Tau_pool* pool;
+    size_t w;
+    NINT beg, end;
+    //compartments and inducer counts of the round, random stream of its own
+    Sim_state ts;
+    //change of the total rate and of nodes of positive rate by the worker
+    double R;
+    ptrdiff_t active;
+    //events drawn in the current step, Tau_evt
+    Tau_buf evt;
+    //pushes to the nodes of each worker, Tau_push, and own nodes to recompute, NINT
+    Tau_buf* inbox;
+    Tau_buf touched;
+    size_t nbr;
+} Tau_worker;
+
+struct Tau_pool{
+    Graph* graph;
+    Transition* tran;
+    Status* sts;
+    Sim_state* st;
+    size_t workers;
+    Tau_worker* wk;
+    pthread_t* tid;
+    //workers wait on start for a phase, and on done when finished
+    pthread_barrier_t start, done;
+    int phase;
+    double tau;
+    //events after this time of the step were not applied
+    double t_cut;
+};
+
+//room for one more item of size s
+static void* tau_buf_add( Tau_buf* buf, size_t s){
+    if( buf->n== buf->cap){
+        buf->cap= buf->cap? 2* buf->cap: 1024;
+        buf->p= realloc( buf->p, buf->cap* s);
+        if( buf->p== NULL){
+            printf("Memory allocation failure for tau-leaping, size[%zu]\n", buf->cap* s);
+            error_exit( -1);
+        }
+    }
+    return (char*)buf->p+ (buf->n++)* s;
+}
+
+//total rate of node n, as in get_next_evt
+static inline double tau_node_rate( Graph* graph, Transition* tran, Sim_state* st, NINT n){
+    double* row= tran->trn_table[st->init_lst[n]];
+    size_t layer, M= tran->M;
+    double r= row[M- 1];
+    for( layer= 0; layer< graph->L; layer++){
+        r+= row[(layer+ 2)*M- 1]* st->p_inducer_cal_lst[layer][n];
+    }
+    return r;
+}
+
+//recompute the rate of node n of the worker
+static inline void tau_rate( Tau_worker* wk, NINT n){
+    Tau_pool* pool= wk->pool;
+    double* rat= pool->st->p_raw_rat_lst;
+    double r= tau_node_rate( pool->graph, pool->tran, &wk->ts, n);
+    wk->active+= (r> FLT_EPSILON)- (rat[n]> FLT_EPSILON);
+    wk->R+= r- rat[n];
+    rat[n]= r;
+}
+
+//worker owning node n
+static inline size_t tau_owner( Tau_pool* pool, NINT n){
+    size_t w= (size_t)((uint64_t)(n- pool->wk[0].beg)* pool->workers/ (pool->wk[pool->workers- 1].end- pool->wk[0].beg));
+    if( w>= pool->workers) w= pool->workers- 1;
+    while( w> 0&& n< pool->wk[w].beg) w--;
+    while( n>= pool->wk[w].end) w++;
+    return w;
+}
+
+//change inducer counts of a node by push p
+static inline void tau_apply( Tau_pool* pool, Tau_push* p){
+    Graph* graph= pool->graph;
+    size_t l;
+    for( l= p->layer; l< graph->L; l++){
+        if( graph_adj( graph, l)!= p->layer) continue;
+        pool->st->p_inducer_cal_lst[l][p->n]+= inducer_change( pool->tran, p->evt, l)* p->w;
+    }
+}
+
+//one phase over the nodes of a worker
+static void tau_work( Tau_worker* wk){
+    Tau_pool* pool= wk->pool;
+    Graph* graph= pool->graph;
+    double* rat= pool->st->p_raw_rat_lst;
+    double r, p, u;
+    Tau_evt* te;
+    Tau_buf* in;
+    Tau_push push;
+    size_t e, v, layer, l, beg_num, end_num;
+    int k;
+    NINT i;
+    if( pool->phase== TAU_RATES){
+        wk->R= 0;
+        wk->active= 0;
+        for( i= wk->beg; i< wk->end; i++){
+            r= tau_node_rate( graph, pool->tran, &wk->ts, i);
+            rat[i]= r;
+            if( r> FLT_EPSILON){
+                wk->R+= r;
+                wk->active++;
+            }
+        }
+    }
+    else if( pool->phase== TAU_DRAW){
+        wk->evt.n= 0;
+        for( i= wk->beg; i< wk->end; i++){
+            r= rat[i];
+            if( r<= FLT_EPSILON) continue;
+            //fires if u< p, then -log(1-u)/r is its exponential firing time given it is within the step;
+            //p< r*tau, so most nodes are passed without expm1 when steps are short
+            p= r* pool->tau;
+            u= rng_uniform( &wk->ts.rng);
+            if( u>= p) continue;
+            p= -expm1( -p);
+            if( u>= p) continue;
+            te= (Tau_evt*)tau_buf_add( &wk->evt, sizeof(Tau_evt));
+            te->t= -log1p( -u)/ r;
+            te->evt.ns= i;
+            get_next_evt( &wk->ts, graph, pool->tran, pool->sts, &te->evt);
+        }
+    }
+    else if( pool->phase== TAU_PUSH){
+        wk->R= 0;
+        wk->active= 0;
+        wk->nbr= 0;
+        for( e= 0; e< wk->evt.n; e++){
+            te= (Tau_evt*)wk->evt.p+ e;
+            if( te->t> pool->t_cut) continue;
+            for( layer= 0; layer< graph->L; layer++){
+                if( graph_adj( graph, layer)!= layer) continue;
+                k= 0;
+                for( l= layer; l< graph->L&& !k; l++){
+                    k= graph_adj( graph, l)== layer&& inducer_change( pool->tran, &te->evt, l);
+                }
+                if( k== 0) continue;
+                beg_num= graph->offsets[layer][te->evt.ns];
+                end_num= graph->offsets[layer][te->evt.ns+1];
+                wk->nbr+= end_num- beg_num;
+                push.layer= (uint32_t)layer;
+                push.evt= &te->evt;
+                for( ; beg_num< end_num; beg_num++){
+                    push.n= graph->targets[layer][beg_num];
+                    push.w= graph->weighted? graph->weights[layer][beg_num]: 1.0;
+                    v= push.n>= wk->beg&& push.n< wk->end? wk->w: tau_owner( pool, push.n);
+                    if( v== wk->w){
+                        tau_apply( pool, &push);
+                        *(NINT*)tau_buf_add( &wk->touched, sizeof(NINT))= push.n;
+                    }
+                    else{
+                        *(Tau_push*)tau_buf_add( &wk->inbox[v], sizeof(Tau_push))= push;
+                    }
+                }
+            }
+        }
+    }
+    else if( pool->phase== TAU_MERGE){
+        //pushes of the other workers to this one
+        for( v= 0; v< pool->workers; v++){
+            in= &pool->wk[v].inbox[wk->w];
+            for( e= 0; e< in->n; e++){
+                tau_apply( pool, (Tau_push*)in->p+ e);
+                *(NINT*)tau_buf_add( &wk->touched, sizeof(NINT))= ((Tau_push*)in->p+ e)->n;
+            }
+        }
+        for( e= 0; e< wk->touched.n; e++){
+            tau_rate( wk, ((NINT*)wk->touched.p)[e]);
+        }
+        wk->touched.n= 0;
+        //the nodes that fired, events not applied left them as they were
+        for( e= 0; e< wk->evt.n; e++){
+            tau_rate( wk, ((Tau_evt*)wk->evt.p+ e)->evt.ns);
+        }
+    }
+}
+
+static void* tau_worker( void* arg){
+    Tau_worker* wk= (Tau_worker*)arg;
+    Tau_pool* pool= wk->pool;
+    while( 1){
+        pthread_barrier_wait( &pool->start);
+        if( pool->phase== TAU_EXIT) break;
+        tau_work( wk);
+        pthread_barrier_wait( &pool->done);
+    }
+    return NULL;
+}
+
+//run a phase on all workers, the calling thread is worker 0
+static void tau_phase( Tau_pool* pool, int phase){
+    pool->phase= phase;
+    if( pool->workers> 1) pthread_barrier_wait( &pool->start);
+    if( phase== TAU_EXIT) return;
+    tau_work( &pool->wk[0]);
+    if( pool->workers> 1) pthread_barrier_wait( &pool->done);
+}
+
+static int tau_evt_cmp( const void* a, const void* b){
+    double ta= ((const Tau_evt*)a)->t, tb= ((const Tau_evt*)b)->t;
+    return ta< tb? -1: ta> tb;
+}
+
+int tau_round( Graph* graph, Transition* tran, Status* sts, Run* run, Sim_state* st, size_t round, Out_stream* out, Heart_beat* hb){
+    Tau_pool pool;
+    Tau_worker* wk;
+    Tau_evt* all= NULL;
+    Event* evt;
+    size_t w, v, n, e, cap= 0, active= 0, layer, deg;
+    double t= 0, last_t= 0, tau, ev_t;
+    NINT nodes= graph->_e- graph->_s;
+    int k, ret= 0, stop= 0, last, fill= 0, end= END_TIME;
+    LINE msg;
+
+    LOG(1, __FILE__, __LINE__, "Start tau-leaping round [%zu/%zu]\n", round, run->sim_rounds);
+    st->count= 0;
+    st->t0= gettimenow();
+    grid_begin( run, sts, st, 0, 1, out);
+    //workers over node ranges for a single round, ensemble rounds have a worker each already
+    memset( &pool, 0, sizeof(Tau_pool));
+    pool.graph= graph;
+    pool.tran= tran;
+    pool.sts= sts;
+    pool.st= st;
+    pool.workers= run->sim_rounds<= 1&& run->threads> 1? run->threads: 1;
+    if( pool.workers> nodes) pool.workers= nodes> 0? nodes: 1;
+    pool.wk= wk= (Tau_worker*)calloc( pool.workers, sizeof(Tau_worker));
+    pool.tid= (pthread_t*)malloc1( pool.workers, sizeof(pthread_t));
+    if( wk== NULL){
+        printf("Memory allocation failure for tau-leaping workers\n");
+        error_exit( -1);
+    }
+    for( w= 0; w< pool.workers; w++){
+        wk[w].pool= &pool;
+        wk[w].w= w;
+        wk[w].beg= graph->_s+ (NINT)((uint64_t)nodes* w/ pool.workers);
+        wk[w].end= graph->_s+ (NINT)((uint64_t)nodes* (w+ 1)/ pool.workers);
+        wk[w].ts.init_lst= st->init_lst;
+        wk[w].ts.p_inducer_cal_lst= st->p_inducer_cal_lst;
+        wk[w].inbox= (Tau_buf*)calloc( pool.workers, sizeof(Tau_buf));
+        if( wk[w].inbox== NULL){
+            printf("Memory allocation failure for tau-leaping workers\n");
+            error_exit( -1);
+        }
+        rng_split( &st->rng, &wk[w].ts.rng);
+    }
+    if( pool.workers> 1){
+        pthread_barrier_init( &pool.start, NULL, (unsigned)pool.workers);
+        pthread_barrier_init( &pool.done, NULL, (unsigned)pool.workers);
+        for( w= 1; w< pool.workers; w++){
+            if( pthread_create( &pool.tid[w], NULL, tau_worker, &wk[w])){
+                printf("create tau-leaping worker[%zu] failed\n", w);
+                error_exit( -1);
+            }
+        }
+    }
+
+    //rates of all nodes once, then kept up to date after each step
+    tau_phase( &pool, TAU_RATES);
+    st->R= 0;
+    for( w= 0; w< pool.workers; w++){
+        st->R+= wk[w].R;
+        active+= (size_t)wk[w].active;
+    }
+    while( 1){
+        if( t>= run->max_time){
+            sprintf(msg, "T [%.6g] \treach limit [%6g], stop at [%zu] events.\t", t, run->max_time, st->count);
+            fill= 1;
+            break;
+        }
+        else if( st->count>= run->max_events){
+            sprintf(msg, "N [%zu] \treach limit [%zu], stop.\t", st->count, run->max_events);
+            end= END_EVENTS;
+            break;
+        }
+        else if( active== 0){
+            sprintf(msg, "no more events, stop at [%zu] events.\t", st->count);
+            fill= 1;
+            end= END_EMPTY;
+            break;
+        }
+        tau= run->tau_leap== TAU_FIXED? run->tau: run->tau* (double)active/ st->R;
+        //last step ends at max_time
+        last= t+ tau>= run->max_time;
+        if( last){
+            tau= run->max_time- t;
+        }
+        pool.tau= tau;
+        tau_phase( &pool, TAU_DRAW);
+
+        //events of all workers in time order
+        n= 0;
+        for( w= 0; w< pool.workers; w++) n+= wk[w].evt.n;
+        if( n> cap){
+            cap= n;
+            all= (Tau_evt*)realloc( all, cap* sizeof(Tau_evt));
+            if( all== NULL){
+                printf("Memory allocation failure for tau-leaping events, size[%zu]\n", cap* sizeof(Tau_evt));
+                error_exit( -1);
+            }
+        }
+        for( w= 0, n= 0; w< pool.workers; w++){
+            if( wk[w].evt.n> 0) memcpy( all+ n, wk[w].evt.p, wk[w].evt.n* sizeof(Tau_evt));
+            n+= wk[w].evt.n;
+        }
+        qsort( all, n, sizeof(Tau_evt), tau_evt_cmp);
+
+        pool.t_cut= tau;
+        for( e= 0; e< n; e++){
+            evt= &all[e].evt;
+            ev_t= t+ all[e].t;
+            //events from here on are dropped, rounding may put one at the end of the last step
+            if( ev_t>= run->max_time|| st->count>= run->max_events){
+                pool.t_cut= e> 0? all[e- 1].t: -1.0;
+                break;
+            }
+            st->count++;
+            st->total++;
+            st->init_lst[evt->ns]= evt->nj;
+            st->init_cnt[evt->ni] --;
+            st->init_cnt[evt->nj] ++;
+            last_t= ev_t;
+            k= sim_event_out( graph, tran, sts, run, st, ev_t, evt, out);
+            if( k!= 0){
+                ret= k< 0? -1: 0;
+                stop= 1;
+                break;
+            }
+            deg= 0;
+            for( layer= 0; layer< graph->L; layer++){
+                if( graph_adj( graph, layer)!= layer) continue;
+                deg+= graph->offsets[layer][evt->ns+ 1]- graph->offsets[layer][evt->ns];
+            }
+            st->perf.deg_hist[perf_deg_bucket( deg)]++;
+            if( hb!= NULL){
+                heart_beat(hb);
+            }
+        }
+        if( stop){
+            sprintf(msg, "N [%zu] \tstopped by event callback.\t", st->count);
+            end= END_HOOK;
+            break;
+        }
+        //inducer counts and rates of the neighbours
+        tau_phase( &pool, TAU_PUSH);
+        tau_phase( &pool, TAU_MERGE);
+        for( w= 0; w< pool.workers; w++){
+            st->R+= wk[w].R;
+            active+= wk[w].active;
+            st->perf.neighbor_updates+= wk[w].nbr;
+            for( v= 0; v< pool.workers; v++) wk[w].inbox[v].n= 0;
+        }
+        t= last? run->max_time: t+ tau;
+        //conditions are looked at once per step, with the rates of the next one
+        if( run->stop_num> 0&& (k= stop_check( run, st, NULL))!= 0){
+            sprintf(msg, "T [%.6g] \t[STOP_WHEN] %s met, stop at [%zu] events.\t", t, perf_end_nam[k], st->count);
+            end= k;
+            break;
+        }
+    }
+    st->elapse_tim= last_t;
+    if( fill){
+        grid_end( run, sts, st, out);
+    }
+    st->end= end;
+    st->perf.ends[end]++;
+    tau_phase( &pool, TAU_EXIT);
+    for( w= 1; w< pool.workers; w++){
+        pthread_join( pool.tid[w], NULL);
+    }
+    if( pool.workers> 1){
+        pthread_barrier_destroy( &pool.start);
+        pthread_barrier_destroy( &pool.done);
+    }
+    for( w= 0; w< pool.workers; w++){
+        for( v= 0; v< pool.workers; v++) free( wk[w].inbox[v].p);
+        free( wk[w].inbox);
+        free( wk[w].evt.p);
+        free( wk[w].touched.p);
+    }
+    free( wk);
+    free( pool.tid);
+    free( all);
+    st->perf.rounds++;
+    if( !run->quiet){
+        printf("%sstop tau-leaping round [%zu/%zu]\n", msg, round, run->sim_rounds);
+    }
+    LOG(1, __FILE__, __LINE__, "End tau-leaping round [%zu/%zu]\n", round, run->sim_rounds);
+    return ret;
+}
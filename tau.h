@@ -0,0 +1,32 @@
+#ifndef TAUH
+#define TAUH
+
+#include "nrm.h"
+/*
+ * tau.h of GEMF in C language
+ * approximate tau-leaping, an alternative to the next reaction method
+ *
+ * time advances in steps of length tau. at the start of a step the rate of
+ * every node is computed from its compartment and inducer counts, then each
+ * node fires with probability 1- exp(-rate* tau), a Bernoulli draw since a
+ * node holds a single individual, at the exact time of its first firing
+ * given it fires within the step, and its transition is drawn as in the
+ * exact method. the events of a step are applied and written in time order
+ * and the inducer counts of their neighbours updated; rates only change at
+ * the next step, and a node fires at most once per step, that is the error.
+ *
+ *   TAU_FIXED     tau is the given step
+ *   TAU_ADAPTIVE  tau= epsilon* active/ R, active the nodes of positive rate
+ *                 and R their total rate, so a node fires with probability
+ *                 about epsilon per step; smaller epsilon is closer to exact
+ *
+ * rates and draws of a single round are spread over [THREADS] workers by
+ * node ranges, each with a random stream of its own, so results depend on
+ * the seed and the number of threads; ensemble rounds run one per worker.
+ * the total rate written with each event is the one of its step.
+ */
+
+//simulate one round by tau-leaping, same arguments and output as sim_round
+int tau_round( Graph* graph, Transition* tran, Status* sts, Run* run, Sim_state* st, size_t round, Out_stream* out, Heart_beat* hb);
+
+#endif
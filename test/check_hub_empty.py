@@ -0,0 +1,66 @@
+#! /usr/bin/env python3
+'''
+Regression check of [HUB_THRESHOLD] with [SCHEDULER] rejection: an SIR round on a
+Barabasi-Albert network must end as "no more events" once the epidemic is over, with
+the same events and rejections for any [MAX_TIME], and must not run until MAX_TIME
+when it is effectively unbounded. Run through "make check".
+'''
+
+# imports
+from os.path import abspath, dirname
+from subprocess import check_call, check_output, DEVNULL, TimeoutExpired
+from tempfile import mkdtemp
+import json
+import sys
+
+# useful variables
+ROOT = abspath('%s/..' % dirname(abspath(__file__)))
+sys.path.insert(0, '%s/bench' % ROOT)
+from bench import GEN_NET, MODELS, matrix
+GEMF = '%s/GEMF' % ROOT
+NODES = 2000; THRESHOLD = 30; SEED = 1
+
+def run(work, network_fn, nodes, edges, status_fn, max_time):
+    '''
+    Report of one SIR round stopped at max_time
+    '''
+    M, nodal, edged, inducer, _ = MODELS['sir']
+    para_fn = '%s/para.txt' % work; report_fn = '%s/report.json' % work
+    with open(para_fn, 'w') as f:
+        f.write('[NODAL_TRAN_MATRIX]\n%s\n\n' % matrix(M, nodal))
+        f.write('[EDGED_TRAN_MATRIX]\n%s\n\n' % matrix(M, edged))
+        f.write('[STATUS_BEGIN]\n0\n\n[INDUCER_LIST]\n%d\n\n' % inducer)
+        f.write('[SIM_ROUNDS]\n1\n\n[INTERVAL_NUM]\n1\n\n[MAX_TIME]\n%g\n\n[MAX_EVENTS]\n%d\n\n' % (max_time, 100 * nodes))
+        f.write('[DIRECTED]\n0\n\n[SHOW_INDUCER]\n0\n\n')
+        f.write('[DATA_FILE]\n%s\n\n[NETWORK_INFO]\n0\n1 %d\n%d\n\n' % (network_fn, nodes, edges))
+        f.write('[STATUS_FILE]\n%s\n\n[RANDOM_SEED]\n%d\n\n' % (status_fn, SEED))
+        f.write('[SCHEDULER]\nrejection\n\n[HUB_THRESHOLD]\n%d\n\n' % THRESHOLD)
+        f.write('[OUT_FILE]\n%s/output.txt\n\n[REPORT_FILE]\n%s\n' % (work, report_fn))
+    check_call([GEMF, para_fn], stdout=DEVNULL, timeout=120)
+    return json.load(open(report_fn))
+
+def main():
+    work = mkdtemp()
+    network_fn = '%s/ba.txt' % work; status_fn = '%s/status.txt' % work
+    parts = check_output([GEN_NET, 'ba', str(NODES), network_fn, '3', str(SEED)]).decode().split()
+    nodes, edges = int(parts[1]), int(parts[3])
+    check_call([GEN_NET, 'status', str(nodes), '0.01', str(MODELS['sir'][4]), status_fn, str(SEED)])
+    seen = None; failed = False
+    for max_time in [50, 500, 1e9]:
+        try:
+            rep = run(work, network_fn, nodes, edges, status_fn, max_time)
+        except TimeoutExpired:
+            print('FAIL max_time %g: round did not end' % max_time); failed = True; continue
+        got = (rep['events'], rep['rejections'])
+        print('max_time %g: events %d, rejections %d, ends %s' % (max_time, got[0], got[1], rep['round_ends']))
+        if rep['round_ends']['no_events'] != 1:
+            print('FAIL max_time %g: round did not end with no more events' % max_time); failed = True
+        if seen is not None and got != seen:
+            print('FAIL max_time %g: events or rejections depend on MAX_TIME' % max_time); failed = True
+        seen = got
+    print('FAIL' if failed else 'OK')
+    sys.exit(1 if failed else 0)
+
+# execute main function
+if __name__ == "__main__":
+    main()